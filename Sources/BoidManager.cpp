@@ -1,58 +1,99 @@
 #include "pch.h"
 #include "BoidManager.h"
 #include "MathHelper.h"
+#include "FrameworkInstancedRenderContext.h"
 #include "Game.h"
+#include "SharedState.h"
+#include "SimulationState.h"
+#include <iostream>
 
 namespace 
 {
-    constexpr float STEERING_UPDATE_INTERVAL = 0.0f;
-    constexpr float STEERING_UPDATE_INTERVAL_INCREMENT = 0.015f;
-    constexpr float STEERING_UPDATE_INTERVAL_DECREMENT = 0.0075f;
-    constexpr float BOID_RADIUS = 0.6f;
-    constexpr float BOID_HASH_GRID_CELL_SIZE = 6.0f;
+    constexpr float STEERING_BUDGET_MILLISECONDS = 4.0f;
+    constexpr float STEERING_BUDGET_INCREMENT = 0.5f;
+    constexpr float STEERING_BUDGET_DECREMENT = 0.5f;
     constexpr Vector3 BOUNDS_SIZE = Vector3(45.0f, 35.0f, 45.0f);
     constexpr int BOID_INCREMENT_COUNT = 500;
     constexpr int BOID_DECREMENT_COUNT = 250;
+    constexpr size_t BOID_COMMANDS_PER_STEP = 1 << 14;
+    constexpr int FLOCKS_COUNT = 2;
+    constexpr XMVECTORF32 FIRST_FLOCK_COLORS[] = { { 1.0f, 1.0f, 0.0f, 1.0f }, { 0.75f, 0.75f, 0.0f, 1.0f } }; // Shades of yellow
+    constexpr float FIRST_FLOCK_HUE = 60.0f; // Yellow
+    constexpr float FLOCKING_ERROR_SAMPLE_INTERVAL = 0.5f;
+    constexpr int FLOCKING_ERROR_SAMPLE_COUNT = 64;
+    constexpr float OUT_OF_BOUNDS_MARGIN = 0.25f; // Boids can leave the bounds a bit before being pushed back
+    constexpr double MAX_RESERVED_CELLS = 1 << 16; // Only occupied cells are stored, past that reserving just wastes buckets
 
+    // Cells the bounds overlap, boids only leave the bounds by a little before being pushed back
+    size_t GetBoundsCellsCount(const Bounds& bounds, float cellSize)
+    {
+        // In double and clamped before converting, a tiny cell size would overflow size_t
+        const auto cellsAlong = [cellSize](float size) { return std::ceil(static_cast<double>(size) / cellSize) + 1.0; };
+        const double cellsCount = cellsAlong(bounds.size.x) * cellsAlong(bounds.size.y) * cellsAlong(bounds.size.z);
+        return static_cast<size_t>(std::min(cellsCount, MAX_RESERVED_CELLS));
+    }
+
+    // Gathers one boid field into its SoA section, filled right away since writer memory can move on the next allocation
+    template <typename T, typename Getter>
+    void WriteBoidArray(SimulationStateWriter& writer, SimulationStateSection section, const std::vector<Boid*>& boids, Getter getter)
+    {
+        T* data = writer.Allocate<T>(section, boids.size());
+        for (size_t i = 0; i < boids.size(); i++)
+        {
+            data[i] = getter(*boids[i]);
+        }
+    }
 }
 
-Boid::Boid(uint8_t flockID, Vector3 velocity, Vector3 position, Vector3 size)
-    : MovingEntity(position, size, velocity)
+Boid::Boid(uint32_t id, FlockID flockID, Vector3 velocity, Vector3 position)
+    : id(id)
     , flockID(flockID)
+    , steeringStaleness(std::numeric_limits<float>::max()) // Never steered, so it goes first
+    , m_acceleration(Vector3::Zero)
+    , m_cellIndex(0, 0, 0)
+    , m_isPendingDestroy(false)
 {
+    SetPosition(position);
+    SetVelocity(velocity);
 }
 
 BoidManager::BoidManager(const Game& game)
     : m_game(game)
     , m_boidsAmount(1000)
-    , m_flocksCount(2)
-    , m_boidMaxSpeed(10.5f)
-    , m_boidMinSpeed(6.5f)
-    , m_boidAccelerationMultiplier(50.0f)
-    , m_steeringUpdateTimer(0.0f)
-    , m_steeringUpdateInterval(STEERING_UPDATE_INTERVAL)
+    , m_nextBoidID(0)
+    , m_removedBelowID(0)
+    , m_flocksCount(FLOCKS_COUNT)
+    , m_boidMaxSpeed(DEFAULT_SIMULATION_PARAMETERS.boidMaxSpeed)
+    , m_boidMinSpeed(DEFAULT_SIMULATION_PARAMETERS.boidMinSpeed)
+    , m_boidAccelerationMultiplier(DEFAULT_SIMULATION_PARAMETERS.boidAccelerationMultiplier)
+    , m_flockingErrorTimer(0.0f)
+    , m_flockingAggregateError(0.0f)
+    , m_simulationTime(0.0f)
     , m_boidSteeringController(*this, game)
-    , m_boidsHashGrid(BOID_HASH_GRID_CELL_SIZE)
+    , m_boidSteeringScheduler(game, STEERING_BUDGET_MILLISECONDS)
+    , m_boidsHashGrid(DEFAULT_SIMULATION_PARAMETERS.hashGridCellSize)
     , m_spawnKeyPressedLastFrame(false)
     , m_despawnKeyPressedLastFrame(false)
     , m_increaseKeyPressedLastFrame(false)
     , m_decreaseKeyPressedLastFrame(false)
+    , m_flockingModeKeyPressedLastFrame(false)
+    , m_recordKeyPressedLastFrame(false)
+    , m_backendKeyPressedLastFrame(false)
+    , m_simulationBackend(SimulationBackend::Create(SimulationBackendType::Reference))
+    , m_droppedCommandsCount(0)
 {
     // Probably Shouldn't have this tight coupling, consider Game class as a mediator or some Event Manager
     Projectile::OnDestroy = [this](Vector3 position, Vector3 velocity)
     {
-        SpawnBoidAtPosition(position, velocity, MathHelper::RandomFromRange(0, m_flocksCount - 1));
+        RequestSpawnBoid(position, velocity);
     };
 
     m_bounds = Bounds(Vector3::Up * BOUNDS_SIZE.y / 2.0f, BOUNDS_SIZE);
 
-    m_flockColors.reserve(m_flocksCount);
-    for (int i = 0; i < m_flocksCount; i++)
-    {
-        const float intensity = 1.0f - (static_cast<float>(i) / static_cast<float>(m_flocksCount));
-        const float remapped_intensity = MathHelper::GetProportional(0.0f, 1.0f, intensity, 0.5f, 1.0f);
-        m_flockColors.push_back({ remapped_intensity, remapped_intensity, 0.0f, 1.0f });
-    }
+    const Vector3 quantizationMargin = m_bounds.size * OUT_OF_BOUNDS_MARGIN;
+    BoidQuantization::SetFrame(m_bounds.min - quantizationMargin, m_bounds.size + quantizationMargin * 2.0f);
+
+    BuildFlockColors();
 }
 
 BoidManager::~BoidManager()
@@ -67,13 +108,46 @@ void BoidManager::OnInitialize()
 {
     m_boidShape.reset();
     m_simulationBoundsShape.reset();
-    m_boidShape = GetEngine().CreateSpherePrimitive(BOID_RADIUS);
+    m_boidShape = GetEngine().CreateSpherePrimitive(Boid::RADIUS);
     m_simulationBoundsShape = GetEngine().CreateBoxPrimitive(m_bounds.size);
 
     m_boids.reserve(m_boidsAmount * 2);
+    m_boidPool.Reserve(m_boidsAmount * 2);
+    m_boidsHashGrid.ReserveCells(GetBoundsCellsCount(m_bounds, m_boidsHashGrid.GetCellSize()));
     SpawnBoids(m_boidsAmount);
 }
 
+void BoidManager::SetFlocksCount(int flocksCount)
+{
+    assert(flocksCount > 0 && flocksCount <= MAX_FLOCKS_COUNT);
+
+    // Boids of flocks that no longer exist would index past the colors and render batches
+    ClearBoids();
+    m_flocksCount = flocksCount;
+    BuildFlockColors();
+}
+
+void BoidManager::BuildFlockColors()
+{
+    // The first flocks keep their original colors, the others are spread over the rest of the hue wheel
+    const int firstFlockColorsCount = static_cast<int>(std::size(FIRST_FLOCK_COLORS));
+
+    m_flockColors.clear();
+    m_flockColors.reserve(m_flocksCount);
+    for (int i = 0; i < m_flocksCount; i++)
+    {
+        if (i < firstFlockColorsCount)
+        {
+            m_flockColors.push_back(FIRST_FLOCK_COLORS[i]);
+            continue;
+        }
+
+        const float hue = FIRST_FLOCK_HUE + 360.0f * static_cast<float>(i - 1) / static_cast<float>(m_flocksCount - 1);
+        const Vector3 rgb = MathHelper::HueToRGB(hue);
+        m_flockColors.push_back({ rgb.x, rgb.y, rgb.z, 1.0f });
+    }
+}
+
 void BoidManager::SpawnBoids(int amount)
 {
     static constexpr float BOID_MIN_BOUNDS_Y_FACTOR = 0.5f;
@@ -82,12 +156,30 @@ void BoidManager::SpawnBoids(int amount)
     for(int i = 0; i < amount; i++)
     {
         const Vector3 random_position = Vector3(m_bounds.size.x * MathHelper::RandomValue(), m_bounds.size.y * std::max(BOID_MIN_BOUNDS_Y_FACTOR, MathHelper::RandomValue()), m_bounds.size.z * MathHelper::RandomValue()) - bounds_offset;
-        SpawnBoidAtPosition(random_position, MathHelper::RandomDirection(), m_flocksCount > 1 ? static_cast<uint8_t>(i % m_flocksCount) : 0);
+        SpawnBoidAtPosition(random_position, MathHelper::RandomDirection(), m_flocksCount > 1 ? static_cast<FlockID>(i % m_flocksCount) : 0);
     }
 }
 
-void BoidManager::RemoveBoids(int amount) const
+void BoidManager::RemoveBoids(int amount)
 {
+    // Processes of a distributed run each own some of the boids, but they all agree on the ids handed out so far. Moving one shared
+    // id cutoff picks the same boids everywhere, and each process destroys only the ones it owns
+    if (m_spawnFilter)
+    {
+        m_removedBelowID = static_cast<uint32_t>(std::min<uint64_t>(static_cast<uint64_t>(m_removedBelowID) + std::max(amount, 0), m_nextBoidID));
+        for (Boid* boid : m_boids)
+        {
+            if (boid->id >= m_removedBelowID)
+            {
+                break;
+            }
+
+            boid->Destroy();
+        }
+
+        return;
+    }
+
     const int amount_to_destroy = std::min<int>(m_boids.size() , amount);
     for(int i = 0; i < amount_to_destroy; i++)
     {
@@ -95,125 +187,598 @@ void BoidManager::RemoveBoids(int amount) const
     }
 }
 
-void BoidManager::SpawnBoidAtPosition(Vector3 position, Vector3 velocity, uint8_t team_id)
+void BoidManager::ClearBoids()
+{
+    m_boids.clear();
+    m_ghostBoids.clear();
+    m_boidPool.Clear();
+    m_boidsHashGrid.Clear();
+    m_boidSteeringController.GetNeighborCache().Invalidate();
+    m_removedBelowID = m_nextBoidID;
+    DiscardPendingCommands();
+}
+
+void BoidManager::ApplyParameters(const SimulationParameters& parameters)
+{
+    m_boidMinSpeed = parameters.boidMinSpeed;
+    m_boidMaxSpeed = parameters.boidMaxSpeed;
+    m_boidAccelerationMultiplier = parameters.boidAccelerationMultiplier;
+    m_boidSteeringController.ApplyParameters(parameters);
+
+    if (parameters.hashGridCellSize != m_boidsHashGrid.GetCellSize())
+    {
+        RebuildHashGrid(parameters.hashGridCellSize);
+    }
+}
+
+void BoidManager::RebuildHashGrid(float cellSize)
+{
+    // Aggregates are rebuilt by AddEntity as long as they stay enabled
+    m_boidsHashGrid.SetCellSize(cellSize);
+    m_boidsHashGrid.ReserveCells(GetBoundsCellsCount(m_bounds, cellSize));
+
+    for (const std::vector<Boid*>* boids : { &m_boids, &m_ghostBoids })
+    {
+        for (Boid* boid : *boids)
+        {
+            m_boidsHashGrid.AddEntity(boid);
+        }
+    }
+
+    m_boidSteeringController.GetNeighborCache().Invalidate();
+}
+
+bool BoidManager::RequestSpawnBoid(Vector3 position, Vector3 velocity, FlockID flockID)
+{
+    BoidCommand command;
+    command.type = BoidCommandType::Spawn;
+    command.flockID = flockID;
+    command.position = position;
+    command.velocity = velocity;
+    return RequestCommand(command);
+}
+
+bool BoidManager::RequestSpawnBoids(int amount)
+{
+    BoidCommand command;
+    command.type = BoidCommandType::SpawnRandom;
+    command.count = static_cast<uint32_t>(std::max(amount, 0));
+    return RequestCommand(command);
+}
+
+bool BoidManager::RequestRemoveBoids(int amount)
+{
+    BoidCommand command;
+    command.type = BoidCommandType::Remove;
+    command.count = static_cast<uint32_t>(std::max(amount, 0));
+    return RequestCommand(command);
+}
+
+bool BoidManager::RequestCommand(const BoidCommand& command)
+{
+    if (m_pendingCommands.Push(command))
+    {
+        return true;
+    }
+
+    m_droppedCommandsCount.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void BoidManager::ApplyPendingCommands()
+{
+    // Random draws only happen here, on the simulation thread, so the random sequence doesn't depend on which thread asked.
+    // Commands queued while applying wait for the next step
+    BoidCommand command;
+    for (size_t i = 0; i < BOID_COMMANDS_PER_STEP && m_pendingCommands.Pop(command); i++)
+    {
+        switch (command.type)
+        {
+        case BoidCommandType::Spawn:
+        {
+            const FlockID flockID = command.flockID < m_flocksCount ? command.flockID : static_cast<FlockID>(MathHelper::RandomFromRange(0, m_flocksCount - 1));
+            SpawnBoidAtPosition(command.position, command.velocity, flockID);
+            break;
+        }
+        case BoidCommandType::SpawnRandom:
+            SpawnBoids(static_cast<int>(command.count));
+            break;
+        case BoidCommandType::Remove:
+            RemoveBoids(static_cast<int>(command.count));
+            break;
+        }
+    }
+
+    // After the commands, so boids removed by them or eaten by projectiles this step leave the grid before the next one is steered
+    RemovePendingBoids();
+}
+
+void BoidManager::DiscardPendingCommands()
+{
+    BoidCommand command;
+    while (m_pendingCommands.Pop(command))
+    {
+    }
+}
+
+void BoidManager::SpawnBoidAtPosition(Vector3 position, Vector3 velocity, FlockID team_id)
 {
     assert(team_id < m_flocksCount);
-    m_boids.push_back(std::make_unique<Boid>(team_id, velocity, position, Vector3::One * (BOID_RADIUS * 2.0f)));
-    m_boidsHashGrid.AddEntity(m_boids.back().get());
+
+    // Taken even by a filtered out spawn, so ids stay the same in every process of a distributed run
+    const uint32_t id = m_nextBoidID++;
+    if (m_spawnFilter && !m_spawnFilter(position))
+    {
+        return;
+    }
+
+    m_boids.push_back(AddBoid(id, position, velocity, team_id));
 }
 
-void BoidManager::OnUpdate(float deltaTime, DirectX::Keyboard& keyboard)
+Boid* BoidManager::AddBoid(uint32_t id, Vector3 position, Vector3 velocity, FlockID flockID)
 {
-    UpdateBoids(deltaTime);
+    Boid* boid = m_boidPool.Create(id, flockID, velocity, position);
+    m_boidsHashGrid.AddEntity(boid);
+    m_boidSteeringController.GetNeighborCache().OnBoidAdded(boid->GetPosition(), m_boidsHashGrid, m_boidPool);
+    return boid;
+}
+
+void BoidManager::CollectBoids(const BoidPredicate& predicate, std::vector<BoidRecord>& collected) const
+{
+    for (const Boid* boid : m_boids)
+    {
+        if (predicate(*boid))
+        {
+            collected.push_back(BoidRecord{ boid->id, boid->GetPosition(), boid->GetVelocity(), boid->flockID });
+        }
+    }
+}
+
+void BoidManager::ExtractBoids(const BoidPredicate& predicate, std::vector<BoidRecord>& extracted)
+{
+    for (Boid* boid : m_boids)
+    {
+        if (!boid->IsPendingDestroy() && predicate(*boid))
+        {
+            extracted.push_back(BoidRecord{ boid->id, boid->GetPosition(), boid->GetVelocity(), boid->flockID });
+            boid->Destroy();
+        }
+    }
+
     RemovePendingBoids();
-    OnInput(keyboard);
 }
 
-void BoidManager::OnInput(DirectX::Keyboard& keyboard)
+void BoidManager::AddBoids(const std::vector<BoidRecord>& records)
 {
+    // Migrants keep the ids they were spawned with, merged in so m_boids stays sorted by id
+    const auto byID = [](const Boid* first, const Boid* second) { return first->id < second->id; };
+    const size_t previousCount = m_boids.size();
+
+    for (const BoidRecord& record : records)
+    {
+        assert(record.flockID < m_flocksCount);
+        m_boids.push_back(AddBoid(record.id, record.position, record.velocity, record.flockID));
+    }
+
+    std::sort(m_boids.begin() + previousCount, m_boids.end(), byID);
+    std::inplace_merge(m_boids.begin(), m_boids.begin() + previousCount, m_boids.end(), byID);
+}
+
+void BoidManager::SetGhostBoids(const std::vector<BoidRecord>& records)
+{
+    for (Boid* ghost : m_ghostBoids)
+    {
+        m_boidsHashGrid.RemoveEntity(ghost);
+        m_boidPool.Destroy(ghost);
+    }
+
+    m_ghostBoids.clear();
+
+    // Ghosts never enter m_boids, their id only marks them as ghosts
+    for (const BoidRecord& record : records)
+    {
+        m_ghostBoids.push_back(m_boidPool.Create(Boid::GHOST_ID, record.flockID, record.velocity, record.position));
+        m_boidsHashGrid.AddEntity(m_ghostBoids.back());
+        m_boidSteeringController.GetNeighborCache().OnBoidAdded(m_ghostBoids.back()->GetPosition(), m_boidsHashGrid, m_boidPool);
+    }
+}
 
-    auto keyboardState = keyboard.GetState();
+void BoidManager::OnUpdate(float deltaTime, const DirectX::Keyboard::State& keyboardState)
+{
+    m_simulationTime += deltaTime;
+    UpdateBoids(deltaTime);
+    RecordTrajectoryFrame();
+    UpdateFlockingErrorMetric(deltaTime);
+    OnInput(keyboardState);
+}
 
+void BoidManager::OnInput(const DirectX::Keyboard::State& keyboardState)
+{
     // Should probably create some simple InputManager / InputWrapper to detect click release, tap etc
     if (m_spawnKeyPressedLastFrame && !keyboardState.P)
     {
-        SpawnBoids(BOID_INCREMENT_COUNT);
+        RequestSpawnBoids(BOID_INCREMENT_COUNT);
     }
     else if (m_despawnKeyPressedLastFrame && !keyboardState.O)
     {
-        RemoveBoids(BOID_DECREMENT_COUNT);
+        RequestRemoveBoids(BOID_DECREMENT_COUNT);
     }
     else if(m_increaseKeyPressedLastFrame && !keyboardState.L)
     {
-        m_steeringUpdateInterval += STEERING_UPDATE_INTERVAL_INCREMENT;
+        m_boidSteeringScheduler.SetBudget(m_boidSteeringScheduler.GetBudget() + STEERING_BUDGET_INCREMENT);
     }
     else if (m_decreaseKeyPressedLastFrame && !keyboardState.K)
     {
-        m_steeringUpdateInterval -= STEERING_UPDATE_INTERVAL_DECREMENT;
-        m_steeringUpdateInterval = std::max(0.0f, m_steeringUpdateInterval);
+        m_boidSteeringScheduler.SetBudget(m_boidSteeringScheduler.GetBudget() - STEERING_BUDGET_DECREMENT);
+    }
+    else if (m_flockingModeKeyPressedLastFrame && !keyboardState.M)
+    {
+        ToggleFlockingMode();
+    }
+    else if (m_recordKeyPressedLastFrame && !keyboardState.F6)
+    {
+        ToggleTrajectoryRecording();
+    }
+    else if (m_backendKeyPressedLastFrame && !keyboardState.B)
+    {
+        const int nextType = (static_cast<int>(GetSimulationBackendType()) + 1) % static_cast<int>(SimulationBackendType::Count);
+        SetSimulationBackend(static_cast<SimulationBackendType>(nextType));
     }
 
     m_spawnKeyPressedLastFrame = keyboardState.P;
     m_despawnKeyPressedLastFrame = keyboardState.O;
     m_increaseKeyPressedLastFrame= keyboardState.L;
     m_decreaseKeyPressedLastFrame = keyboardState.K;
+    m_flockingModeKeyPressedLastFrame = keyboardState.M;
+    m_recordKeyPressedLastFrame = keyboardState.F6;
+    m_backendKeyPressedLastFrame = keyboardState.B;
 }
 
-void BoidManager::UpdateBoids(float deltaTime)
+void BoidManager::SetSimulationBackend(SimulationBackendType type)
 {
-    m_steeringUpdateTimer -= deltaTime;
-    bool canUpdateSteering = m_steeringUpdateTimer < 0.0f;
+    // Backends keep no simulation state of their own, so switching between two steps is seamless
+    if (!m_simulationBackend || m_simulationBackend->GetType() != type)
+    {
+        m_simulationBackend = SimulationBackend::Create(type);
+    }
+}
 
-    for (std::unique_ptr<Boid>& boidPtr : m_boids)
+void BoidManager::ToggleTrajectoryRecording()
+{
+    if (m_trajectoryRecorder.IsRecording())
     {
-        Boid& boid = *boidPtr.get();
+        m_trajectoryRecorder.Stop();
+        return;
+    }
 
-        if(canUpdateSteering)
-        {
-            m_boidsHashGrid.UpdateEntity(boidPtr.get());
-            boid.SetAcceleration(m_boidSteeringController.GetBoidSteering(boid) * m_boidAccelerationMultiplier);
-        }
+    const Vector3 margin = m_bounds.size * OUT_OF_BOUNDS_MARGIN;
+    if (!m_trajectoryRecorder.Start(TrajectoryFormat::DEFAULT_PATH, m_bounds.min - margin, m_bounds.size + margin * 2.0f, m_boidMaxSpeed, m_game.GetParameters()))
+    {
+        // Recording stays off, F6 simply tries again
+        std::cerr << "Failed to start recording to " << TrajectoryFormat::DEFAULT_PATH << std::endl;
+    }
+}
+
+void BoidManager::RecordTrajectoryFrame()
+{
+    if (!m_trajectoryRecorder.IsRecording())
+    {
+        return;
+    }
+
+    TrajectoryFormat::Frame* frame = m_trajectoryRecorder.AcquireFrame();
+    if (!frame)
+    {
+        return;
+    }
 
-        const Vector3 newVelocity = boid.GetVelocity() + boid.GetAcceleration() * deltaTime;
-        boid.SetVelocity(newVelocity);
+    frame->time = m_simulationTime;
+    frame->ids.resize(m_boids.size());
+    frame->flockIDs.resize(m_boids.size());
+    frame->positions.resize(m_boids.size());
+    frame->velocities.resize(m_boids.size());
 
-        const float currentSpeedSquared = boid.GetVelocity().LengthSquared();
+    for (size_t i = 0; i < m_boids.size(); i++)
+    {
+        frame->ids[i] = m_boids[i]->id;
+        frame->flockIDs[i] = m_boids[i]->flockID;
+        frame->positions[i] = m_boids[i]->GetPosition();
+        frame->velocities[i] = m_boids[i]->GetVelocity();
+    }
 
-        if (currentSpeedSquared > m_boidMaxSpeed * m_boidMaxSpeed)
-        {
-            Vector3 direction;
-            boid.GetVelocity().Normalize(direction);
-            boid.SetVelocity(direction * m_boidMaxSpeed);
-        }
-        else if (currentSpeedSquared < m_boidMinSpeed * m_boidMinSpeed)
-        {
-            Vector3 direction;
-            boid.GetVelocity().Normalize(direction);
-            boid.SetVelocity(direction * m_boidMinSpeed);
-        }
+    m_trajectoryRecorder.SubmitFrame(frame);
+}
+
+void BoidManager::ToggleFlockingMode()
+{
+    const bool useAggregates = m_boidSteeringController.GetFlockingMode() == FlockingMode::Exact;
+    m_boidsHashGrid.SetAggregatesEnabled(useAggregates);
+    m_boidSteeringController.SetFlockingMode(useAggregates ? FlockingMode::CellAggregate : FlockingMode::Exact);
+    m_flockingAggregateError = 0.0f;
+}
+
+void BoidManager::UpdateFlockingErrorMetric(float deltaTime)
+{
+    if (m_boidSteeringController.GetFlockingMode() != FlockingMode::CellAggregate || m_boids.empty())
+    {
+        return;
+    }
 
-        boid.UpdatePositionBasedOnVelocity(deltaTime);
+    m_flockingErrorTimer -= deltaTime;
+    if (m_flockingErrorTimer > 0.0f)
+    {
+        return;
+    }
+
+    m_flockingErrorTimer = FLOCKING_ERROR_SAMPLE_INTERVAL;
+
+    // Strided sample, exact steering for every boid is exactly what this mode is trying to avoid
+    std::vector<const Boid*> sampleBoids;
+    const size_t stride = std::max<size_t>(1, m_boids.size() / FLOCKING_ERROR_SAMPLE_COUNT);
+    for (size_t i = 0; i < m_boids.size(); i += stride)
+    {
+        sampleBoids.push_back(m_boids[i]);
     }
 
-    if(canUpdateSteering)
+    m_flockingAggregateError = m_boidSteeringController.MeasureAggregateError(sampleBoids);
+}
+
+void BoidManager::UpdateBoids(float deltaTime)
+{
+    for (Boid* boid : m_boids)
     {
-        m_steeringUpdateTimer = m_steeringUpdateInterval;
+        m_boidsHashGrid.UpdateEntity(boid);
     }
+
+    const std::vector<Boid*>& scheduledBoids = m_boidSteeringScheduler.ScheduleBoids(m_boids);
+
+    const float boundsVolume = m_bounds.size.x * m_bounds.size.y * m_bounds.size.z;
+    m_boidSteeringController.GetNeighborCache().Configure(m_boidMaxSpeed * deltaTime, static_cast<float>(m_boids.size()) / boundsVolume);
+
+    m_boidSteeringScheduler.BeginSteering();
+    m_boidSteeringController.PrepareSteeringBatch(scheduledBoids);
+    m_simulationBackend->ComputeSteering(m_boidSteeringController, scheduledBoids, m_boidAccelerationMultiplier);
+    m_boidSteeringScheduler.EndSteering();
+
+    m_simulationBackend->Integrate(m_boids, BoidSpeedLimits{ m_boidMinSpeed, m_boidMaxSpeed }, m_integration, deltaTime);
+    m_boidSteeringController.GetNeighborCache().AddMaxDisplacement(m_boidMaxSpeed * deltaTime);
 }
 
 void BoidManager::RemovePendingBoids()
 {
-    for (auto iter = m_boids.begin(); iter != m_boids.end(); )
+    // One compaction pass keeps the id order, slots go back to the pool
+    const auto removedBegin = std::remove_if(m_boids.begin(), m_boids.end(), [this](Boid* boid)
     {
-        if (iter->get()->IsPendingDestroy())
+        if (!boid->IsPendingDestroy())
         {
-            m_boidsHashGrid.RemoveEntity(iter->get());
-            iter = m_boids.erase(iter);
+            return false;
         }
-        else
+
+        m_boidsHashGrid.RemoveEntity(boid);
+        m_boidPool.Destroy(boid);
+        return true;
+    });
+
+    m_boids.erase(removedBegin, m_boids.end());
+}
+
+void BoidManager::PackRenderInstances()
+{
+    m_boidInstances.Begin(m_flocksCount);
+
+    for (const Boid* boid : m_boids)
+    {
+        m_boidInstances.CountInstance(boid->flockID);
+    }
+
+    m_boidInstances.Allocate();
+
+    for (const Boid* boid : m_boids)
+    {
+        m_boidInstances.AddInstance(boid->flockID, boid->GetPosition(), boid->flockID);
+    }
+}
+
+void BoidManager::RenderInstances(IInstancedRenderContext& instancedRenderContext, const RenderInstanceBuffer& boidInstances) const
+{
+    // One instanced draw per flock
+    for (int i = 0; i < boidInstances.GetBatchesCount(); i++)
+    {
+        if (boidInstances.GetBatchSize(i) > 0)
         {
-            ++iter;
+            instancedRenderContext.RenderPrimitiveInstanced(m_boidShape, Vector3::One, boidInstances.GetBatchInstances(i), boidInstances.GetBatchSize(i), m_flockColors.data());
         }
     }
 }
 
-void BoidManager::OnRender(const framework::RenderContextPtr& renderContext) const
+void BoidManager::RenderOverlay(const framework::RenderContextPtr& renderContext, const std::vector<std::string>& hudLines) const
 {
-	for (const std::unique_ptr<Boid>& boid : m_boids)
-	{
-		renderContext->RenderPrimitive(m_boidShape, Vector3::One, boid->GetPosition(), Vector3::Zero, m_flockColors[boid->flockID]);
-	}
-
     static constexpr  XMVECTORF32 boundsColor = { 1.0f, 1.0f, 1.0f, 0.2f };
     renderContext->RenderPrimitive(m_simulationBoundsShape, Vector3::One, m_bounds.center, Vector3::Zero, boundsColor);
-    renderContext->RenderText(std::string("boids count: " + std::to_string(m_boids.size())),
-                              GetEngine().GetWindowSize() * (Vector2::UnitX * 0.4f), 1.0f);
-    renderContext->RenderText(std::string("update interval: " + std::to_string(m_steeringUpdateInterval)), Vector2(GetEngine().GetWindowSize().x * 0.4f, 20.0f), 1.0f);
+
+    for (size_t i = 0; i < hudLines.size(); i++)
+    {
+        renderContext->RenderText(hudLines[i], Vector2(GetEngine().GetWindowSize().x * 0.4f, 20.0f * static_cast<float>(i)), 1.0f);
+    }
+}
+
+void BoidManager::OnRender(const framework::RenderContextPtr& renderContext)
+{
+    // Packed here rather than at the end of OnUpdate, projectiles and queued commands still change boids after it
+    PackRenderInstances();
+
+    FrameworkInstancedRenderContext instancedRenderContext(renderContext);
+    RenderInstances(instancedRenderContext, m_boidInstances);
+    RenderOverlay(renderContext, GetHudLines());
+}
+
+std::vector<std::string> BoidManager::GetHudLines() const
+{
+    std::vector<std::string> hudLines;
+    hudLines.push_back("boids count: " + std::to_string(m_boids.size()) + ", backend: " + GetSimulationBackendName(GetSimulationBackendType())
+        + ", integration: " + GetIntegrationMethodName(m_integration.method) + " x" + std::to_string(m_integration.substepsCount));
+    hudLines.push_back("steering budget: " + std::to_string(m_boidSteeringScheduler.GetBudget()) + " ms, used: " + std::to_string(m_boidSteeringScheduler.GetLastSteeringTime()) + " ms, steered: " + std::to_string(m_boidSteeringScheduler.GetLastScheduledCount()));
+
+    if (m_boidSteeringController.GetFlockingMode() == FlockingMode::CellAggregate)
+    {
+        hudLines.push_back("cell aggregate flocking, error: " + std::to_string(m_flockingAggregateError * 100.0f) + "%");
+    }
+    else if (m_boidSteeringController.GetNeighborCache().IsEnabled())
+    {
+        hudLines.push_back("neighbor lists rebuilt: " + std::to_string(m_boidSteeringController.GetNeighborCache().GetLastRebuildFraction() * 100.0f) + "%");
+    }
+    else
+    {
+        hudLines.push_back("neighbor lists off, grid queried every step");
+    }
+
+    if (const uint32_t droppedCommandsCount = m_droppedCommandsCount.load(std::memory_order_relaxed))
+    {
+        hudLines.push_back("dropped spawn / despawn requests: " + std::to_string(droppedCommandsCount));
+    }
+
+    if (m_trajectoryRecorder.IsRecording())
+    {
+        hudLines.push_back("recording: " + std::to_string(m_trajectoryRecorder.GetSubmittedFramesCount()) + " frames, dropped: " + std::to_string(m_trajectoryRecorder.GetDroppedFramesCount()));
+    }
+
+    return hudLines;
+}
+
+void BoidManager::WriteSnapshot(SimulationSnapshot& snapshot) const
+{
+    snapshot.boidIDs.reserve(m_boids.size());
+    snapshot.boidPositions.reserve(m_boids.size());
+    snapshot.boidVelocities.reserve(m_boids.size());
+    snapshot.boidFlockIDs.reserve(m_boids.size());
+
+    for (const Boid* boid : m_boids)
+    {
+        snapshot.boidIDs.push_back(boid->id);
+        snapshot.boidPositions.push_back(boid->GetPosition());
+        snapshot.boidVelocities.push_back(boid->GetVelocity());
+        snapshot.boidFlockIDs.push_back(boid->flockID);
+    }
+
+    snapshot.hudLines = GetHudLines();
+}
+
+void BoidManager::WriteSharedState(SharedStateFrame& frame) const
+{
+    const uint32_t count = static_cast<uint32_t>(std::min<size_t>(m_boids.size(), frame.boidsCapacity));
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const Boid& boid = *m_boids[i];
+        frame.boidPositions[i] = boid.GetPosition();
+        frame.boidVelocities[i] = boid.GetVelocity();
+        frame.boidFlockIDs[i] = static_cast<uint16_t>(boid.flockID);
+    }
+
+    frame.boidsCount = count;
+    frame.droppedBoidsCount = static_cast<uint32_t>(m_boids.size() - count);
+}
+
+void BoidManager::SaveState(SimulationStateWriter& writer) const
+{
+    BoidManagerState state;
+    state.boidsCount = static_cast<uint32_t>(m_boids.size());
+    state.nextBoidID = m_nextBoidID;
+    state.flocksCount = static_cast<uint32_t>(m_flocksCount);
+    state.flockingMode = static_cast<uint32_t>(m_boidSteeringController.GetFlockingMode());
+    state.boundsCenter = m_bounds.center;
+    state.boundsSize = m_bounds.size;
+    state.hashGridCellSize = m_boidsHashGrid.GetCellSize();
+    state.steeringBudget = m_boidSteeringScheduler.GetBudget();
+    state.flockingErrorTimer = m_flockingErrorTimer;
+    writer.Write(SimulationStateSection::BoidManager, state);
+
+    WriteBoidArray<uint32_t>(writer, SimulationStateSection::BoidIDs, m_boids, [](const Boid& boid) { return boid.id; });
+    WriteBoidArray<FlockID>(writer, SimulationStateSection::BoidFlockIDs, m_boids, [](const Boid& boid) { return boid.flockID; });
+    WriteBoidArray<Vector3>(writer, SimulationStateSection::BoidPositions, m_boids, [](const Boid& boid) { return boid.GetPosition(); });
+    WriteBoidArray<Vector3>(writer, SimulationStateSection::BoidVelocities, m_boids, [](const Boid& boid) { return boid.GetVelocity(); });
+    WriteBoidArray<Vector3>(writer, SimulationStateSection::BoidAccelerations, m_boids, [](const Boid& boid) { return boid.GetAcceleration(); });
+    WriteBoidArray<float>(writer, SimulationStateSection::BoidSteeringStaleness, m_boids, [](const Boid& boid) { return boid.steeringStaleness; });
+}
+
+bool BoidManager::IsStateValid(const SimulationStateReader& reader) const
+{
+    const BoidManagerState* state = reader.Get<BoidManagerState>(SimulationStateSection::BoidManager, 1);
+    const SimulationParameters* parameters = reader.Get<SimulationParameters>(SimulationStateSection::Parameters, 1);
+    if (!state || !parameters)
+    {
+        return false;
+    }
+
+    // Flock colors and bounds shape are shared with the renderer, so states from a different setup are rejected instead of rebuilding them here
+    if (state->flocksCount != static_cast<uint32_t>(m_flocksCount) || state->boundsCenter != m_bounds.center || state->boundsSize != m_bounds.size
+        || !(state->hashGridCellSize >= parameters->neighborsDetectionRadius * SimulationParameters::MIN_HASH_GRID_CELL_SIZE_TO_RADIUS) || state->flockingMode > static_cast<uint32_t>(FlockingMode::CellAggregate))
+    {
+        return false;
+    }
+
+    const size_t count = state->boidsCount;
+    const uint32_t* ids = reader.Get<uint32_t>(SimulationStateSection::BoidIDs, count);
+    const FlockID* flockIDs = reader.Get<FlockID>(SimulationStateSection::BoidFlockIDs, count);
+    if (!ids || !flockIDs
+        || !reader.Get<Vector3>(SimulationStateSection::BoidPositions, count) || !reader.Get<Vector3>(SimulationStateSection::BoidVelocities, count)
+        || !reader.Get<Vector3>(SimulationStateSection::BoidAccelerations, count) || !reader.Get<float>(SimulationStateSection::BoidSteeringStaleness, count))
+    {
+        return false;
+    }
+
+    // m_boids, RemoveBoids, AddBoids and snapshot merges all rely on boids sorted by id, every id handed out before nextBoidID
+    for (size_t i = 0; i < count; i++)
+    {
+        if (ids[i] >= state->nextBoidID || (i > 0 && ids[i] <= ids[i - 1]))
+        {
+            return false;
+        }
+    }
+
+    return std::all_of(flockIDs, flockIDs + count, [this](FlockID flockID) { return flockID < m_flocksCount; });
+}
+
+void BoidManager::LoadState(const SimulationStateReader& reader)
+{
+    assert(IsStateValid(reader));
+
+    const BoidManagerState* state = reader.Get<BoidManagerState>(SimulationStateSection::BoidManager, 1);
+    const size_t count = state->boidsCount;
+    const uint32_t* ids = reader.Get<uint32_t>(SimulationStateSection::BoidIDs, count);
+    const FlockID* flockIDs = reader.Get<FlockID>(SimulationStateSection::BoidFlockIDs, count);
+    const Vector3* positions = reader.Get<Vector3>(SimulationStateSection::BoidPositions, count);
+    const Vector3* velocities = reader.Get<Vector3>(SimulationStateSection::BoidVelocities, count);
+    const Vector3* accelerations = reader.Get<Vector3>(SimulationStateSection::BoidAccelerations, count);
+    const float* staleness = reader.Get<float>(SimulationStateSection::BoidSteeringStaleness, count);
+
+    // Same teardown as ClearBoids, ghosts and cached neighbor lists point into the pool that is about to be reused
+    const FlockingMode flockingMode = static_cast<FlockingMode>(state->flockingMode);
+    ClearBoids();
+    m_boidsHashGrid = SpatialHashGrid<Boid>(state->hashGridCellSize);
+    m_boidsHashGrid.ReserveCells(GetBoundsCellsCount(m_bounds, m_boidsHashGrid.GetCellSize()));
+    m_boidsHashGrid.SetAggregatesEnabled(flockingMode == FlockingMode::CellAggregate);
+    m_boidSteeringController.SetFlockingMode(flockingMode);
+    m_boidSteeringScheduler.SetBudget(state->steeringBudget);
+    m_flockingErrorTimer = state->flockingErrorTimer;
+    m_nextBoidID = state->nextBoidID;
+    m_removedBelowID = count > 0 ? ids[0] : m_nextBoidID; // Everything older than the first loaded boid is gone
+
+    m_boids.reserve(std::max(m_boids.capacity(), count));
+    m_boidPool.Reserve(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        m_boids.push_back(m_boidPool.Create(ids[i], flockIDs[i], velocities[i], positions[i]));
+        m_boids.back()->SetAcceleration(accelerations[i]);
+        m_boids.back()->steeringStaleness = staleness[i];
+        m_boidsHashGrid.AddEntity(m_boids.back());
+    }
 }
 
 void BoidManager::OnShutdown()
 {
+    m_trajectoryRecorder.Stop();
     m_boids.clear();
+    m_boidPool.Clear();
     m_boidShape.reset();
     m_simulationBoundsShape.reset();
 }
@@ -1,20 +1,104 @@
 #pragma once
+#include "BoidQuantization.h"
 #include "BoidSteeringController.h"
+#include "BoidSteeringScheduler.h"
+#include "CommandQueue.h"
 #include "Entity.h"
 #include "IRenderContext.h"
+#include "ObjectPool.h"
 #include "Octree.h"
+#include "RenderInstanceBuffer.h"
+#include "SimulationBackend.h"
+#include "SimulationSnapshot.h"
 #include "SpatialHashGrid.h"
+#include "TrajectoryRecorder.h"
 
 class Game;
+struct SharedStateFrame;
+class SimulationStateReader;
+class SimulationStateWriter;
 
-class Boid : public MovingEntity
+using FlockID = uint16_t; // Wide enough for dozens of flocks, every flock gets its own bucket in the hash grid cells
+
+enum class BoidCommandType : uint8_t
+{
+    Spawn,
+    SpawnRandom,
+    Remove,
+};
+
+// Spawn uses position, velocity and flockID, SpawnRandom and Remove only count
+struct BoidCommand
+{
+    BoidCommandType type = BoidCommandType::Spawn;
+    FlockID flockID = 0;
+    uint32_t count = 0;
+    Vector3 position;
+    Vector3 velocity;
+};
+
+/// Not an Entity on purpose, all boids are spheres of the same RADIUS so no per boid Bounds are stored or updated,
+/// only what the simulation reads every frame. Bounds are built on demand by GetBounds for the rare callers that need them.
+class Boid
 {
 public:
-    uint8_t flockID;
+    static constexpr float RADIUS = 0.6f;
+    static constexpr uint32_t GHOST_ID = std::numeric_limits<uint32_t>::max(); // Never handed out to owned boids
+
+    uint32_t id; // Increasing in spawn order, migrants keep theirs (BoidManager::AddBoids merges them in by id)
+    FlockID flockID;
+    float steeringStaleness; // Seconds since the last fresh steering, used by the scheduler to pick who goes next
+
+    // What this boid currently contributes to its hash grid cell aggregate
+    Vector3 aggregatedPosition;
+    Vector3 aggregatedVelocity;
+
+    Boid(uint32_t id, FlockID flockID, Vector3 velocity, Vector3 position);
+
+    // Ghosts are boids owned by another process of a distributed run, only there for steering neighbor queries
+    bool IsGhost() const { return id == GHOST_ID; }
+
+    void Destroy() { m_isPendingDestroy = true; }
+    bool IsPendingDestroy() const { return m_isPendingDestroy; }
+
+    const Vector3Int& GetCellIndex() const { return m_cellIndex; }
+    void SetCellIndex(Vector3Int newCellIndex) { m_cellIndex = newCellIndex; }
+
+    Vector3 GetPosition() const { return BoidQuantization::Decode(m_position); }
+    void SetPosition(Vector3 newPosition) { BoidQuantization::Encode(newPosition, m_position); }
+    Bounds GetBounds() const { return Bounds(GetPosition(), Vector3::One * (RADIUS * 2.0f)); }
 
-    Boid(uint8_t flockID, Vector3 velocity, Vector3 position, Vector3 size);
+    Vector3 GetVelocity() const { return BoidQuantization::Decode(m_velocity); }
+    void SetVelocity(Vector3 newVelocity) { BoidQuantization::Encode(newVelocity, m_velocity); }
+    Vector3 GetSteeringDirection() const { return MathHelper::GetNormalizedFast(GetVelocity()); }
+
+    Vector3 GetAcceleration() const { return m_acceleration; }
+    void SetAcceleration(Vector3 newAcceleration) { m_acceleration = newAcceleration; }
+
+    void UpdatePositionBasedOnVelocity(float deltaTime) { SetPosition(GetPosition() + GetVelocity() * deltaTime); }
+
+private:
+    using PositionStorage = std::conditional_t<USE_COMPACT_BOID_STATE, BoidQuantization::QuantizedPosition, Vector3>;
+    using VelocityStorage = std::conditional_t<USE_COMPACT_BOID_STATE, BoidQuantization::EncodedVelocity, Vector3>;
+
+    PositionStorage m_position;
+    VelocityStorage m_velocity;
+    Vector3 m_acceleration;
+    Vector3Int m_cellIndex;
+    bool m_isPendingDestroy;
+};
+
+// Plain copy of a boid's simulated state, what crosses process boundaries in distributed runs
+struct BoidRecord
+{
+    uint32_t id;
+    Vector3 position;
+    Vector3 velocity;
+    FlockID flockID;
 };
 
+using BoidPredicate = std::function<bool(const Boid& boid)>;
+
 class BoidManager
 {
 public:
@@ -22,22 +106,81 @@ public:
     ~BoidManager();
 
     void OnInitialize();
-    void OnUpdate(float deltaTime, DirectX::Keyboard& keyboard);
-    void OnInput(DirectX::Keyboard& keyboard);
-    void OnRender(const framework::RenderContextPtr& renderContext) const;
+    void OnUpdate(float deltaTime, const DirectX::Keyboard::State& keyboardState);
+    void OnInput(const DirectX::Keyboard::State& keyboardState);
+    void OnRender(const framework::RenderContextPtr& renderContext);
+    void RenderInstances(IInstancedRenderContext& instancedRenderContext, const RenderInstanceBuffer& boidInstances) const;
+    void RenderOverlay(const framework::RenderContextPtr& renderContext, const std::vector<std::string>& hudLines) const;
+    void WriteSnapshot(SimulationSnapshot& snapshot) const;
+    void WriteSharedState(SharedStateFrame& frame) const;
+
+    // Loading is all or nothing, every section is checked by IsStateValid before anything is applied
+    void SaveState(SimulationStateWriter& writer) const;
+    bool IsStateValid(const SimulationStateReader& reader) const;
+    void LoadState(const SimulationStateReader& reader);
     void OnShutdown();
 
+    void SpawnBoids(int amount);
+    // The oldest boids go first
+    void RemoveBoids(int amount);
+    void ClearBoids();
+
+    // Every boid is cleared, flocks are only set up before a run (startup, scenario)
+    static constexpr int MAX_FLOCKS_COUNT = 64;
+    void SetFlocksCount(int flocksCount);
+
+    // Thread safe, so input, projectiles and external controllers don't touch the boids while they are simulated.
+    // Requests are applied in the order they were queued at the end of the simulation step (ApplyPendingCommands), false when the queue is full.
+    // ApplyPendingCommands also removes every boid destroyed during the step
+    static constexpr FlockID RANDOM_FLOCK = std::numeric_limits<FlockID>::max();
+    bool RequestSpawnBoid(Vector3 position, Vector3 velocity, FlockID flockID = RANDOM_FLOCK);
+    bool RequestSpawnBoids(int amount);
+    bool RequestRemoveBoids(int amount);
+    void ApplyPendingCommands();
+
     const Bounds& GetBounds() const { return m_bounds; }
+    size_t GetBoidsCount() const { return m_boids.size(); }
+    int GetFlocksCount() const { return m_flocksCount; }
+    float GetSimulationTime() const { return m_simulationTime; }
     const SpatialHashGrid<Boid>& GetBoidsHashGrid() const { return m_boidsHashGrid; }
+    const ObjectPool<Boid>& GetBoidPool() const { return m_boidPool; }
+    float GetNeighborsDetectionRadius() const { return m_boidSteeringController.GetNeighborsDetectionRadius(); }
+
+    SimulationBackendType GetSimulationBackendType() const { return m_simulationBackend->GetType(); }
+    void SetSimulationBackend(SimulationBackendType type);
+    // Between simulation steps only, a new hash grid cell size rebuilds the grid
+    void ApplyParameters(const SimulationParameters& parameters);
+    void SetSteeringBudget(float budgetMilliseconds) { m_boidSteeringScheduler.SetBudget(budgetMilliseconds); }
+    const BoidIntegrationSettings& GetIntegration() const { return m_integration; }
+    void SetIntegration(const BoidIntegrationSettings& integration) { m_integration = integration; }
+
+    // Distributed runs (DistributedSimulation), each process only simulates the boids of its own region.
+    // Spawns outside of it are dropped after their random draws and id, so every process consumes the same random sequence and hands out
+    // the same ids. Removals then go by id too (see RemoveBoids), and migrants keep their ids
+    void SetSpawnFilter(std::function<bool(Vector3 position)> spawnFilter) { m_spawnFilter = std::move(spawnFilter); }
+    void CollectBoids(const BoidPredicate& predicate, std::vector<BoidRecord>& collected) const;
+    void ExtractBoids(const BoidPredicate& predicate, std::vector<BoidRecord>& extracted);
+    void AddBoids(const std::vector<BoidRecord>& records);
+    // Boids owned by other processes, visible to steering neighbor queries but never steered, integrated, saved or preyed on here.
+    // Replaces the previous ones
+    void SetGhostBoids(const std::vector<BoidRecord>& records);
+    size_t GetGhostBoidsCount() const { return m_ghostBoids.size(); }
 
 private:
-
-    void SpawnBoids(int amount);
-    void RemoveBoids(int amount) const;
-
-    void SpawnBoidAtPosition(Vector3 position, Vector3 velocity, uint8_t team_id = 0);
+    void SpawnBoidAtPosition(Vector3 position, Vector3 velocity, FlockID team_id = 0);
+    Boid* AddBoid(uint32_t id, Vector3 position, Vector3 velocity, FlockID flockID);
     void UpdateBoids(float deltaTime);
     void RemovePendingBoids();
+    bool RequestCommand(const BoidCommand& command);
+    void RebuildHashGrid(float cellSize);
+    void BuildFlockColors();
+    void DiscardPendingCommands();
+    void ToggleFlockingMode();
+    void UpdateFlockingErrorMetric(float deltaTime);
+    void PackRenderInstances();
+    void ToggleTrajectoryRecording();
+    void RecordTrajectoryFrame();
+    std::vector<std::string> GetHudLines() const;
 
     const Game& m_game;
 
@@ -46,23 +189,39 @@ private:
 
     bool m_increaseKeyPressedLastFrame;
     bool m_decreaseKeyPressedLastFrame;
+    bool m_flockingModeKeyPressedLastFrame;
+    bool m_recordKeyPressedLastFrame;
+    bool m_backendKeyPressedLastFrame;
 
     int m_boidsAmount;
+    uint32_t m_nextBoidID;
+    uint32_t m_removedBelowID; // Distributed runs only, every boid with a lower id was removed by RemoveBoids or ClearBoids
     int m_flocksCount;
 
     float m_boidMaxSpeed;
     float m_boidMinSpeed;
     float m_boidAccelerationMultiplier;
 
-    float m_steeringUpdateTimer;
-    float m_steeringUpdateInterval;
+    float m_flockingErrorTimer;
+    float m_flockingAggregateError;
+    float m_simulationTime;
 
     Bounds m_bounds;
     SpatialHashGrid<Boid> m_boidsHashGrid;
     BoidSteeringController m_boidSteeringController;
+    BoidSteeringScheduler m_boidSteeringScheduler;
+    std::unique_ptr<SimulationBackend> m_simulationBackend;
+    BoidIntegrationSettings m_integration;
 
     std::vector<XMVECTOR> m_flockColors;
-    std::vector<std::unique_ptr<Boid>> m_boids;
+    RenderInstanceBuffer m_boidInstances;
+    TrajectoryRecorder m_trajectoryRecorder;
+    ObjectPool<Boid> m_boidPool;
+    std::vector<Boid*> m_boids; // Sorted by id, the boids themselves live in m_boidPool
+    std::vector<Boid*> m_ghostBoids;
+    std::function<bool(Vector3 position)> m_spawnFilter;
+    CommandQueue<BoidCommand> m_pendingCommands;
+    std::atomic<uint32_t> m_droppedCommandsCount;
     std::unique_ptr< DirectX::GeometricPrimitive > m_boidShape;
     std::unique_ptr< DirectX::GeometricPrimitive > m_simulationBoundsShape;
 };
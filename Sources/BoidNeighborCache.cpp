@@ -0,0 +1,162 @@
+#include "pch.h"
+#include "BoidNeighborCache.h"
+
+#include "BoidManager.h"
+
+namespace
+{
+    // Measured with Tools/NeighborCacheBenchmark.cpp at radius 3: lists rebuilt every 3 steps with a skin of 0.75 were 1.3-1.6x faster
+    // than grid queries up to ~15 candidates per list, but 10-15% slower at ~60, and any skin of 1.5 or more lost at 5000 boids and up
+    constexpr int LIST_LIFETIME_STEPS = 3;
+    constexpr float MAX_SKIN_TO_RADIUS = 0.3f;
+    constexpr float MAX_EXPECTED_CANDIDATES = 32.0f;
+}
+
+BoidNeighborCache::BoidNeighborCache(float radius)
+    : m_radius(radius)
+    , m_skin(0.0f)
+    , m_isEnabled(false)
+    , m_widestBuiltSkin(0.0f)
+    , m_epoch(0)
+    , m_frame(0)
+    , m_maxDisplacementSum(0.0)
+    , m_lastRebuildFraction(0.0f)
+{
+}
+
+void BoidNeighborCache::Configure(float maxStepDisplacement, float boidsPerUnitVolume)
+{
+    // Both ends of a pair move up to maxStepDisplacement per step, a list goes stale on the step its skin is used up
+    m_skin = 2.0f * maxStepDisplacement * static_cast<float>(LIST_LIFETIME_STEPS - 1);
+
+    const float listRadius = m_radius + m_skin;
+    const float expectedCandidates = boidsPerUnitVolume * 4.0f / 3.0f * static_cast<float>(M_PI) * listRadius * listRadius * listRadius;
+    const bool isEnabled = m_skin <= m_radius * MAX_SKIN_TO_RADIUS && expectedCandidates <= MAX_EXPECTED_CANDIDATES;
+
+    // Spawns aren't tracked while off, so lists from before can't be trusted
+    if (isEnabled && !m_isEnabled)
+    {
+        Invalidate();
+    }
+    m_isEnabled = isEnabled;
+}
+
+void BoidNeighborCache::SetSkin(float skin)
+{
+    m_skin = skin;
+    if (!m_isEnabled)
+    {
+        Invalidate();
+        m_isEnabled = true;
+    }
+}
+
+void BoidNeighborCache::Update(const std::vector<Boid*>& boids, const SpatialHashGrid<Boid>& grid, const ObjectPool<Boid>& pool)
+{
+    ++m_frame;
+    if (!m_isEnabled)
+    {
+        // FindCandidates returns nullptr for every boid, steering queries the grid
+        m_lastRebuildFraction = 0.0f;
+        return;
+    }
+
+    if (m_entries.size() < pool.GetCapacity())
+    {
+        m_entries.resize(pool.GetCapacity());
+    }
+
+    size_t rebuiltCount = 0;
+
+    for (const Boid* boid : boids)
+    {
+        const ObjectPool<Boid>::Handle handle = pool.GetHandle(boid);
+        Entry& entry = m_entries[handle.index];
+
+        if (IsStale(entry, *boid, handle.generation))
+        {
+            entry.generation = handle.generation;
+            Rebuild(entry, *boid, grid, pool);
+            ++rebuiltCount;
+        }
+
+        entry.validatedFrame = m_frame;
+    }
+
+    m_lastRebuildFraction = boids.empty() ? 0.0f : static_cast<float>(rebuiltCount) / static_cast<float>(boids.size());
+}
+
+void BoidNeighborCache::OnBoidAdded(Vector3 position, const SpatialHashGrid<Boid>& grid, const ObjectPool<Boid>& pool)
+{
+    if (!m_isEnabled)
+    {
+        return;
+    }
+
+    // Until a list goes stale its boid and the new one each move at most its skin (the max displacement sum bounds both),
+    // so only boids currently within radius + 2 * skin can see the new one before rebuilding anyway. Lists built with
+    // a wider skin than the current one are covered by the widest skin built with.
+    grid.QueryInRadius(position, m_radius + 2.0f * std::max(m_skin, m_widestBuiltSkin), -1, m_sameFlockScratch, m_otherFlocksScratch);
+
+    for (const Boid* boid : m_otherFlocksScratch)
+    {
+        const ObjectPool<Boid>::Handle handle = pool.GetHandle(boid);
+        if (handle.index < m_entries.size())
+        {
+            m_entries[handle.index].isBuilt = false;
+        }
+    }
+}
+
+const std::vector<BoidNeighborCache::Candidate>* BoidNeighborCache::FindCandidates(const Boid& boid, const ObjectPool<Boid>& pool, size_t& sameFlockCount) const
+{
+    const ObjectPool<Boid>::Handle handle = pool.GetHandle(&boid);
+    if (handle.index >= m_entries.size())
+    {
+        return nullptr;
+    }
+
+    const Entry& entry = m_entries[handle.index];
+    if (entry.validatedFrame != m_frame || entry.generation != handle.generation || entry.epoch != m_epoch)
+    {
+        return nullptr;
+    }
+
+    sameFlockCount = entry.sameFlockCount;
+    return &entry.candidates;
+}
+
+bool BoidNeighborCache::IsStale(const Entry& entry, const Boid& boid, uint32_t generation) const
+{
+    if (!entry.isBuilt || entry.generation != generation || entry.epoch != m_epoch)
+    {
+        return true;
+    }
+
+    // A neighbor outside radius + skin at build time can only be within radius once the two moved more than the skin towards each other
+    const float ownDisplacement = (boid.GetPosition() - entry.buildPosition).Length();
+    const float othersMaxDisplacement = static_cast<float>(m_maxDisplacementSum - entry.buildMaxDisplacementSum);
+    return ownDisplacement + othersMaxDisplacement > entry.skin;
+}
+
+void BoidNeighborCache::Rebuild(Entry& entry, const Boid& boid, const SpatialHashGrid<Boid>& grid, const ObjectPool<Boid>& pool)
+{
+    grid.QueryInRadius(boid.GetPosition(), m_radius + m_skin, boid.flockID, m_sameFlockScratch, m_otherFlocksScratch);
+
+    entry.candidates.clear();
+    for (const std::vector<Boid*>* group : { &m_sameFlockScratch, &m_otherFlocksScratch })
+    {
+        for (Boid* candidate : *group)
+        {
+            entry.candidates.push_back(Candidate{ candidate, pool.GetHandle(candidate).generation });
+        }
+    }
+
+    entry.sameFlockCount = m_sameFlockScratch.size();
+    entry.buildPosition = boid.GetPosition();
+    entry.skin = m_skin;
+    m_widestBuiltSkin = std::max(m_widestBuiltSkin, m_skin);
+    entry.buildMaxDisplacementSum = m_maxDisplacementSum;
+    entry.epoch = m_epoch;
+    entry.isBuilt = true;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include "ObjectPool.h"
+#include "SpatialHashGrid.h"
+
+class Boid;
+
+/// Verlet style neighbor lists. Every boid keeps the boids found within radius + skin at its last build, and only goes back to the hash grid
+/// once that list could be missing someone: its own displacement since the build plus the furthest any other boid could have moved
+/// in the meantime exceeds the skin. Between builds neighbors are found by filtering the short candidate list.
+/// Lists only pay off when they last a few steps with a skin that is narrow next to the radius, and while they stay short,
+/// Configure turns them off otherwise (see Tools/NeighborCacheBenchmark.cpp for the numbers).
+class BoidNeighborCache
+{
+public:
+    struct Candidate
+    {
+        Boid* boid;
+        uint32_t generation; // Pool slot generation at build time, a despawned candidate no longer matches it
+    };
+
+    explicit BoidNeighborCache(float radius);
+
+    // Sizes the skin so a list lasts a few steps of the given max displacement, and turns lists off where they lose to grid queries
+    void Configure(float maxStepDisplacement, float boidsPerUnitVolume);
+    // Fixed skin with lists always on, for measuring
+    void SetSkin(float skin);
+
+    // Rebuilds the lists of the given boids that may be missing neighbors, called before those boids are steered
+    void Update(const std::vector<Boid*>& boids, const SpatialHashGrid<Boid>& grid, const ObjectPool<Boid>& pool);
+    // Furthest any boid could have moved during the last integration step
+    void AddMaxDisplacement(float distance) { m_maxDisplacementSum += distance; }
+    // A new boid is only missing from the lists of boids around it, those are rebuilt on their next Update
+    void OnBoidAdded(Vector3 position, const SpatialHashGrid<Boid>& grid, const ObjectPool<Boid>& pool);
+    // Drops every list, for changes that aren't local (clears, loads, grid rebuilds)
+    void Invalidate() { ++m_epoch; m_widestBuiltSkin = 0.0f; }
+
+    // Candidates of a boid validated by the last Update, same flock ones first, nullptr if the boid wasn't part of it
+    const std::vector<Candidate>* FindCandidates(const Boid& boid, const ObjectPool<Boid>& pool, size_t& sameFlockCount) const;
+
+    float GetRadius() const { return m_radius; }
+    void SetRadius(float radius) { m_radius = radius; Invalidate(); }
+    float GetSkin() const { return m_skin; }
+    bool IsEnabled() const { return m_isEnabled; }
+    float GetLastRebuildFraction() const { return m_lastRebuildFraction; }
+
+private:
+    struct Entry
+    {
+        uint32_t generation = 0; // Of the owning boid, a reused pool slot starts over
+        uint32_t epoch = 0;
+        uint32_t validatedFrame = 0;
+        Vector3 buildPosition = Vector3::Zero;
+        float skin = 0.0f; // At build time, the skin can change between steps
+        double buildMaxDisplacementSum = 0.0; // Sums grow for the whole run, double keeps the differences exact enough
+        size_t sameFlockCount = 0;
+        std::vector<Candidate> candidates;
+        bool isBuilt = false;
+    };
+
+    bool IsStale(const Entry& entry, const Boid& boid, uint32_t generation) const;
+    void Rebuild(Entry& entry, const Boid& boid, const SpatialHashGrid<Boid>& grid, const ObjectPool<Boid>& pool);
+
+    float m_radius;
+    float m_skin;
+    bool m_isEnabled;
+    float m_widestBuiltSkin; // Since the last Invalidate, bounds the skin of every valid list
+    uint32_t m_epoch;
+    uint32_t m_frame;
+    double m_maxDisplacementSum;
+    float m_lastRebuildFraction;
+
+    std::vector<Entry> m_entries; // Indexed by pool slot
+    std::vector<Boid*> m_sameFlockScratch;
+    std::vector<Boid*> m_otherFlocksScratch;
+};
@@ -0,0 +1,49 @@
+#include "pch.h"
+#include "BoidQuantization.h"
+
+namespace
+{
+    constexpr float UINT16_RANGE = 65535.0f;
+    constexpr float HALF_MAX = 65504.0f;
+    constexpr float HALF_EXPONENT_REBIAS = 1.925929944387236e-34f; // 2^-112
+
+    uint16_t QuantizeUnsigned(float value)
+    {
+        return static_cast<uint16_t>(std::clamp(value + 0.5f, 0.0f, UINT16_RANGE));
+    }
+}
+
+namespace BoidQuantization
+{
+    void SetFrame(Vector3 positionMin, Vector3 positionRange)
+    {
+        activeFrame.positionMin = positionMin;
+        activeFrame.positionStep = positionRange / UINT16_RANGE;
+        activeFrame.positionScale = Vector3(UINT16_RANGE / positionRange.x, UINT16_RANGE / positionRange.y, UINT16_RANGE / positionRange.z);
+    }
+
+    QuantizedPosition EncodePosition(Vector3 position)
+    {
+        const Vector3 scaled = (position - activeFrame.positionMin) * activeFrame.positionScale;
+        return QuantizedPosition{ QuantizeUnsigned(scaled.x), QuantizeUnsigned(scaled.y), QuantizeUnsigned(scaled.z) };
+    }
+
+    EncodedVelocity EncodeVelocity(Vector3 velocity)
+    {
+        return EncodedVelocity{ FloatToHalf(velocity.x), FloatToHalf(velocity.y), FloatToHalf(velocity.z) };
+    }
+
+    uint16_t FloatToHalf(float value)
+    {
+        // Inverse of HalfToFloat, scaling by 2^-112 lines the float exponent up with the half one (subnormals included),
+        // then the mantissa is rounded to 10 bits. Out of range values saturate instead of becoming infinities
+        const float magnitude = std::min(std::abs(value), HALF_MAX) * HALF_EXPONENT_REBIAS;
+
+        uint32_t bits;
+        std::memcpy(&bits, &magnitude, sizeof(float));
+        const uint32_t rounded = (bits + 0x0fff + ((bits >> 13) & 1)) >> 13; // round to nearest even
+
+        const uint16_t sign = std::signbit(value) ? 0x8000 : 0;
+        return static_cast<uint16_t>(std::min<uint32_t>(rounded, 0x7bff) | sign);
+    }
+}
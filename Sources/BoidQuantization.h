@@ -0,0 +1,79 @@
+#pragma once
+
+// Compact boid storage, positions as 16 bit fixed point inside the simulation bounds and velocities as half floats,
+// 12 bytes instead of 24 for the state every neighbor lookup reads. Off by default, see Tools/BoidStateBenchmark.cpp for when it pays off.
+constexpr bool USE_COMPACT_BOID_STATE = false;
+
+/// Encoding of the compact boid state. Decoding is inline and branch free so it folds straight into the steering loops reading neighbors.
+/// With the default 45 x 35 x 45 bounds plus margin a position step is under 1 mm, positions outside the frame saturate.
+/// Half floats keep 11 significant bits, at boid speeds (< 16) a velocity component is off by at most ~0.004.
+namespace BoidQuantization
+{
+    struct Frame
+    {
+        Vector3 positionMin = Vector3::Zero;
+        Vector3 positionStep = Vector3::One;        // range / 65535
+        Vector3 positionScale = Vector3::One;       // 65535 / range
+    };
+
+    struct QuantizedPosition
+    {
+        uint16_t x;
+        uint16_t y;
+        uint16_t z;
+    };
+
+    struct EncodedVelocity
+    {
+        uint16_t x; // IEEE 754 half floats
+        uint16_t y;
+        uint16_t z;
+    };
+
+    // Shared by all boids, set once by BoidManager from its bounds before any boid is spawned
+    inline Frame activeFrame;
+
+    void SetFrame(Vector3 positionMin, Vector3 positionRange);
+
+    QuantizedPosition EncodePosition(Vector3 position);
+    EncodedVelocity EncodeVelocity(Vector3 velocity);
+    uint16_t FloatToHalf(float value);
+
+    inline float HalfToFloat(uint16_t half)
+    {
+        // Exponent and mantissa moved into float position are the value scaled by 2^-112, the multiply rebiases normals and subnormals alike
+        constexpr float exponentRebias = 5.192296858534828e33f; // 2^112
+        const uint32_t magnitudeBits = static_cast<uint32_t>(half & 0x7fff) << 13;
+
+        float magnitude;
+        std::memcpy(&magnitude, &magnitudeBits, sizeof(float));
+        magnitude *= exponentRebias;
+
+        uint32_t bits;
+        std::memcpy(&bits, &magnitude, sizeof(float));
+        bits |= static_cast<uint32_t>(half & 0x8000) << 16;
+
+        float value;
+        std::memcpy(&value, &bits, sizeof(float));
+        return value;
+    }
+
+    inline Vector3 DecodePosition(QuantizedPosition position)
+    {
+        return activeFrame.positionMin + Vector3(position.x, position.y, position.z) * activeFrame.positionStep;
+    }
+
+    inline Vector3 DecodeVelocity(EncodedVelocity velocity)
+    {
+        return Vector3(HalfToFloat(velocity.x), HalfToFloat(velocity.y), HalfToFloat(velocity.z));
+    }
+
+    // Same calls for both storages, Boid picks its storage types from USE_COMPACT_BOID_STATE
+    inline Vector3 Decode(const Vector3& value) { return value; }
+    inline Vector3 Decode(QuantizedPosition position) { return DecodePosition(position); }
+    inline Vector3 Decode(EncodedVelocity velocity) { return DecodeVelocity(velocity); }
+
+    inline void Encode(Vector3 value, Vector3& storage) { storage = value; }
+    inline void Encode(Vector3 value, QuantizedPosition& storage) { storage = EncodePosition(value); }
+    inline void Encode(Vector3 value, EncodedVelocity& storage) { storage = EncodeVelocity(value); }
+}
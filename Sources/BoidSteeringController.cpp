@@ -7,8 +7,6 @@
 
 namespace
 {
-    constexpr float NEIGHBORS_DETECTION_RADIUS = 3.0f;
-    constexpr float NEIGHBORS_DETECTION_RADIUS_SQUARED = NEIGHBORS_DETECTION_RADIUS * NEIGHBORS_DETECTION_RADIUS;
     constexpr float NEIGHBORS_DETECTION_HALF_ANGLE = 130.0f;
 
     constexpr float SKYSCRAPER_AVOIDANCE_DISTANCE = 2.5f;
@@ -22,88 +20,227 @@ namespace
 BoidSteeringController::BoidSteeringController(const BoidManager& boidManager, const Game& game)
     : m_boidManager(boidManager)
     , m_game(game)
-    , m_boundsMultiplier(3.0f)
-    , m_cameraMultiplier(2.0f)
-    , m_projectileMultiplier(2.2f)
-    , m_skyscrapersMultiplier(4.0f)
-    , m_cohesionMultiplier(1.75f)
-    , m_alignmentMultiplier(1.f)
-    , m_separationMultiplier(1.2f)
+    , m_flockingMode(FlockingMode::Exact)
+    , m_neighborCache(DEFAULT_SIMULATION_PARAMETERS.neighborsDetectionRadius)
 {
     m_neighborsDetectionDotThreshold = std::cos(MathHelper::DegreesToRadians(NEIGHBORS_DETECTION_HALF_ANGLE));
+    ApplyParameters(DEFAULT_SIMULATION_PARAMETERS);
 }
 
-Vector3 BoidSteeringController::GetBoidSteering(const Boid& boid) const
+void BoidSteeringController::ApplyParameters(const SimulationParameters& parameters)
+{
+    m_neighborsDetectionRadius = parameters.neighborsDetectionRadius;
+    m_neighborsDetectionRadiusSquared = m_neighborsDetectionRadius * m_neighborsDetectionRadius;
+    m_boundsMultiplier = parameters.boundsMultiplier;
+    m_cameraMultiplier = parameters.cameraMultiplier;
+    m_projectileMultiplier = parameters.projectileMultiplier;
+    m_skyscrapersMultiplier = parameters.skyscrapersMultiplier;
+    m_cohesionMultiplier = parameters.cohesionMultiplier;
+    m_alignmentMultiplier = parameters.alignmentMultiplier;
+    m_separationMultiplier = parameters.separationMultiplier;
+
+    if (m_neighborCache.GetRadius() != m_neighborsDetectionRadius)
+    {
+        m_neighborCache.SetRadius(m_neighborsDetectionRadius);
+    }
+}
+
+void BoidSteeringController::PrepareSteeringBatch(const std::vector<Boid*>& boids)
+{
+    m_batchX.resize(boids.size());
+    m_batchY.resize(boids.size());
+    m_batchZ.resize(boids.size());
+
+    for (size_t i = 0; i < boids.size(); i++)
+    {
+        const Vector3 position = boids[i]->GetPosition();
+        m_batchX[i] = position.x;
+        m_batchY[i] = position.y;
+        m_batchZ[i] = position.z;
+    }
+
+    UpdateBoundsSteering(boids.size());
+
+    if (m_flockingMode == FlockingMode::Exact)
+    {
+        m_neighborCache.Update(boids, m_boidManager.GetBoidsHashGrid(), m_boidManager.GetBoidPool());
+    }
+}
+
+Vector3 BoidSteeringController::GetBoidSteering(const Boid& boid, size_t batchIndex) const
 {
     Vector3 finalSteering = Vector3::Zero;
-    const Vector3 boundsSteering = GetBoundsSteering(boid);
+    const Vector3 boundsSteering = Vector3(m_batchX[batchIndex], m_batchY[batchIndex], m_batchZ[batchIndex]);
     const Vector3 cameraSteering = GetCameraSteering(boid);
     const Vector3 projectileSteering = GetProjectileSteering(boid);
     const Vector3 skyscrapersSteering = GetSkyscrapersSteering(boid);
     finalSteering += boundsSteering + cameraSteering + projectileSteering + skyscrapersSteering;
 
-    const std::vector<Boid*> neighbors = GetBoidNeighbors(boid);
+    Vector3 flockingSteering;
+    const bool hasNeighbors = m_flockingMode == FlockingMode::CellAggregate
+                                ? GetAggregateFlockingSteering(boid, flockingSteering)
+                                : GetExactFlockingSteering(boid, flockingSteering);
 
-    if (neighbors.empty())
+    if (!hasNeighbors)
     {
         return finalSteering;
     }
 
-    const Vector3 cohesionSteering = GetCohesionSteering(boid, neighbors);
-    const Vector3 alignmentSteering = GetAlignmentSteering(boid, neighbors);
-    const Vector3 separationSteering = GetSeparationSteering(boid, neighbors);
-    finalSteering += cohesionSteering + alignmentSteering + separationSteering;
-    return MathHelper::GetNormalized(finalSteering);
+    finalSteering += flockingSteering;
+    return MathHelper::GetNormalizedFast(finalSteering);
 }
 
-Vector3 BoidSteeringController::GetBoundsSteering(const Boid& boid) const
+void BoidSteeringController::SetFlockingMode(FlockingMode flockingMode)
 {
-    static const Vector3 BOUNDS_MAX_WITH_THRESHOLD = m_boidManager.GetBounds().max - Vector3::One * BOUNDS_AVOIDANCE_DISTANCE;
-    static const Vector3 BOUNDS_MIN_WITH_THRESHOLD = m_boidManager.GetBounds().min + Vector3::One * BOUNDS_AVOIDANCE_DISTANCE;
-
-    const Vector3 position = boid.GetPosition();
-    const float xNegativePushFactor = MathHelper::GetProportional(BOUNDS_MAX_WITH_THRESHOLD.x, m_boidManager.GetBounds().max.x, position.x, 0.0f, 1.0f);
-    const float xPositivePushFactor = MathHelper::GetProportional(BOUNDS_MIN_WITH_THRESHOLD.x, m_boidManager.GetBounds().min.x, position.x, 0.0f, 1.0f);
-    const float yNegativePushFactor = MathHelper::GetProportional(BOUNDS_MAX_WITH_THRESHOLD.y, m_boidManager.GetBounds().max.y, position.y, 0.0f, 1.0f);
-    const float yPositivePushFactor = MathHelper::GetProportional(BOUNDS_MIN_WITH_THRESHOLD.y, m_boidManager.GetBounds().min.y, position.y, 0.0f, 1.0f);
-    const float zNegativePushFactor = MathHelper::GetProportional(BOUNDS_MAX_WITH_THRESHOLD.z, m_boidManager.GetBounds().max.z, position.z, 0.0f, 1.0f);
-    const float zPositivePushFactor = MathHelper::GetProportional(BOUNDS_MIN_WITH_THRESHOLD.z, m_boidManager.GetBounds().min.z, position.z, 0.0f, 1.0f);
+    // The cache isn't updated outside Exact mode, lists from before the switch must not be read after it
+    m_flockingMode = flockingMode;
+    m_neighborCache.Invalidate();
+}
 
-    Vector3 steering = Vector3::Zero;
+float BoidSteeringController::MeasureAggregateError(const std::vector<const Boid*>& sampleBoids) const
+{
+    float errorSum = 0.0f;
+    int measuredCount = 0;
 
-    if (xNegativePushFactor > 0.0f)
+    for (const Boid* boid : sampleBoids)
     {
-        steering.x = -xNegativePushFactor;
+        Vector3 exactSteering;
+        Vector3 aggregateSteering;
+        // The cache isn't updated in CellAggregate mode, the reference must come straight from the grid
+        if (!GetExactFlockingSteering(*boid, exactSteering, false))
+        {
+            continue;
+        }
+
+        if (!GetAggregateFlockingSteering(*boid, aggregateSteering))
+        {
+            aggregateSteering = Vector3::Zero;
+        }
+
+        const float exactLength = exactSteering.Length();
+        if (exactLength > 0.0f)
+        {
+            errorSum += Vector3::Distance(exactSteering, aggregateSteering) / exactLength;
+            ++measuredCount;
+        }
     }
-    else if (xPositivePushFactor > 0.0f)
+
+    return measuredCount > 0 ? errorSum / static_cast<float>(measuredCount) : 0.0f;
+}
+
+bool BoidSteeringController::GetExactFlockingSteering(const Boid& boid, Vector3& steering, bool isCacheAllowed) const
+{
+    const BoidNeighbors neighbors = GetBoidNeighbors(boid, isCacheAllowed);
+
+    if (neighbors.IsEmpty())
     {
-        steering.x = xPositivePushFactor;
+        return false;
     }
 
-    if (yNegativePushFactor > 0.0f)
+    const Vector3 cohesionSteering = GetCohesionSteering(boid, neighbors.sameFlock);
+    const Vector3 alignmentSteering = GetAlignmentSteering(boid, neighbors.sameFlock);
+    const Vector3 separationSteering = GetSeparationSteering(boid, neighbors);
+    steering = cohesionSteering + alignmentSteering + separationSteering;
+    return true;
+}
+
+bool BoidSteeringController::GetAggregateFlockingSteering(const Boid& boid, Vector3& steering) const
+{
+    const SpatialHashGrid<Boid>& hashGrid = m_boidManager.GetBoidsHashGrid();
+    const Vector3Int& cellIndex = boid.GetCellIndex();
+
+    // Near field, exact neighbors but only from the boid's own cell
+    BoidNeighbors neighbors;
+    for (int flockID = 0; flockID < m_boidManager.GetFlocksCount(); ++flockID)
     {
-        steering.y = -yNegativePushFactor;
+        const std::vector<Boid*>* cellBoids = hashGrid.GetCellEntities(cellIndex, flockID);
+        if (!cellBoids)
+        {
+            continue;
+        }
+
+        std::vector<Boid*>& result = flockID == boid.flockID ? neighbors.sameFlock : neighbors.otherFlocks;
+        for (Boid* neighbor : *cellBoids)
+        {
+            const float distanceSquared = (neighbor->GetPosition() - boid.GetPosition()).LengthSquared();
+            if (distanceSquared < m_neighborsDetectionRadiusSquared && IsInFieldOfView(boid, *neighbor))
+            {
+                result.push_back(neighbor);
+            }
+        }
     }
-    else if (yPositivePushFactor > 0.0f)
+
+    // Far field, adjacent cells are treated as a single mass of same flock boids
+    int aggregateCount = 0;
+    Vector3 aggregatePositionSum = Vector3::Zero;
+    Vector3 aggregateVelocitySum = Vector3::Zero;
+
+    for (int i = 0; i < 27; ++i)
     {
-        steering.y = yPositivePushFactor;
+        if (i == 13) // Own cell, already handled exactly
+        {
+            continue;
+        }
+
+        const Vector3Int adjacentIndex(cellIndex.x + i % 3 - 1, cellIndex.y + (i / 3) % 3 - 1, cellIndex.z + i / 9 - 1);
+        if (const auto* aggregate = hashGrid.GetCellAggregate(adjacentIndex, boid.flockID))
+        {
+            aggregateCount += aggregate->count;
+            aggregatePositionSum += aggregate->positionSum;
+            aggregateVelocitySum += aggregate->velocitySum;
+        }
     }
 
-    if (zNegativePushFactor > 0.0f)
+    if (neighbors.IsEmpty() && aggregateCount == 0)
     {
-        steering.z = -zNegativePushFactor;
+        return false;
     }
-    else if (zPositivePushFactor > 0.0f)
+
+    const int sameFlockCount = aggregateCount + static_cast<int>(neighbors.sameFlock.size());
+    Vector3 positionSum = aggregatePositionSum;
+    Vector3 directionSum = MathHelper::GetNormalizedFast(aggregateVelocitySum) * static_cast<float>(aggregateCount);
+
+    for (const Boid* neighbor : neighbors.sameFlock)
     {
-        steering.z = zPositivePushFactor;
+        positionSum += neighbor->GetPosition();
+        directionSum += neighbor->GetSteeringDirection();
     }
 
-    return steering * m_boundsMultiplier;
+    const Vector3 cohesionSteering = GetCohesionSteering(boid, positionSum, sameFlockCount);
+    const Vector3 alignmentSteering = GetAlignmentSteering(boid, directionSum, sameFlockCount);
+    const Vector3 separationSteering = GetSeparationSteering(boid, neighbors);
+    steering = cohesionSteering + alignmentSteering + separationSteering;
+    return true;
+}
+
+void BoidSteeringController::UpdateBoundsSteering(size_t count)
+{
+    // Push grows linearly from 0 at the avoidance distance to 1 at the bounds (and keeps growing outside of them).
+    // Thresholds come from the live bounds every batch, both sides are evaluated and clamped at 0 instead of branching per axis,
+    // only one of them can be non zero while the bounds are wider than twice the avoidance distance
+    const Bounds& bounds = m_boidManager.GetBounds();
+    const Vector3 lowerThreshold = bounds.min + Vector3::One * BOUNDS_AVOIDANCE_DISTANCE;
+    const Vector3 upperThreshold = bounds.max - Vector3::One * BOUNDS_AVOIDANCE_DISTANCE;
+    const float pushScale = m_boundsMultiplier / BOUNDS_AVOIDANCE_DISTANCE;
+
+    const auto sweepAxis = [count, pushScale](float* axis, float lower, float upper)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            const float positivePush = std::max(lower - axis[i], 0.0f);
+            const float negativePush = std::max(axis[i] - upper, 0.0f);
+            axis[i] = (positivePush - negativePush) * pushScale;
+        }
+    };
+
+    sweepAxis(m_batchX.data(), lowerThreshold.x, upperThreshold.x);
+    sweepAxis(m_batchY.data(), lowerThreshold.y, upperThreshold.y);
+    sweepAxis(m_batchZ.data(), lowerThreshold.z, upperThreshold.z);
 }
 
 Vector3 BoidSteeringController::GetCameraSteering(const Boid& boid) const
 {
-    const Vector3 vectorFromCamera = boid.GetPosition() - m_game.GetCamera().GetCameraPos();
+    const Vector3 vectorFromCamera = boid.GetPosition() - m_game.GetSimulationCamera().GetCameraPos();
     const float distanceSquaredToCamera = vectorFromCamera.LengthSquared();
 
     if (distanceSquaredToCamera > CAMERA_DETECTION_RADIUS_SQUARED)
@@ -112,7 +249,7 @@ Vector3 BoidSteeringController::GetCameraSteering(const Boid& boid) const
     }
 
     const float push_ratio = 1.0f - (distanceSquaredToCamera / CAMERA_DETECTION_RADIUS_SQUARED);
-    const Vector3 steering = MathHelper::GetNormalized(vectorFromCamera) * push_ratio;
+    const Vector3 steering = MathHelper::GetNormalizedFast(vectorFromCamera) * push_ratio;
     return steering * m_cameraMultiplier;
 }
 
@@ -137,7 +274,7 @@ Vector3 BoidSteeringController::GetProjectileSteering(const Boid& boid) const
         }
 
         const float push_ratio = 1.0f - (distanceSquaredToProjectile / PROJECTILE_DETECTION_RADIUS_SQUARED);
-        steering += MathHelper::GetNormalized(projectile.IsPredator() ? vectorFromProjectile : -vectorFromProjectile) * push_ratio;
+        steering += MathHelper::GetNormalizedFast(projectile.IsPredator() ? vectorFromProjectile : -vectorFromProjectile) * push_ratio;
     }
 
     return steering * m_projectileMultiplier;
@@ -155,102 +292,152 @@ Vector3 BoidSteeringController::GetSkyscrapersSteering(const Boid& boid) const
 
     Vector3 steering = Vector3::Zero;
 
-    for (const Entity& skyscraper : m_game.GetCity().GetSkyscrapers())
+    // Skyscrapers further than the avoidance distance never contribute, so only the ones around the boid are visited
+    const Vector3 queryExtents = Vector3::One * (SKYSCRAPER_AVOIDANCE_DISTANCE + Boid::RADIUS);
+
+    m_game.GetCity().ForEachSkyscraperInRange(boid.GetPosition() - queryExtents, boid.GetPosition() + queryExtents, [&](const Bounds& skyscraper)
     {
-        const Vector3 closestPoint = skyscraper.GetBounds().ClosestPoint(boid.GetPosition());
+        const Vector3 closestPoint = skyscraper.ClosestPoint(boid.GetPosition());
         const Vector3 vectorToBoid = boid.GetPosition() - closestPoint;
-        const float distanceSquared = vectorToBoid.LengthSquared() - boid.GetBounds().GetBiggestExtentSquared();
+        const float distanceSquared = vectorToBoid.LengthSquared() - Boid::RADIUS * Boid::RADIUS;
 
         if (distanceSquared < SKYSCRAPER_AVOIDANCE_DISTANCE_SQUARED)
         {
-            const Vector3 avoidanceForce = MathHelper::GetNormalized(vectorToBoid) * (1.0f - (distanceSquared / SKYSCRAPER_AVOIDANCE_DISTANCE_SQUARED));
+            const Vector3 avoidanceForce = MathHelper::GetNormalizedFast(vectorToBoid) * (1.0f - (distanceSquared / SKYSCRAPER_AVOIDANCE_DISTANCE_SQUARED));
             steering += avoidanceForce;
         }
-    }
+    });
 
     //steering += boid.GetSteeringDirection(); // + = smoother ; - = snappier ; none = parallel
     return steering * m_skyscrapersMultiplier;
 }
 
-std::vector<Boid*> BoidSteeringController::GetBoidNeighbors(const Boid& boid) const
+bool BoidSteeringController::IsInFieldOfView(const Boid& boid, const Boid& neighbor) const
+{
+    if (&neighbor == &boid)
+    {
+        return false;
+    }
+
+    // Only the angle matters, so the vector to the neighbor is never normalized
+    return MathHelper::IsWithinCone(boid.GetSteeringDirection(), neighbor.GetPosition() - boid.GetPosition(), m_neighborsDetectionDotThreshold);
+}
+
+BoidNeighbors BoidSteeringController::GetBoidNeighbors(const Boid& boid, bool isCacheAllowed) const
 {
-    std::vector<Boid*> neighbors = m_boidManager.GetBoidsHashGrid().QueryInRadius(boid.GetPosition(), NEIGHBORS_DETECTION_RADIUS);
+    BoidNeighbors neighbors;
+    const ObjectPool<Boid>& boidPool = m_boidManager.GetBoidPool();
 
-    neighbors.erase(
-        std::remove_if(neighbors.begin(), neighbors.end(),
-            [&](const Boid* neighbor)
+    size_t sameFlockCount = 0;
+    const auto* candidates = isCacheAllowed ? m_neighborCache.FindCandidates(boid, boidPool, sameFlockCount) : nullptr;
+    if (candidates)
+    {
+        for (size_t i = 0; i < candidates->size(); i++)
+        {
+            const BoidNeighborCache::Candidate& candidate = (*candidates)[i];
+            if (boidPool.GetHandle(candidate.boid).generation != candidate.generation)
             {
-                if (neighbor == &boid)
-                {
-                    return true;
-                }
+                continue;
+            }
+
+            const float distanceSquared = (candidate.boid->GetPosition() - boid.GetPosition()).LengthSquared();
+            if (distanceSquared < m_neighborsDetectionRadiusSquared)
+            {
+                (i < sameFlockCount ? neighbors.sameFlock : neighbors.otherFlocks).push_back(candidate.boid);
+            }
+        }
+    }
+    else
+    {
+        m_boidManager.GetBoidsHashGrid().QueryInRadius(boid.GetPosition(), m_neighborsDetectionRadius, boid.flockID, neighbors.sameFlock, neighbors.otherFlocks);
+    }
 
-                const Vector3 directionToNeighbor = MathHelper::GetNormalized(neighbor->GetPosition() - boid.GetPosition());
-                return boid.GetSteeringDirection().Dot(directionToNeighbor) < m_neighborsDetectionDotThreshold;
-            }),
-        neighbors.end());
+    for (std::vector<Boid*>* group : { &neighbors.sameFlock, &neighbors.otherFlocks })
+    {
+        group->erase(
+            std::remove_if(group->begin(), group->end(),
+                [&](const Boid* neighbor)
+                {
+                    return !IsInFieldOfView(boid, *neighbor);
+                }),
+            group->end());
+    }
 
     return neighbors;
 }
 
-Vector3 BoidSteeringController::GetCohesionSteering(const Boid& boid, const std::vector<Boid*>& neighbors) const
+Vector3 BoidSteeringController::GetCohesionSteering(const Boid& boid, const std::vector<Boid*>& sameFlockNeighbors) const
 {
-    Vector3 averagePosition = Vector3::Zero;
-    int validNeighbors = 0;
+    Vector3 positionSum = Vector3::Zero;
 
-    for (const Boid* neighbor : neighbors)
+    for (const Boid* neighbor : sameFlockNeighbors)
     {
-        if (neighbor->flockID == boid.flockID)
-        {
-            ++validNeighbors;
-            averagePosition += neighbor->GetPosition();
-        }
+        positionSum += neighbor->GetPosition();
     }
 
-    if (validNeighbors == 0)
+    return GetCohesionSteering(boid, positionSum, static_cast<int>(sameFlockNeighbors.size()));
+}
+
+Vector3 BoidSteeringController::GetCohesionSteering(const Boid& boid, Vector3 positionSum, int count) const
+{
+    if (count == 0)
     {
         return Vector3::Zero;
     }
 
-    averagePosition /= static_cast<float>(validNeighbors);
-
-    const Vector3 steering = MathHelper::GetNormalized(averagePosition - boid.GetPosition());
+    const Vector3 averagePosition = positionSum / static_cast<float>(count);
+    const Vector3 steering = MathHelper::GetNormalizedFast(averagePosition - boid.GetPosition());
     return steering * m_cohesionMultiplier;
 }
 
-Vector3 BoidSteeringController::GetAlignmentSteering(const Boid& boid, const std::vector<Boid*>& neighbors) const
+Vector3 BoidSteeringController::GetAlignmentSteering(const Boid& boid, const std::vector<Boid*>& sameFlockNeighbors) const
 {
-    Vector3 steering = Vector3::Zero;
-    int validNeighbors = 0;
+    Vector3 directionSum = Vector3::Zero;
 
-    for (const Boid* neighbor : neighbors)
+    for (const Boid* neighbor : sameFlockNeighbors)
     {
-        if (neighbor->flockID == boid.flockID)
-        {
-            ++validNeighbors;
-            steering += neighbor->GetSteeringDirection();
-        }
+        directionSum += neighbor->GetSteeringDirection();
     }
 
-    if (validNeighbors == 0)
+    return GetAlignmentSteering(boid, directionSum, static_cast<int>(sameFlockNeighbors.size()));
+}
+
+Vector3 BoidSteeringController::GetAlignmentSteering(const Boid& boid, Vector3 directionSum, int count) const
+{
+    if (count == 0)
     {
         return Vector3::Zero;
     }
 
-    steering -= boid.GetSteeringDirection(); // This is before division so the steering is smoother
-    steering /= static_cast<float>(validNeighbors);
+    Vector3 steering = directionSum - boid.GetSteeringDirection(); // This is before division so the steering is smoother
+    steering /= static_cast<float>(count);
     return steering * m_alignmentMultiplier;
 }
 
-Vector3 BoidSteeringController::GetSeparationSteering(const Boid& boid, const std::vector<Boid*>& neighbors) const
+Vector3 BoidSteeringController::GetSeparationSteering(const Boid& boid, const BoidNeighbors& neighbors) const
 {
-    Vector3 steering = Vector3::Zero;
+    // Vectors from all neighbors are gathered first so they're normalized in one batch, buffers are reused per steering thread
+    thread_local std::vector<Vector3> vectorsFromNeighbors;
+    thread_local std::vector<float> pushRatios;
+    vectorsFromNeighbors.clear();
+    pushRatios.clear();
 
-    for (const Boid* neighbor : neighbors)
+    for (const std::vector<Boid*>* group : { &neighbors.sameFlock, &neighbors.otherFlocks })
+    {
+        for (const Boid* neighbor : *group)
+        {
+            const Vector3 vector_from_neighbor = boid.GetPosition() - neighbor->GetPosition();
+            vectorsFromNeighbors.push_back(vector_from_neighbor);
+            pushRatios.push_back(1.0f - (vector_from_neighbor.LengthSquared() / m_neighborsDetectionRadiusSquared));
+        }
+    }
+
+    MathHelper::GetNormalizedFast(vectorsFromNeighbors.data(), vectorsFromNeighbors.data(), vectorsFromNeighbors.size());
+
+    Vector3 steering = Vector3::Zero;
+    for (size_t i = 0; i < vectorsFromNeighbors.size(); i++)
     {
-        const Vector3 vector_from_neighbor = boid.GetPosition() - neighbor->GetPosition();
-        const float push_ratio = 1.0f - (vector_from_neighbor.LengthSquared() / NEIGHBORS_DETECTION_RADIUS_SQUARED);
-        steering += MathHelper::GetNormalized(vector_from_neighbor) * push_ratio;
+        steering += vectorsFromNeighbors[i] * pushRatios[i];
     }
 
     return steering * m_separationMultiplier;
@@ -1,19 +1,53 @@
 ﻿#pragma once
+#include "BoidNeighborCache.h"
+#include "SimulationParameters.h"
 
 class Game;
 class BoidManager;
 class Boid;
 
+enum class FlockingMode
+{
+    Exact,          // Cohesion / Alignment / Separation from every neighbor in radius
+    CellAggregate   // Exact neighbors from the boid's own cell, per flock cell aggregates for the adjacent ones
+};
+
+struct BoidNeighbors
+{
+    std::vector<Boid*> sameFlock;
+    std::vector<Boid*> otherFlocks;
+
+    bool IsEmpty() const { return sameFlock.empty() && otherFlocks.empty(); }
+};
+
 class BoidSteeringController
 {
 public:
     BoidSteeringController(const BoidManager& boidManager, const Game& game);
-    Vector3 GetBoidSteering(const Boid& boid) const;
+
+    // Steering parts that don't depend on neighbors are computed for the whole batch in one sweep,
+    // GetBoidSteering then reads them by the boid's index in the batch
+    void PrepareSteeringBatch(const std::vector<Boid*>& boids);
+    Vector3 GetBoidSteering(const Boid& boid, size_t batchIndex) const;
+
+    void ApplyParameters(const SimulationParameters& parameters);
+
+    float GetNeighborsDetectionRadius() const { return m_neighborsDetectionRadius; }
+    FlockingMode GetFlockingMode() const { return m_flockingMode; }
+    void SetFlockingMode(FlockingMode flockingMode);
+
+    // Average relative error of the CellAggregate flocking steering against the Exact one
+    float MeasureAggregateError(const std::vector<const Boid*>& sampleBoids) const;
+
+    BoidNeighborCache& GetNeighborCache() { return m_neighborCache; }
+    const BoidNeighborCache& GetNeighborCache() const { return m_neighborCache; }
 
 private:
     const BoidManager& m_boidManager;
     const Game& m_game;
 
+    float m_neighborsDetectionRadius;
+    float m_neighborsDetectionRadiusSquared;
     float m_neighborsDetectionDotThreshold;
     float m_boundsMultiplier;
     float m_cameraMultiplier;
@@ -23,13 +57,27 @@ private:
     float m_alignmentMultiplier;
     float m_separationMultiplier;
 
-    Vector3 GetBoundsSteering(const Boid& boid) const;
+    FlockingMode m_flockingMode;
+    BoidNeighborCache m_neighborCache; // Only kept up to date in Exact mode, invalidated on every mode change
+
+    // Structure of arrays so the bounds sweep vectorizes, inputs are overwritten with the results in place
+    std::vector<float> m_batchX;
+    std::vector<float> m_batchY;
+    std::vector<float> m_batchZ;
+
+    void UpdateBoundsSteering(size_t count);
     Vector3 GetCameraSteering(const Boid& boid) const;
     Vector3 GetProjectileSteering(const Boid& boid) const;
     Vector3 GetSkyscrapersSteering(const Boid& boid) const;
 
-    std::vector<Boid*> GetBoidNeighbors(const Boid& boid) const;
-    Vector3 GetCohesionSteering(const Boid& boid, const std::vector<Boid*>& neighbors) const;
-    Vector3 GetAlignmentSteering(const Boid& boid, const std::vector<Boid*>& neighbors) const;
-    Vector3 GetSeparationSteering(const Boid& boid, const std::vector<Boid*>& neighbors) const;
+    bool GetExactFlockingSteering(const Boid& boid, Vector3& steering, bool isCacheAllowed = true) const;
+    bool GetAggregateFlockingSteering(const Boid& boid, Vector3& steering) const;
+
+    bool IsInFieldOfView(const Boid& boid, const Boid& neighbor) const;
+    BoidNeighbors GetBoidNeighbors(const Boid& boid, bool isCacheAllowed = true) const;
+    Vector3 GetCohesionSteering(const Boid& boid, const std::vector<Boid*>& sameFlockNeighbors) const;
+    Vector3 GetCohesionSteering(const Boid& boid, Vector3 positionSum, int count) const;
+    Vector3 GetAlignmentSteering(const Boid& boid, const std::vector<Boid*>& sameFlockNeighbors) const;
+    Vector3 GetAlignmentSteering(const Boid& boid, Vector3 directionSum, int count) const;
+    Vector3 GetSeparationSteering(const Boid& boid, const BoidNeighbors& neighbors) const;
 };
@@ -0,0 +1,101 @@
+#include "pch.h"
+#include "BoidSteeringScheduler.h"
+
+#include "BoidManager.h"
+#include "Game.h"
+
+namespace
+{
+    constexpr int MIN_SCHEDULED_BOIDS = 64;
+    constexpr float INITIAL_COST_PER_BOID_MILLISECONDS = 0.002f;
+    constexpr float COST_SMOOTHING_FACTOR = 0.1f; // Exponential moving average, so one spiky frame doesn't starve the next ones
+
+    constexpr float PROJECTILE_PRIORITY_RADIUS_SQUARED = 100.0f;
+    constexpr float CAMERA_PRIORITY_RADIUS_SQUARED = 25.0f;
+    constexpr float PROXIMITY_PRIORITY_MULTIPLIER = 4.0f;
+}
+
+BoidSteeringScheduler::BoidSteeringScheduler(const Game& game, float budgetMilliseconds)
+    : m_game(game)
+    , m_budgetMilliseconds(budgetMilliseconds)
+    , m_costPerBoidMilliseconds(INITIAL_COST_PER_BOID_MILLISECONDS)
+    , m_lastSteeringMilliseconds(0.0f)
+{
+}
+
+const std::vector<Boid*>& BoidSteeringScheduler::ScheduleBoids(const std::vector<Boid*>& boids)
+{
+    m_scheduledBoids.clear();
+
+    const int affordableCount = static_cast<int>(m_budgetMilliseconds / m_costPerBoidMilliseconds);
+    const int scheduledCount = std::min<int>(boids.size(), std::max(MIN_SCHEDULED_BOIDS, affordableCount));
+
+    if (scheduledCount == static_cast<int>(boids.size()))
+    {
+        m_scheduledBoids.assign(boids.begin(), boids.end());
+
+        return m_scheduledBoids;
+    }
+
+    m_candidates.clear();
+    m_candidates.reserve(boids.size());
+
+    for (Boid* boid : boids)
+    {
+        m_candidates.emplace_back(GetPriority(*boid), boid);
+    }
+
+    // Only the split matters, order inside the scheduled part is irrelevant
+    std::nth_element(m_candidates.begin(), m_candidates.begin() + scheduledCount, m_candidates.end(),
+        [](const std::pair<float, Boid*>& a, const std::pair<float, Boid*>& b) { return a.first > b.first; });
+
+    m_scheduledBoids.reserve(scheduledCount);
+    for (int i = 0; i < scheduledCount; i++)
+    {
+        m_scheduledBoids.push_back(m_candidates[i].second);
+    }
+
+    return m_scheduledBoids;
+}
+
+void BoidSteeringScheduler::BeginSteering()
+{
+    m_steeringStartTime = std::chrono::high_resolution_clock::now();
+}
+
+void BoidSteeringScheduler::EndSteering()
+{
+    const std::chrono::duration<float, std::milli> elapsed = std::chrono::high_resolution_clock::now() - m_steeringStartTime;
+    m_lastSteeringMilliseconds = elapsed.count();
+
+    if (m_scheduledBoids.empty())
+    {
+        return;
+    }
+
+    const float measuredCost = m_lastSteeringMilliseconds / static_cast<float>(m_scheduledBoids.size());
+    m_costPerBoidMilliseconds += (measuredCost - m_costPerBoidMilliseconds) * COST_SMOOTHING_FACTOR;
+    m_costPerBoidMilliseconds = std::max(m_costPerBoidMilliseconds, std::numeric_limits<float>::epsilon());
+}
+
+float BoidSteeringScheduler::GetPriority(const Boid& boid) const
+{
+    float proximity = 0.0f;
+
+    const float distanceSquaredToCamera = (boid.GetPosition() - m_game.GetSimulationCamera().GetCameraPos()).LengthSquared();
+    if (distanceSquaredToCamera < CAMERA_PRIORITY_RADIUS_SQUARED)
+    {
+        proximity = std::max(proximity, 1.0f - distanceSquaredToCamera / CAMERA_PRIORITY_RADIUS_SQUARED);
+    }
+
+    for (const Projectile& projectile : m_game.GetProjectileController().GetProjectiles())
+    {
+        const float distanceSquaredToProjectile = (boid.GetPosition() - projectile.GetPosition()).LengthSquared();
+        if (distanceSquaredToProjectile < PROJECTILE_PRIORITY_RADIUS_SQUARED)
+        {
+            proximity = std::max(proximity, 1.0f - distanceSquaredToProjectile / PROJECTILE_PRIORITY_RADIUS_SQUARED);
+        }
+    }
+
+    return boid.steeringStaleness * (1.0f + proximity * PROXIMITY_PRIORITY_MULTIPLIER);
+}
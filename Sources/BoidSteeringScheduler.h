@@ -0,0 +1,36 @@
+#pragma once
+#include <chrono>
+
+class Game;
+class Boid;
+
+// Decides each frame which boids get fresh steering, so the steering cost stays within a millisecond budget.
+class BoidSteeringScheduler
+{
+public:
+    BoidSteeringScheduler(const Game& game, float budgetMilliseconds);
+
+    const std::vector<Boid*>& ScheduleBoids(const std::vector<Boid*>& boids);
+
+    void BeginSteering();
+    void EndSteering();
+
+    float GetBudget() const { return m_budgetMilliseconds; }
+    void SetBudget(float budgetMilliseconds) { m_budgetMilliseconds = std::max(0.0f, budgetMilliseconds); }
+
+    float GetLastSteeringTime() const { return m_lastSteeringMilliseconds; }
+    int GetLastScheduledCount() const { return static_cast<int>(m_scheduledBoids.size()); }
+
+private:
+    float GetPriority(const Boid& boid) const;
+
+    const Game& m_game;
+
+    float m_budgetMilliseconds;
+    float m_costPerBoidMilliseconds;
+    float m_lastSteeringMilliseconds;
+
+    std::chrono::high_resolution_clock::time_point m_steeringStartTime;
+    std::vector<std::pair<float, Boid*>> m_candidates;
+    std::vector<Boid*> m_scheduledBoids;
+};
@@ -3,6 +3,14 @@
 
 #include "MathHelper.h"
 
+namespace
+{
+    float GetAxis(const Vector3& vector, int axis)
+    {
+        return (&vector.x)[axis];
+    }
+}
+
 Bounds::Bounds(Vector3 center, Vector3 size)
     :center(center)
     , size(size)
@@ -32,6 +40,11 @@ bool Bounds::RadiusIntersects(const Bounds& other) const
     return Vector3::DistanceSquared(center, other.center) <= GetBiggestExtentSquared() + other.GetBiggestExtentSquared();
 }
 
+bool Bounds::RadiusIntersects(Vector3 sphereCenter, float sphereRadius) const
+{
+    return Vector3::DistanceSquared(center, sphereCenter) <= GetBiggestExtentSquared() + sphereRadius * sphereRadius;
+}
+
 bool Bounds::IntersectsSphere(const Bounds& sphere) const
 {
     const Vector3 closestPoint = ClosestPoint(sphere.center);
@@ -144,4 +157,88 @@ void Bounds::UpdateBounds(Vector3 newCenter)
     center = newCenter;
     min = center - extents;
     max = center + extents;
-}
\ No newline at end of file
+}
+
+bool Bounds::SweepSphere(Vector3 start, Vector3 displacement, float radius, float& timeOfImpact, Vector3& normal) const
+{
+    // The sphere center touches the bounds grown by radius with rounded edges and corners. Per axis the center starts outside of, or moves towards,
+    // only one side can be touched first, and every combination of those sides is one feature of the rounded bounds:
+    // a face (one axis), an edge cylinder (two axes) or a corner sphere (all three). The impact is the earliest valid entry into any of them
+    int sides[3];
+    float planes[3];
+    for (int axis = 0; axis < 3; axis++)
+    {
+        const float startValue = GetAxis(start, axis);
+        const float direction = GetAxis(displacement, axis);
+        const bool isBelow = startValue < GetAxis(min, axis) || (startValue <= GetAxis(max, axis) && direction < 0.0f);
+        const bool isAbove = startValue > GetAxis(max, axis) || (startValue >= GetAxis(min, axis) && direction > 0.0f);
+        sides[axis] = isBelow ? -1 : (isAbove ? 1 : 0);
+        planes[axis] = isBelow ? GetAxis(min, axis) : GetAxis(max, axis);
+    }
+
+    float bestTime = std::numeric_limits<float>::max();
+    for (int featureAxes = 1; featureAxes < 8; featureAxes++)
+    {
+        // Squared distance to the feature along the path is a * t^2 + b * t + c + radius^2
+        float a = 0.0f;
+        float b = 0.0f;
+        float c = -radius * radius;
+        bool isReachable = true;
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            if (featureAxes & (1 << axis))
+            {
+                const float offset = GetAxis(start, axis) - planes[axis];
+                const float direction = GetAxis(displacement, axis);
+                a += direction * direction;
+                b += 2.0f * direction * offset;
+                c += offset * offset;
+                isReachable &= sides[axis] != 0;
+            }
+        }
+
+        // Already within radius of the feature (c <= 0): either overlapping, or the feature isn't the closest part and another one is hit first
+        const float discriminant = b * b - 4.0f * a * c;
+        if (!isReachable || c <= 0.0f || a <= 0.0f || discriminant < 0.0f)
+        {
+            continue;
+        }
+
+        const float time = (-b - std::sqrt(discriminant)) / (2.0f * a);
+        if (time < 0.0f || time > 1.0f || time >= bestTime)
+        {
+            continue;
+        }
+
+        // Only counts where this feature is the closest part of the bounds: past its sides on its axes, within the bounds on the others
+        bool isValid = true;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            const float value = GetAxis(start, axis) + GetAxis(displacement, axis) * time;
+            if (featureAxes & (1 << axis))
+            {
+                isValid &= sides[axis] < 0 ? value <= planes[axis] : value >= planes[axis];
+            }
+            else
+            {
+                isValid &= value >= GetAxis(min, axis) && value <= GetAxis(max, axis);
+            }
+        }
+
+        if (isValid)
+        {
+            bestTime = time;
+        }
+    }
+
+    if (bestTime > 1.0f)
+    {
+        return false;
+    }
+
+    const Vector3 contactCenter = start + displacement * bestTime;
+    normal = MathHelper::GetNormalized(contactCenter - ClosestPoint(contactCenter));
+    timeOfImpact = bestTime;
+    return true;
+}
@@ -18,10 +18,14 @@ struct Bounds
     bool Contains(Vector3 point) const;
     bool Intersects(const Bounds& other) const;
     bool RadiusIntersects(const Bounds& other) const;
+    bool RadiusIntersects(Vector3 sphereCenter, float sphereRadius) const;
     bool IntersectsSphere(const Bounds& sphere) const;
     Vector3 ClosestPoint(Vector3 point) const;
     Vector3 ClosestPointOnBounds(Vector3 point) const;
     Vector3 ClosestSurfaceNormal(Vector3 point) const;
+    // First contact of a sphere moving from start by displacement, timeOfImpact is the fraction of displacement travelled.
+    // A sphere already touching the bounds at start doesn't count as a hit, resolve overlaps before sweeping
+    bool SweepSphere(Vector3 start, Vector3 displacement, float radius, float& timeOfImpact, Vector3& normal) const;
 };
 
 
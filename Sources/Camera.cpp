@@ -81,6 +81,16 @@ void Camera::OnUpdate( float deltaTime, DirectX::Keyboard& keyboard, DirectX::Mo
 	engine.LookAt( m_cameraPos, lookAt );
 }
 
+void Camera::SetPose( Vector3 position, Vector3 direction )
+{
+	direction.Normalize();
+
+	m_cameraPos = m_desiredPos = position;
+	m_cameraDir = m_desiredDir = direction;
+	m_pitch = asinf( direction.y );
+	m_yaw = atan2f( direction.x, direction.z );
+}
+
 void Camera::RotationInput( DirectX::Mouse& mouse, DirectX::GamePad& gamepad )
 {
 	// GamePad
@@ -12,6 +12,9 @@ public:
 	Vector3 GetCameraDir() const { return m_cameraDir; }
 	Vector3 GetMovementInput() const { return m_moveInput; }
 
+	// Places the camera without smoothing, used by scripted camera paths
+	void SetPose( Vector3 position, Vector3 direction );
+
 private:
 	void RotationInput( DirectX::Mouse& mouse, DirectX::GamePad& gamepad );
 	Vector3 MovementInput( DirectX::Keyboard& keyboard, DirectX::GamePad& gamepad );
@@ -8,6 +8,13 @@
 #include "StepTimer.h"
 #include "DeviceResources.h"
 #include "Game.h"
+#include <iostream>
+
+namespace
+{
+	constexpr const char* COMPILED_CITY_PATH = "../../data/city/city.bcity";
+	constexpr const char* JSON_CITY_PATH = "../../data/city/city.json";
+}
 
 City::City() = default;
 City::~City() = default;
@@ -23,70 +30,93 @@ void City::Load()
 {
 	OnShutdown();
 
-	std::ifstream stream( "../../data/city/city.json" );
-	std::string fileData( ( std::istreambuf_iterator< char >( stream ) ), std::istreambuf_iterator< char >() );
+	// Compiled city first, the json is only the fallback for cities that weren't converted yet
+	const bool loaded = LoadCompiled( COMPILED_CITY_PATH ) || LoadJson( JSON_CITY_PATH );
+	assert( loaded );
+	UNREFERENCED_PARAMETER( loaded );
 
-	Json::Document document;
-	document.Parse( fileData.c_str() );
-	assert( !document.HasParseError() );
+	m_shape = GetEngine().CreateBoxPrimitive(Vector3::One);
+}
+
+bool City::LoadCompiled( const std::string& path )
+{
+	if ( !m_compiledFile.Open( path ) )
+	{
+		return false;
+	}
 
-	assert( document.IsObject() );
+	// Written by another version or with another Bounds layout, rebuild it with CityConverter
+	if ( !m_city.Open( m_compiledFile.GetData(), m_compiledFile.GetSize() ) )
+	{
+		std::cerr << "Compiled city " << path << " doesn't match this build, falling back to json" << std::endl;
+		m_compiledFile.Close();
+		return false;
+	}
 
-	// skyscrapers
-	assert( document.HasMember( "skyscrapers" ) );
-	const Json::Value& arrayObject = document[ "skyscrapers" ];
-	assert( arrayObject.IsArray() );
+	return true;
+}
 
-	m_skyscrapers.reserve(arrayObject.Size());
-	m_highestSkyscraperYPos = std::numeric_limits<float>::min();
-	for ( Json::SizeType i = 0; i < arrayObject.Size(); i++ )
+bool City::LoadJson( const std::string& path )
+{
+	MappedFile jsonFile;
+	if ( !jsonFile.Open( path ) )
 	{
-		Entity newSkyscraper;
+		return false;
+	}
 
-		Vector3 position;
-        Vector3 dimensions;
+	std::vector< Bounds > skyscrapers;
+	if ( !CityFormat::ParseJson( jsonFile.GetData(), jsonFile.GetSize(), skyscrapers ) )
+	{
+		return false;
+	}
 
-        // pos_x
-        assert(arrayObject[ i ].HasMember( "pos_x" ));
-        assert(arrayObject[ i ][ "pos_x" ].IsFloat());
-        position.x = arrayObject[ i ][ "pos_x" ].GetFloat();
+	return Build( skyscrapers );
+}
 
-        // pos_z
-        assert(arrayObject[ i ].HasMember( "pos_z" ));
-        assert(arrayObject[ i ][ "pos_z" ].IsFloat());
-        position.z = arrayObject[ i ][ "pos_z" ].GetFloat();
+void City::Generate( const CityGeneratorSettings& settings )
+{
+	ClearSkyscrapers();
 
-        // width
-		assert( arrayObject[ i ].HasMember( "width" ) );
-		assert( arrayObject[ i ][ "width" ].IsFloat() );
-		dimensions.x = arrayObject[ i ][ "width" ].GetFloat();
+	std::vector< Bounds > skyscrapers;
+	CityGenerator::Generate( settings, skyscrapers );
 
-		// length
-		assert( arrayObject[ i ].HasMember( "length" ) );
-		assert( arrayObject[ i ][ "length" ].IsFloat() );
-		dimensions.z = arrayObject[ i ][ "length" ].GetFloat();
+	const bool built = Build( skyscrapers );
+	assert( built );
+	UNREFERENCED_PARAMETER( built );
+}
 
-		// height
-		assert( arrayObject[ i ].HasMember( "height" ) );
-		assert( arrayObject[ i ][ "height" ].IsFloat() );
-		dimensions.y = arrayObject[ i ][ "height" ].GetFloat();
+bool City::Build( const std::vector< Bounds >& skyscrapers )
+{
+	CityFormat::Build( skyscrapers, m_builtImage );
+	return m_city.Open( m_builtImage.data(), m_builtImage.size() );
+}
 
-		position.y = arrayObject[i].HasMember("pos_y") ? arrayObject[i]["pos_y"].GetFloat() : dimensions.y * 0.5f;
+void City::ClearSkyscrapers()
+{
+	m_city = CityFormat::View();
+	m_compiledFile.Close();
+	m_builtImage.clear();
+}
 
-		newSkyscraper.SetPosition(position);
-		newSkyscraper.SetBounds(newSkyscraper.GetPosition(), dimensions);
+bool City::SweepSphere( Vector3 start, Vector3 displacement, float radius, float& timeOfImpact, Vector3& normal ) const
+{
+	const Vector3 end = start + displacement;
+	const Vector3 margin = Vector3::One * radius;
 
-		const float maxYPos = newSkyscraper.GetBounds().max.y;
-		if(maxYPos > m_highestSkyscraperYPos)
+	bool isHit = false;
+	ForEachSkyscraperInRange( Vector3::Min( start, end ) - margin, Vector3::Max( start, end ) + margin, [ & ]( const Bounds& skyscraper )
+	{
+		float skyscraperTimeOfImpact;
+		Vector3 skyscraperNormal;
+		if ( skyscraper.SweepSphere( start, displacement, radius, skyscraperTimeOfImpact, skyscraperNormal ) && ( !isHit || skyscraperTimeOfImpact < timeOfImpact ) )
 		{
-			m_highestSkyscraperYPos = maxYPos;
+			isHit = true;
+			timeOfImpact = skyscraperTimeOfImpact;
+			normal = skyscraperNormal;
 		}
+	} );
 
-		m_skyscrapers.push_back( std::move( newSkyscraper ) );
-		//m_skyscrapersOctree.AddEntity(&m_skyscrapers.back());
-	}
-
-	m_shape = GetEngine().CreateBoxPrimitive(Vector3::One);
+	return isHit;
 }
 
 void City::OnUpdate( float deltaTime )
@@ -96,9 +126,10 @@ void City::OnUpdate( float deltaTime )
 
 void City::OnRender( framework::RenderContextPtr& renderContext )
 {
-	for ( Entity& skyscraper : m_skyscrapers )
+	const Bounds* skyscrapers = m_city.GetSkyscrapers();
+	for ( size_t i = 0; i < m_city.GetSkyscrapersCount(); i++ )
 	{
-		renderContext->RenderPrimitive(m_shape, skyscraper.GetBounds().size, skyscraper.GetPosition(), Vector3::Zero, Colors::BlueViolet );
+		renderContext->RenderPrimitive(m_shape, skyscrapers[ i ].size, skyscrapers[ i ].center, Vector3::Zero, Colors::BlueViolet );
 	}
 
 	//m_skyscrapersOctree.OnRender(renderContext);
@@ -107,5 +138,5 @@ void City::OnRender( framework::RenderContextPtr& renderContext )
 void City::OnShutdown()
 {
 	m_shape.reset();
-	m_skyscrapers.clear();
+	ClearSkyscrapers();
 }
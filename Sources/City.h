@@ -4,8 +4,11 @@
 
 #pragma once
 #include "Bounds.h"
+#include "CityFormat.h"
+#include "CityGenerator.h"
 #include "Entity.h"
 #include "IRenderContext.h"
+#include "MappedFile.h"
 #include "Octree.h"
 #include "SpatialHashGrid.h"
 
@@ -21,17 +24,34 @@ public:
 	void OnRender( framework::RenderContextPtr& renderContext );
 	void OnShutdown();
 
-	float GetHighestSkyscraperYPos() const { return m_highestSkyscraperYPos; }
-	const std::vector< Entity >& GetSkyscrapers() const { return m_skyscrapers; }
+	// Replaces the loaded skyscrapers with a generated city, only between simulation steps
+	void Generate( const CityGeneratorSettings& settings );
+
+	// Lowest float without a city, so everything counts as above it
+	float GetHighestSkyscraperYPos() const { return m_city.IsOpen() ? m_city.GetHeader().highestSkyscraperYPos : std::numeric_limits< float >::lowest(); }
+	size_t GetSkyscrapersCount() const { return m_city.GetSkyscrapersCount(); }
+	const Bounds* GetSkyscrapers() const { return m_city.GetSkyscrapers(); }
+
+	// Only visits skyscrapers whose bounds overlap the range, through the precomputed grid
+	template< typename Func >
+	void ForEachSkyscraperInRange( Vector3 min, Vector3 max, Func&& func ) const { m_city.ForEachSkyscraperInRange( min, max, std::forward< Func >( func ) ); }
+	// Earliest skyscraper a moving sphere hits (see Bounds::SweepSphere), only skyscrapers along the path are tested
+	bool SweepSphere( Vector3 start, Vector3 displacement, float radius, float& timeOfImpact, Vector3& normal ) const;
 	//const Octree<Skyscraper>& GetSkyscrapersOctree() const { return m_skyscrapersOctree; }
 
 private:
     void Load();
-
-	float m_highestSkyscraperYPos = 0.0f;
+	bool LoadCompiled( const std::string& path );
+	bool LoadJson( const std::string& path );
+	bool Build( const std::vector< Bounds >& skyscrapers );
+	void ClearSkyscrapers();
 
 	//Octree<Skyscraper> m_skyscrapersOctree;
-	std::vector< Entity > m_skyscrapers;
+
+	// Either the compiled city mapped in place, or an image built in memory from the legacy json
+	MappedFile m_compiledFile;
+	std::vector< uint8_t > m_builtImage;
+	CityFormat::View m_city;
 	std::unique_ptr< DirectX::GeometricPrimitive > m_shape;
 };
 
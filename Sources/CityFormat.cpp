@@ -0,0 +1,296 @@
+#include "pch.h"
+#include "CityFormat.h"
+
+namespace
+{
+    constexpr size_t SECTION_ALIGNMENT = 16;
+    constexpr float MIN_CELL_SIZE = 1.0f;
+    constexpr float CELL_SIZE_FOOTPRINT_MULTIPLIER = 2.0f;
+    constexpr uint32_t MAX_CELLS_PER_SKYSCRAPER = 4;
+
+    size_t AlignOffset(size_t offset)
+    {
+        return (offset + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1);
+    }
+
+    /// Fills skyscrapers while the reader walks the json, only the fields of objects inside the root "skyscrapers" array are picked up.
+    class SkyscrapersHandler : public Json::BaseReaderHandler<Json::UTF8<>, SkyscrapersHandler>
+    {
+    public:
+        explicit SkyscrapersHandler(std::vector<Bounds>& skyscrapers)
+            : m_skyscrapers(skyscrapers)
+        {
+        }
+
+        bool Null() { return true; }
+        bool Bool(bool) { return true; }
+        bool Int(int value) { return Number(static_cast<float>(value)); }
+        bool Uint(unsigned value) { return Number(static_cast<float>(value)); }
+        bool Int64(int64_t value) { return Number(static_cast<float>(value)); }
+        bool Uint64(uint64_t value) { return Number(static_cast<float>(value)); }
+        bool Double(double value) { return Number(static_cast<float>(value)); }
+        bool String(const char*, Json::SizeType, bool) { return true; }
+
+        bool Key(const char* name, Json::SizeType length, bool)
+        {
+            const std::string_view key(name, length);
+
+            if (m_depth == 1)
+            {
+                m_isSkyscrapersKey = key == "skyscrapers";
+            }
+            else if (m_depth == SKYSCRAPER_DEPTH && m_isInSkyscrapers)
+            {
+                m_field = GetField(key);
+            }
+
+            return true;
+        }
+
+        bool StartObject()
+        {
+            ++m_depth;
+
+            if (m_depth == SKYSCRAPER_DEPTH && m_isInSkyscrapers)
+            {
+                m_values = {};
+                m_foundFields = 0;
+            }
+
+            return true;
+        }
+
+        bool EndObject(Json::SizeType)
+        {
+            if (m_depth == SKYSCRAPER_DEPTH && m_isInSkyscrapers)
+            {
+                // pos_y is optional, skyscrapers stand on the ground by default
+                constexpr uint32_t requiredFields = (1 << PosX) | (1 << PosZ) | (1 << Width) | (1 << Length) | (1 << Height);
+                if ((m_foundFields & requiredFields) != requiredFields)
+                {
+                    return false;
+                }
+
+                const Vector3 size(m_values[Width], m_values[Height], m_values[Length]);
+                const float positionY = m_foundFields & (1 << PosY) ? m_values[PosY] : size.y * 0.5f;
+                m_skyscrapers.emplace_back(Vector3(m_values[PosX], positionY, m_values[PosZ]), size);
+            }
+
+            --m_depth;
+            return true;
+        }
+
+        bool StartArray()
+        {
+            ++m_depth;
+            m_isInSkyscrapers = m_depth == SKYSCRAPER_DEPTH - 1 && m_isSkyscrapersKey;
+            return true;
+        }
+
+        bool EndArray(Json::SizeType)
+        {
+            if (m_depth == SKYSCRAPER_DEPTH - 1)
+            {
+                m_isInSkyscrapers = false;
+            }
+
+            --m_depth;
+            return true;
+        }
+
+    private:
+        static constexpr int SKYSCRAPER_DEPTH = 3; // root object, skyscrapers array, skyscraper object
+
+        enum Field
+        {
+            PosX,
+            PosY,
+            PosZ,
+            Width,
+            Length,
+            Height,
+            FieldsCount,
+            None = FieldsCount
+        };
+
+        static Field GetField(std::string_view key)
+        {
+            static constexpr std::array<std::string_view, FieldsCount> fieldNames = { "pos_x", "pos_y", "pos_z", "width", "length", "height" };
+
+            for (int i = 0; i < FieldsCount; i++)
+            {
+                if (key == fieldNames[i])
+                {
+                    return static_cast<Field>(i);
+                }
+            }
+
+            return None;
+        }
+
+        bool Number(float value)
+        {
+            if (m_depth == SKYSCRAPER_DEPTH && m_isInSkyscrapers && m_field != None)
+            {
+                m_values[m_field] = value;
+                m_foundFields |= 1 << m_field;
+                m_field = None;
+            }
+
+            return true;
+        }
+
+        std::vector<Bounds>& m_skyscrapers;
+        std::array<float, FieldsCount> m_values = {};
+        uint32_t m_foundFields = 0;
+        Field m_field = None;
+        int m_depth = 0;
+        bool m_isSkyscrapersKey = false;
+        bool m_isInSkyscrapers = false;
+    };
+}
+
+namespace CityFormat
+{
+    bool ParseJson(const char* data, size_t size, std::vector<Bounds>& skyscrapers)
+    {
+        skyscrapers.clear();
+
+        Json::MemoryStream stream(data, size);
+        Json::Reader reader;
+        SkyscrapersHandler handler(skyscrapers);
+
+        return !reader.Parse(stream, handler).IsError();
+    }
+
+    void Build(const std::vector<Bounds>& skyscrapers, std::vector<uint8_t>& image)
+    {
+        Header header = {};
+        header.magic = MAGIC;
+        header.version = VERSION;
+        header.skyscraperRecordSize = sizeof(Bounds);
+        header.skyscrapersCount = static_cast<uint32_t>(skyscrapers.size());
+
+        // City extents and the average footprint, the grid cell is sized so a cell holds a couple of skyscrapers
+        header.boundsMin = skyscrapers.empty() ? Vector3::Zero : skyscrapers.front().min;
+        header.boundsMax = skyscrapers.empty() ? Vector3::Zero : skyscrapers.front().max;
+        header.highestSkyscraperYPos = std::numeric_limits<float>::lowest();
+        float footprintSum = 0.0f;
+
+        for (const Bounds& skyscraper : skyscrapers)
+        {
+            header.boundsMin = Vector3::Min(header.boundsMin, skyscraper.min);
+            header.boundsMax = Vector3::Max(header.boundsMax, skyscraper.max);
+            header.highestSkyscraperYPos = std::max(header.highestSkyscraperYPos, skyscraper.max.y);
+            header.maxHalfFootprintX = std::max(header.maxHalfFootprintX, skyscraper.extents.x);
+            header.maxHalfFootprintZ = std::max(header.maxHalfFootprintZ, skyscraper.extents.z);
+            footprintSum += std::max(skyscraper.size.x, skyscraper.size.z);
+        }
+
+        const float averageFootprint = skyscrapers.empty() ? 0.0f : footprintSum / static_cast<float>(skyscrapers.size());
+        const float citySizeX = header.boundsMax.x - header.boundsMin.x;
+        const float citySizeZ = header.boundsMax.z - header.boundsMin.z;
+
+        // Never more cells than a few per skyscraper, a handful of huge outliers shouldn't blow up the grid
+        const float maxCellsCount = static_cast<float>(std::max<size_t>(skyscrapers.size(), 1) * MAX_CELLS_PER_SKYSCRAPER);
+        header.cellSize = std::max({ averageFootprint * CELL_SIZE_FOOTPRINT_MULTIPLIER, MIN_CELL_SIZE, std::sqrt(citySizeX * citySizeZ / maxCellsCount) });
+        header.gridMinX = header.boundsMin.x;
+        header.gridMinZ = header.boundsMin.z;
+        header.gridSizeX = static_cast<uint32_t>(citySizeX / header.cellSize) + 1;
+        header.gridSizeZ = static_cast<uint32_t>(citySizeZ / header.cellSize) + 1;
+        header.cellsCount = header.gridSizeX * header.gridSizeZ;
+
+        header.skyscrapersOffset = AlignOffset(sizeof(Header));
+        header.cellStartsOffset = AlignOffset(header.skyscrapersOffset + skyscrapers.size() * sizeof(Bounds));
+        image.assign(header.cellStartsOffset + (header.cellsCount + 1) * sizeof(uint32_t), 0);
+
+        // Counting sort by center cell
+        std::vector<uint32_t> skyscraperCells(skyscrapers.size());
+        std::vector<uint32_t> cellStarts(header.cellsCount + 1, 0);
+
+        for (size_t i = 0; i < skyscrapers.size(); i++)
+        {
+            const uint32_t cellX = std::min(static_cast<uint32_t>((skyscrapers[i].center.x - header.gridMinX) / header.cellSize), header.gridSizeX - 1);
+            const uint32_t cellZ = std::min(static_cast<uint32_t>((skyscrapers[i].center.z - header.gridMinZ) / header.cellSize), header.gridSizeZ - 1);
+            skyscraperCells[i] = cellZ * header.gridSizeX + cellX;
+            ++cellStarts[skyscraperCells[i] + 1];
+        }
+
+        for (uint32_t i = 0; i < header.cellsCount; i++)
+        {
+            cellStarts[i + 1] += cellStarts[i];
+        }
+
+        std::vector<uint32_t> cellCursors(cellStarts.begin(), cellStarts.end() - 1);
+        Bounds* sortedSkyscrapers = reinterpret_cast<Bounds*>(image.data() + header.skyscrapersOffset);
+
+        for (size_t i = 0; i < skyscrapers.size(); i++)
+        {
+            sortedSkyscrapers[cellCursors[skyscraperCells[i]]++] = skyscrapers[i];
+        }
+
+        std::memcpy(image.data(), &header, sizeof(Header));
+        std::memcpy(image.data() + header.cellStartsOffset, cellStarts.data(), cellStarts.size() * sizeof(uint32_t));
+    }
+
+    bool View::Open(const void* data, size_t size)
+    {
+        m_header = nullptr;
+
+        if (size < sizeof(Header))
+        {
+            return false;
+        }
+
+        const Header* header = static_cast<const Header*>(data);
+        // Skyscrapers are the raw Bounds layout, a file written with a different one can't be used in place
+        if (header->magic != MAGIC || header->version != VERSION || header->skyscraperRecordSize != sizeof(Bounds))
+        {
+            return false;
+        }
+
+        const bool isGridValid = header->gridSizeX > 0 && header->gridSizeZ > 0
+                              && static_cast<uint64_t>(header->gridSizeX) * header->gridSizeZ == header->cellsCount
+                              && header->cellSize > 0.0f;
+        const bool areSectionsValid = header->skyscrapersOffset + static_cast<uint64_t>(header->skyscrapersCount) * sizeof(Bounds) <= size
+                                   && header->cellStartsOffset + (static_cast<uint64_t>(header->cellsCount) + 1) * sizeof(uint32_t) <= size;
+
+        if (!isGridValid || !areSectionsValid)
+        {
+            return false;
+        }
+
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        m_skyscrapers = reinterpret_cast<const Bounds*>(bytes + header->skyscrapersOffset);
+        m_cellStarts = reinterpret_cast<const uint32_t*>(bytes + header->cellStartsOffset);
+
+        // Queries index skyscrapers straight through the cell starts, so they have to be sorted and in range
+        for (uint32_t i = 0; i < header->cellsCount; i++)
+        {
+            if (m_cellStarts[i] > m_cellStarts[i + 1])
+            {
+                return false;
+            }
+        }
+
+        if (m_cellStarts[0] != 0 || m_cellStarts[header->cellsCount] != header->skyscrapersCount)
+        {
+            return false;
+        }
+
+        m_header = header;
+        return true;
+    }
+
+    int View::GetCellX(float x) const
+    {
+        const int cell = static_cast<int>(std::floor((x - m_header->gridMinX) / m_header->cellSize));
+        return std::clamp(cell, 0, static_cast<int>(m_header->gridSizeX) - 1);
+    }
+
+    int View::GetCellZ(float z) const
+    {
+        const int cell = static_cast<int>(std::floor((z - m_header->gridMinZ) / m_header->cellSize));
+        return std::clamp(cell, 0, static_cast<int>(m_header->gridSizeZ) - 1);
+    }
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include "Bounds.h"
+
+/// Compiled city, produced from the legacy city.json by the CityConverter tool (Tools/CityConverter.cpp).
+/// Header, then the skyscraper bounds sorted by their XZ grid cell, then the per cell start offsets (cellsCount + 1),
+/// so a cell's skyscrapers are one contiguous range and the whole file is used in place from a memory mapping, no parsing on load.
+/// Every skyscraper is only stored in the cell holding its center, queries widen their range by the biggest half footprint instead of duplicating entries.
+namespace CityFormat
+{
+    constexpr uint32_t MAGIC = 0x59544342; // "BCTY"
+    constexpr uint32_t VERSION = 2;
+
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t skyscrapersCount;
+        uint32_t cellsCount;
+
+        Vector3 boundsMin;
+        float highestSkyscraperYPos;
+        Vector3 boundsMax;
+        float cellSize;
+
+        float gridMinX;
+        float gridMinZ;
+        uint32_t gridSizeX;
+        uint32_t gridSizeZ;
+
+        float maxHalfFootprintX;
+        float maxHalfFootprintZ;
+        uint32_t skyscraperRecordSize; // sizeof(Bounds) of the writer, the records are mapped as is
+        uint32_t reserved;
+
+        uint64_t skyscrapersOffset;
+        uint64_t cellStartsOffset;
+    };
+
+    static_assert(std::is_trivially_copyable<Bounds>::value, "Bounds are stored as raw bytes");
+
+    // Streams the legacy json with a SAX reader, no DOM and no copy of the file
+    bool ParseJson(const char* data, size_t size, std::vector<Bounds>& skyscrapers);
+
+    // Sorts the skyscrapers into the grid and lays out the complete file image
+    void Build(const std::vector<Bounds>& skyscrapers, std::vector<uint8_t>& image);
+
+    /// Read only view over a file image, either memory mapped or built in memory.
+    class View
+    {
+    public:
+        bool Open(const void* data, size_t size);
+        bool IsOpen() const { return m_header != nullptr; }
+
+        const Header& GetHeader() const { return *m_header; }
+        size_t GetSkyscrapersCount() const { return m_header ? m_header->skyscrapersCount : 0; }
+        const Bounds* GetSkyscrapers() const { return m_skyscrapers; }
+
+        template<typename Func>
+        void ForEachSkyscraperInRange(Vector3 min, Vector3 max, Func&& func) const;
+
+    private:
+        int GetCellX(float x) const;
+        int GetCellZ(float z) const;
+
+        const Header* m_header = nullptr;
+        const Bounds* m_skyscrapers = nullptr;
+        const uint32_t* m_cellStarts = nullptr;
+    };
+
+    template<typename Func>
+    void View::ForEachSkyscraperInRange(Vector3 min, Vector3 max, Func&& func) const
+    {
+        if (!m_header || m_header->skyscrapersCount == 0 || min.y > m_header->boundsMax.y || max.y < m_header->boundsMin.y)
+        {
+            return;
+        }
+
+        const int minCellX = GetCellX(min.x - m_header->maxHalfFootprintX);
+        const int maxCellX = GetCellX(max.x + m_header->maxHalfFootprintX);
+        const int minCellZ = GetCellZ(min.z - m_header->maxHalfFootprintZ);
+        const int maxCellZ = GetCellZ(max.z + m_header->maxHalfFootprintZ);
+
+        for (int z = minCellZ; z <= maxCellZ; z++)
+        {
+            // Cells of a row are adjacent, so the whole row is one contiguous range of skyscrapers
+            const size_t rowStart = static_cast<size_t>(z) * m_header->gridSizeX;
+            const uint32_t begin = m_cellStarts[rowStart + minCellX];
+            const uint32_t end = m_cellStarts[rowStart + maxCellX + 1];
+
+            for (uint32_t i = begin; i < end; i++)
+            {
+                const Bounds& skyscraper = m_skyscrapers[i];
+                if (skyscraper.min.x <= max.x && skyscraper.max.x >= min.x &&
+                    skyscraper.min.y <= max.y && skyscraper.max.y >= min.y &&
+                    skyscraper.min.z <= max.z && skyscraper.max.z >= min.z)
+                {
+                    func(skyscraper);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,62 @@
+#include "pch.h"
+#include "CityGenerator.h"
+#include <random>
+
+namespace
+{
+    float RandomFromRange(std::mt19937& engine, float min, float max)
+    {
+        // Not std::uniform_real_distribution, its output isn't specified across standard libraries
+        const float unit = static_cast<float>(engine() >> 8) / static_cast<float>(1 << 24);
+        return min + (max - min) * unit;
+    }
+}
+
+namespace CityGenerator
+{
+    void Generate(const CityGeneratorSettings& settings, std::vector<Bounds>& skyscrapers)
+    {
+        skyscrapers.clear();
+
+        if (settings.skyscrapersCount <= 0 || settings.density <= 0.0f)
+        {
+            return;
+        }
+
+        skyscrapers.reserve(settings.skyscrapersCount);
+        // Own engine so generating a city never shifts the simulation's shared random sequence
+        std::mt19937 engine(settings.seed);
+
+        // Roughly square city, a row is as wide as the square of the expected plots count, rows are added until the count is reached
+        const float expectedPlotsCount = static_cast<float>(settings.skyscrapersCount) / std::min(settings.density, 1.0f);
+        const int blocksPerRow = std::max(1, static_cast<int>(std::ceil(std::sqrt(expectedPlotsCount) / settings.plotsPerBlockSide)));
+        const int plotsPerRow = blocksPerRow * settings.plotsPerBlockSide;
+        const float blockSize = settings.plotsPerBlockSide * settings.plotSize + settings.streetWidth;
+        const float citySide = blocksPerRow * blockSize - settings.streetWidth;
+        const Vector3 origin = settings.center - Vector3(citySide, 0.0f, citySide) * 0.5f;
+        const float maxFootprint = std::min(settings.maxFootprint, settings.plotSize);
+        const float minFootprint = std::min(settings.minFootprint, maxFootprint);
+
+        for (int plotIndex = 0; static_cast<int>(skyscrapers.size()) < settings.skyscrapersCount; plotIndex++)
+        {
+            // Every plot draws the same amount of numbers, so a plot's building doesn't depend on whether the previous ones were empty
+            const float occupancy = RandomFromRange(engine, 0.0f, 1.0f);
+            const float width = RandomFromRange(engine, minFootprint, maxFootprint);
+            const float length = RandomFromRange(engine, minFootprint, maxFootprint);
+            const float heightFactor = RandomFromRange(engine, 0.0f, 1.0f);
+
+            if (occupancy >= settings.density)
+            {
+                continue;
+            }
+
+            const int plotX = plotIndex % plotsPerRow;
+            const int plotZ = plotIndex / plotsPerRow;
+            const float x = (plotX / settings.plotsPerBlockSide) * blockSize + (plotX % settings.plotsPerBlockSide + 0.5f) * settings.plotSize;
+            const float z = (plotZ / settings.plotsPerBlockSide) * blockSize + (plotZ % settings.plotsPerBlockSide + 0.5f) * settings.plotSize;
+            const float height = settings.minHeight + (settings.maxHeight - settings.minHeight) * heightFactor * heightFactor;
+
+            skyscrapers.emplace_back(origin + Vector3(x, height * 0.5f, z), Vector3(width, height, length));
+        }
+    }
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include "Bounds.h"
+
+struct CityGeneratorSettings
+{
+    uint32_t seed = 1;
+    int skyscrapersCount = 1000;
+    float density = 0.7f;          // Chance of a plot getting a skyscraper, the rest stay empty squares
+    int plotsPerBlockSide = 4;     // Blocks are square groups of plots separated by streets
+    float plotSize = 6.0f;
+    float streetWidth = 4.0f;
+    float minFootprint = 3.0f;     // Footprint side, always fits inside the plot
+    float maxFootprint = 5.5f;
+    float minHeight = 4.0f;
+    float maxHeight = 40.0f;
+    Vector3 center = Vector3::Zero;
+};
+
+/// Deterministic city layout for scale testing, the same settings always give the same city on every platform run.
+/// Plots are laid out row by row in square blocks around the center until skyscrapersCount plots got a skyscraper,
+/// heights are skewed towards low buildings so the skyline still has a few towers.
+namespace CityGenerator
+{
+    void Generate(const CityGeneratorSettings& settings, std::vector<Bounds>& skyscrapers);
+}
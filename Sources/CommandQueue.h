@@ -0,0 +1,96 @@
+#pragma once
+#include <atomic>
+
+/// Bounded lock free multi producer, single consumer queue. Any thread may Push, one thread drains it with Pop at its sync point.
+/// Every cell carries a sequence number telling whether it's free for the producer that claimed its position or filled for the consumer,
+/// so producers only contend on one counter and never wait on each other or on the consumer. Push fails instead of blocking when full.
+template<typename T, size_t CAPACITY = 1 << 14>
+class CommandQueue
+{
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "CommandQueue capacity has to be a power of two");
+
+public:
+    CommandQueue();
+
+    CommandQueue(const CommandQueue&) = delete;
+    CommandQueue& operator=(const CommandQueue&) = delete;
+
+    // Any thread
+    bool Push(const T& value);
+
+    // Consumer thread only
+    bool Pop(T& value);
+
+private:
+    static constexpr size_t MASK = CAPACITY - 1;
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> m_cells;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_pushPosition;
+    alignas(CACHE_LINE_SIZE) size_t m_popPosition;
+};
+
+template<typename T, size_t CAPACITY>
+CommandQueue<T, CAPACITY>::CommandQueue()
+    : m_cells(std::make_unique<Cell[]>(CAPACITY))
+    , m_pushPosition(0)
+    , m_popPosition(0)
+{
+    for (size_t i = 0; i < CAPACITY; i++)
+    {
+        m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+template<typename T, size_t CAPACITY>
+bool CommandQueue<T, CAPACITY>::Push(const T& value)
+{
+    size_t position = m_pushPosition.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        Cell& cell = m_cells[position & MASK];
+        const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+
+        if (difference == 0)
+        {
+            // Free for this position, claim it. On failure position is reloaded and the loop retries
+            if (m_pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                cell.value = value;
+                cell.sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (difference < 0)
+        {
+            // Still holds the value from one lap ago, the consumer hasn't caught up
+            return false;
+        }
+        else
+        {
+            position = m_pushPosition.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+template<typename T, size_t CAPACITY>
+bool CommandQueue<T, CAPACITY>::Pop(T& value)
+{
+    Cell& cell = m_cells[m_popPosition & MASK];
+    if (cell.sequence.load(std::memory_order_acquire) != m_popPosition + 1)
+    {
+        return false; // Empty, or the next producer is still writing its value
+    }
+
+    value = cell.value;
+    cell.sequence.store(m_popPosition + CAPACITY, std::memory_order_release);
+    m_popPosition++;
+    return true;
+}
@@ -0,0 +1,190 @@
+#include "pch.h"
+#include "DistributedSimulation.h"
+
+#include "Game.h"
+#include <chrono>
+#include <sstream>
+
+namespace
+{
+    constexpr float CONNECT_TIMEOUT_SECONDS = 30.0f;
+    static_assert(std::is_trivially_copyable_v<BoidRecord>, "Boid records are sent as raw bytes between processes of the same build");
+
+    void Serialize(const std::vector<BoidRecord>& records, std::vector<char>& bytes)
+    {
+        bytes.resize(records.size() * sizeof(BoidRecord));
+        if (!records.empty())
+        {
+            std::memcpy(bytes.data(), records.data(), bytes.size());
+        }
+    }
+
+    bool Deserialize(const std::vector<char>& bytes, std::vector<BoidRecord>& records)
+    {
+        if (bytes.size() % sizeof(BoidRecord) != 0)
+        {
+            return false;
+        }
+
+        records.resize(bytes.size() / sizeof(BoidRecord));
+        if (!records.empty())
+        {
+            std::memcpy(records.data(), bytes.data(), bytes.size());
+        }
+        return true;
+    }
+}
+
+int SlabDecomposition::GetOwner(float x) const
+{
+    const int slab = static_cast<int>(std::floor((x - minX) / slabWidth));
+    return std::clamp(slab, 0, ranksCount - 1);
+}
+
+std::string DistributedReport::ToString() const
+{
+    std::ostringstream stream;
+    stream << "slab: " << rank << " / " << ranksCount << "\n"
+           << "owned boids: " << ownedBoidsCount << "\n"
+           << "ghost boids: " << ghostBoidsCount << "\n"
+           << "migrated out: " << migratedOutCount << ", in: " << migratedInCount << "\n"
+           << "exchange: " << exchangeMilliseconds << " ms\n";
+    return stream.str();
+}
+
+DistributedSimulation::DistributedSimulation(Game& game, int rank, int ranksCount)
+    : m_game(game)
+    , m_migratedOutCount(0)
+    , m_migratedInCount(0)
+    , m_exchangeMilliseconds(0.0)
+{
+    const Bounds& bounds = game.GetBoidManager().GetBounds();
+    m_decomposition.rank = rank;
+    m_decomposition.ranksCount = ranksCount;
+    m_decomposition.minX = bounds.min.x;
+    m_decomposition.slabWidth = bounds.size.x / static_cast<float>(ranksCount);
+
+    game.GetBoidManager().SetSpawnFilter([this](Vector3 position) { return m_decomposition.GetOwner(position.x) == m_decomposition.rank; });
+}
+
+bool DistributedSimulation::Connect(const std::string& socketDirectory, std::string& error)
+{
+    if (!IsGhostWidthValid(error))
+    {
+        return false;
+    }
+
+    return m_transport.Connect(m_decomposition.rank, m_decomposition.ranksCount, socketDirectory, CONNECT_TIMEOUT_SECONDS, error);
+}
+
+bool DistributedSimulation::ExchangeBoids(std::string& error)
+{
+    if (!IsGhostWidthValid(error))
+    {
+        return false;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    BoidManager& boidManager = m_game.GetBoidManager();
+    const int rank = m_decomposition.rank;
+    const float ghostWidth = boidManager.GetNeighborsDetectionRadius();
+
+    std::vector<BoidRecord> outgoing[SlabTransport::SidesCount];
+    std::vector<BoidRecord> incoming[SlabTransport::SidesCount];
+
+    // Migration first, so the ghosts sent next already come from the new owners
+    boidManager.ExtractBoids([&](const Boid& boid) { return m_decomposition.GetOwner(boid.GetPosition().x) < rank; }, outgoing[SlabTransport::Left]);
+    boidManager.ExtractBoids([&](const Boid& boid) { return m_decomposition.GetOwner(boid.GetPosition().x) > rank; }, outgoing[SlabTransport::Right]);
+    m_migratedOutCount += outgoing[SlabTransport::Left].size() + outgoing[SlabTransport::Right].size();
+
+    if (!Exchange(outgoing, incoming, error))
+    {
+        return false;
+    }
+
+    for (const std::vector<BoidRecord>& migrants : incoming)
+    {
+        boidManager.AddBoids(migrants);
+        m_migratedInCount += migrants.size();
+    }
+
+    const float lower = m_decomposition.GetLower();
+    const float upper = m_decomposition.GetUpper();
+
+    for (std::vector<BoidRecord>& records : outgoing)
+    {
+        records.clear();
+    }
+
+    if (m_transport.HasNeighbor(SlabTransport::Left))
+    {
+        boidManager.CollectBoids([&](const Boid& boid) { return boid.GetPosition().x < lower + ghostWidth; }, outgoing[SlabTransport::Left]);
+    }
+
+    if (m_transport.HasNeighbor(SlabTransport::Right))
+    {
+        boidManager.CollectBoids([&](const Boid& boid) { return boid.GetPosition().x >= upper - ghostWidth; }, outgoing[SlabTransport::Right]);
+    }
+
+    if (!Exchange(outgoing, incoming, error))
+    {
+        return false;
+    }
+
+    std::vector<BoidRecord>& ghosts = incoming[SlabTransport::Left];
+    ghosts.insert(ghosts.end(), incoming[SlabTransport::Right].begin(), incoming[SlabTransport::Right].end());
+    boidManager.SetGhostBoids(ghosts);
+
+    m_exchangeMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+DistributedReport DistributedSimulation::GetReport() const
+{
+    DistributedReport report;
+    report.rank = m_decomposition.rank;
+    report.ranksCount = m_decomposition.ranksCount;
+    report.ownedBoidsCount = m_game.GetBoidManager().GetBoidsCount();
+    report.ghostBoidsCount = m_game.GetBoidManager().GetGhostBoidsCount();
+    report.migratedOutCount = m_migratedOutCount;
+    report.migratedInCount = m_migratedInCount;
+    report.exchangeMilliseconds = m_exchangeMilliseconds;
+    return report;
+}
+
+bool DistributedSimulation::IsGhostWidthValid(std::string& error) const
+{
+    // Ghosts of a wider band would have to come from past the neighboring slab
+    const float ghostWidth = m_game.GetBoidManager().GetNeighborsDetectionRadius();
+    if (m_decomposition.slabWidth <= ghostWidth)
+    {
+        error = "slab width " + std::to_string(m_decomposition.slabWidth) + " isn't above the neighbor detection radius " + std::to_string(ghostWidth) + ", use fewer ranks";
+        return false;
+    }
+
+    return true;
+}
+
+bool DistributedSimulation::Exchange(const std::vector<BoidRecord> (&outgoing)[SlabTransport::SidesCount], std::vector<BoidRecord> (&incoming)[SlabTransport::SidesCount], std::string& error)
+{
+    for (int side = 0; side < SlabTransport::SidesCount; side++)
+    {
+        Serialize(outgoing[side], m_outgoingBytes[side]);
+    }
+
+    if (!m_transport.Exchange(m_outgoingBytes, m_incomingBytes, error))
+    {
+        return false;
+    }
+
+    for (int side = 0; side < SlabTransport::SidesCount; side++)
+    {
+        if (!Deserialize(m_incomingBytes[side], incoming[side]))
+        {
+            error = "malformed boid records from neighbor";
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "SlabTransport.h"
+
+class Game;
+struct BoidRecord;
+
+// Splits the X extent of the boid bounds into equally wide slabs, the outermost ones also own everything beyond the bounds
+struct SlabDecomposition
+{
+    int rank = 0;
+    int ranksCount = 1;
+    float minX = 0.0f;
+    float slabWidth = 1.0f;
+
+    int GetOwner(float x) const;
+    float GetLower() const { return minX + slabWidth * static_cast<float>(rank); }
+    float GetUpper() const { return minX + slabWidth * static_cast<float>(rank + 1); }
+};
+
+struct DistributedReport
+{
+    int rank = 0;
+    int ranksCount = 1;
+    size_t ownedBoidsCount = 0;
+    size_t ghostBoidsCount = 0;
+    size_t migratedOutCount = 0;
+    size_t migratedInCount = 0;
+    double exchangeMilliseconds = 0.0;
+
+    std::string ToString() const;
+};
+
+/// One process of a run split over several processes, each simulating the boids of one slab of the bounds.
+/// After every simulation step boids that crossed into a neighboring slab migrate to it, then the boids within the neighbor detection
+/// radius of a slab edge are sent to that neighbor as ghosts, so steering near the edges sees the same neighbors as a single process would.
+/// The ghost width follows the current neighbor detection radius, slabs have to be wider than it (checked on Connect and on every exchange,
+/// parameters may have changed in between), and boids can't cross a whole slab in one step.
+class DistributedSimulation
+{
+public:
+    DistributedSimulation(Game& game, int rank, int ranksCount);
+
+    bool Connect(const std::string& socketDirectory, std::string& error);
+    bool ExchangeBoids(std::string& error);
+
+    const SlabDecomposition& GetDecomposition() const { return m_decomposition; }
+    DistributedReport GetReport() const;
+
+private:
+    bool IsGhostWidthValid(std::string& error) const;
+    bool Exchange(const std::vector<BoidRecord> (&outgoing)[SlabTransport::SidesCount], std::vector<BoidRecord> (&incoming)[SlabTransport::SidesCount], std::string& error);
+
+    Game& m_game;
+    SlabDecomposition m_decomposition;
+    SlabTransport m_transport;
+
+    size_t m_migratedOutCount;
+    size_t m_migratedInCount;
+    double m_exchangeMilliseconds;
+
+    std::vector<char> m_outgoingBytes[SlabTransport::SidesCount];
+    std::vector<char> m_incomingBytes[SlabTransport::SidesCount];
+};
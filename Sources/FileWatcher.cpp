@@ -0,0 +1,131 @@
+#include "pch.h"
+#include "FileWatcher.h"
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    constexpr std::chrono::milliseconds POLL_INTERVAL(500);
+}
+
+FileWatcher::~FileWatcher()
+{
+    Stop();
+}
+
+#ifdef __linux__
+
+bool FileWatcher::Watch(const std::string& path)
+{
+    Stop();
+
+    const std::filesystem::path filePath(path);
+    const std::filesystem::path directory = filePath.has_parent_path() ? filePath.parent_path() : std::filesystem::path(".");
+
+    m_inotifyFile = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotifyFile < 0)
+    {
+        return false;
+    }
+
+    if (inotify_add_watch(m_inotifyFile, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+    {
+        Stop();
+        return false;
+    }
+
+    m_path = path;
+    m_fileName = filePath.filename().string();
+    return true;
+}
+
+void FileWatcher::Stop()
+{
+    if (m_inotifyFile >= 0)
+    {
+        close(m_inotifyFile);
+    }
+
+    m_inotifyFile = -1;
+}
+
+bool FileWatcher::HasChanged()
+{
+    if (m_inotifyFile < 0)
+    {
+        return false;
+    }
+
+    // Drains everything queued, several events for one save (or for other files in the directory) count as one change
+    bool hasChanged = false;
+    alignas(inotify_event) char buffer[4096];
+
+    for (;;)
+    {
+        const ssize_t length = read(m_inotifyFile, buffer, sizeof(buffer));
+        if (length <= 0)
+        {
+            return hasChanged;
+        }
+
+        for (ssize_t offset = 0; offset < length; )
+        {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            if (event->len > 0 && m_fileName == event->name)
+            {
+                hasChanged = true;
+            }
+
+            offset += sizeof(inotify_event) + event->len;
+        }
+    }
+}
+
+#else
+
+bool FileWatcher::Watch(const std::string& path)
+{
+    Stop();
+
+    m_path = path;
+    m_exists = GetWriteTime(m_writeTime);
+    m_nextPollTime = std::chrono::steady_clock::now() + POLL_INTERVAL;
+    m_isWatching = true;
+    return true;
+}
+
+void FileWatcher::Stop()
+{
+    m_isWatching = false;
+}
+
+bool FileWatcher::HasChanged()
+{
+    const auto now = std::chrono::steady_clock::now();
+    if (!m_isWatching || now < m_nextPollTime)
+    {
+        return false;
+    }
+
+    m_nextPollTime = now + POLL_INTERVAL;
+
+    std::filesystem::file_time_type writeTime;
+    const bool exists = GetWriteTime(writeTime);
+    const bool hasChanged = exists && (!m_exists || writeTime != m_writeTime);
+
+    m_exists = exists;
+    m_writeTime = writeTime;
+    return hasChanged;
+}
+
+bool FileWatcher::GetWriteTime(std::filesystem::file_time_type& writeTime) const
+{
+    std::error_code error;
+    writeTime = std::filesystem::last_write_time(m_path, error);
+    return !error;
+}
+
+#endif
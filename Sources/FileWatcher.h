@@ -0,0 +1,37 @@
+#pragma once
+#include <chrono>
+#include <filesystem>
+
+/// Tells whether a file was written, created or replaced since the last check, without blocking.
+/// On Linux through inotify on the file's directory, so editors that save by writing a new file and renaming it are caught as well.
+/// Elsewhere by comparing the modification time, at most every POLL_INTERVAL.
+class FileWatcher
+{
+public:
+    FileWatcher() = default;
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    // The file doesn't have to exist yet, its directory does
+    bool Watch(const std::string& path);
+    void Stop();
+
+    bool HasChanged();
+
+private:
+    std::string m_path;
+
+#ifdef __linux__
+    std::string m_fileName;
+    int m_inotifyFile = -1;
+#else
+    bool GetWriteTime(std::filesystem::file_time_type& writeTime) const;
+
+    bool m_isWatching = false;
+    bool m_exists = false;
+    std::filesystem::file_time_type m_writeTime;
+    std::chrono::steady_clock::time_point m_nextPollTime;
+#endif
+};
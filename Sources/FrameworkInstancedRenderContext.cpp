@@ -0,0 +1,16 @@
+#include "pch.h"
+#include "FrameworkInstancedRenderContext.h"
+
+FrameworkInstancedRenderContext::FrameworkInstancedRenderContext(const framework::RenderContextPtr& renderContext)
+    : m_renderContext(renderContext)
+{
+}
+
+void FrameworkInstancedRenderContext::RenderPrimitiveInstanced(const std::unique_ptr<DirectX::GeometricPrimitive>& primitive, Vector3 scale,
+                                                               const RenderInstance* instances, size_t instancesCount, const XMVECTOR* palette)
+{
+    for (size_t i = 0; i < instancesCount; i++)
+    {
+        m_renderContext->RenderPrimitive(primitive, scale, instances[i].position, Vector3::Zero, palette[instances[i].colorIndex]);
+    }
+}
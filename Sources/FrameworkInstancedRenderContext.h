@@ -0,0 +1,18 @@
+#pragma once
+#include "IRenderContext.h"
+#include "RenderInstanceBuffer.h"
+
+/// Instanced submission on top of the framework render context.
+/// The framework doesn't expose instance buffers, so for now each batch is replayed as individual primitives here,
+/// callers only ever see the instanced path and switching to a real instanced draw stays local to this class.
+class FrameworkInstancedRenderContext : public IInstancedRenderContext
+{
+public:
+    FrameworkInstancedRenderContext(const framework::RenderContextPtr& renderContext);
+
+    void RenderPrimitiveInstanced(const std::unique_ptr<DirectX::GeometricPrimitive>& primitive, Vector3 scale,
+                                  const RenderInstance* instances, size_t instancesCount, const XMVECTOR* palette) override;
+
+private:
+    const framework::RenderContextPtr& m_renderContext;
+};
@@ -1,13 +1,46 @@
 #include "pch.h"
 #include "Game.h"
+#include "DistributedSimulation.h"
+#include "Scenario.h"
+#include "SimulationState.h"
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+    constexpr bool USE_SIMULATION_THREAD = true;
+    constexpr float SIMULATION_TIME_STEP = 1.0f / 30.0f;
+    constexpr const char* QUICKSAVE_PATH = "../../data/states/quicksave.bsim";
+    constexpr const char* DEFAULT_PARAMETERS_PATH = "../../data/parameters.cfg";
+    constexpr const char* PARAMETERS_ENVIRONMENT_VARIABLE = "BOIDS_PARAMETERS";
+    constexpr const char* SCENARIO_ENVIRONMENT_VARIABLE = "BOIDS_SCENARIO";
+    constexpr const char* BACKEND_ENVIRONMENT_VARIABLE = "BOIDS_BACKEND";
+    constexpr const char* INTEGRATION_ENVIRONMENT_VARIABLE = "BOIDS_INTEGRATION";
+    constexpr const char* FLOCKS_ENVIRONMENT_VARIABLE = "BOIDS_FLOCKS";
+    constexpr const char* CONFORMANCE_ENVIRONMENT_VARIABLE = "BOIDS_CONFORMANCE";
+    constexpr float CONFORMANCE_TOLERANCE = 1.0e-3f;
+    constexpr const char* SLAB_ENVIRONMENT_VARIABLE = "BOIDS_SLAB";
+    constexpr const char* SLAB_SOCKET_DIRECTORY_ENVIRONMENT_VARIABLE = "BOIDS_SLAB_SOCKET_DIR";
+    constexpr const char* DEFAULT_SLAB_SOCKET_DIRECTORY = "/tmp";
+    constexpr const char* SHARED_STATE_ENVIRONMENT_VARIABLE = "BOIDS_SHARED_STATE";
+    constexpr uint32_t SHARED_STATE_BOIDS_CAPACITY = 1 << 17;
+    constexpr uint32_t SHARED_STATE_PROJECTILES_CAPACITY = 1 << 12;
+}
 
 Game::Game()
 {
     m_city = std::make_unique< City >();
     m_camera = std::make_unique< Camera >();
+    m_simulationCamera = std::make_unique< Camera >();
     m_crosshair = std::make_unique< Crosshair >(*this);
     m_boidManager = std::make_unique< BoidManager >(*this);
     m_projectileController = std::make_unique< ProjectileController >(*this);
+    m_trajectoryPlayer = std::make_unique< TrajectoryPlayer >();
+
+    if (USE_SIMULATION_THREAD)
+    {
+        m_simulationRunner = std::make_unique< SimulationRunner >(*this, SIMULATION_TIME_STEP);
+    }
 }
 
 Game::~Game() = default;
@@ -16,8 +49,85 @@ void Game::OnInitialize()
 {
     m_city->OnInitialize();
     m_crosshair->OnInitialize();
+
+    // Before the first boids are spawned, changing the flocks count clears them
+    if (const char* flocksCountText = std::getenv(FLOCKS_ENVIRONMENT_VARIABLE))
+    {
+        const int flocksCount = std::atoi(flocksCountText);
+        if (flocksCount > 0 && flocksCount <= BoidManager::MAX_FLOCKS_COUNT)
+        {
+            m_boidManager->SetFlocksCount(flocksCount);
+        }
+        else
+        {
+            std::cerr << "Invalid flocks count " << flocksCountText << std::endl;
+        }
+    }
+
     m_boidManager->OnInitialize();
     m_projectileController->OnInitialize();
+
+    // Tuning values, reloaded while running whenever the file is saved. Without one the built in defaults are used,
+    // that's only worth a message when the file was asked for explicitly
+    const char* parametersPath = std::getenv(PARAMETERS_ENVIRONMENT_VARIABLE);
+    m_parameterStore.Open(parametersPath ? parametersPath : DEFAULT_PARAMETERS_PATH, parametersPath == nullptr);
+    ApplyParameters();
+
+    if (const char* backendName = std::getenv(BACKEND_ENVIRONMENT_VARIABLE))
+    {
+        SimulationBackendType backendType;
+        if (ParseSimulationBackendType(backendName, backendType))
+        {
+            m_boidManager->SetSimulationBackend(backendType);
+        }
+        else
+        {
+            std::cerr << "Unknown simulation backend " << backendName << std::endl;
+        }
+    }
+
+    // <method>[:<substeps>], e.g. verlet:4
+    if (const char* integrationName = std::getenv(INTEGRATION_ENVIRONMENT_VARIABLE))
+    {
+        const std::string value = integrationName;
+        const size_t separator = value.find(':');
+
+        BoidIntegrationSettings integration;
+        const bool isMethodValid = ParseIntegrationMethod(value.substr(0, separator), integration.method);
+        integration.substepsCount = separator == std::string::npos ? 1 : std::atoi(value.c_str() + separator + 1);
+
+        if (isMethodValid && integration.substepsCount > 0)
+        {
+            m_boidManager->SetIntegration(integration);
+        }
+        else
+        {
+            std::cerr << "Invalid integration " << value << std::endl;
+        }
+    }
+
+    // External tools read the simulation from shared memory, the value names the region
+    if (const char* sharedStateName = std::getenv(SHARED_STATE_ENVIRONMENT_VARIABLE))
+    {
+        const std::string name = *sharedStateName ? sharedStateName : SharedState::DEFAULT_NAME;
+        m_sharedStatePublisher = std::make_unique< SharedStatePublisher >();
+        if (!m_sharedStatePublisher->Create(name, SHARED_STATE_BOIDS_CAPACITY, SHARED_STATE_PROJECTILES_CAPACITY))
+        {
+            std::cerr << "Failed to create shared state " << name << std::endl;
+            m_sharedStatePublisher.reset();
+        }
+    }
+
+    // Benchmark run, the whole scenario is simulated here before the first rendered frame and the process exits
+    if (const char* scenarioPath = std::getenv(SCENARIO_ENVIRONMENT_VARIABLE))
+    {
+        RunScenario(scenarioPath);
+    }
+
+    if (m_simulationRunner)
+    {
+        m_simulationRunner->Start();
+    }
 }
 
 void Game::OnUpdate( float deltaTime, DirectX::Keyboard& keyboard, DirectX::Mouse& mouse, DirectX::GamePad& gamepad )
@@ -25,22 +135,267 @@ void Game::OnUpdate( float deltaTime, DirectX::Keyboard& keyboard, DirectX::Mous
 	m_camera->OnUpdate( deltaTime, keyboard, mouse, gamepad );
 	m_city->OnUpdate( deltaTime );
     m_crosshair->OnUpdate( deltaTime, mouse, gamepad);
-    m_boidManager->OnUpdate(deltaTime, keyboard);
-    m_projectileController->OnUpdate(deltaTime, mouse, gamepad);
+
+    const DirectX::Keyboard::State keyboardState = keyboard.GetState();
+    if (m_replayKeyPressedLastFrame && !keyboardState.F7)
+    {
+        ToggleReplay();
+    }
+
+    m_replayKeyPressedLastFrame = keyboardState.F7;
+
+    // While replaying the simulation is frozen, boids come from the recording only
+    if (m_trajectoryPlayer->IsOpen())
+    {
+        m_trajectoryPlayer->OnUpdate(deltaTime, keyboardState);
+        return;
+    }
+
+    if (m_simulationRunner)
+    {
+        m_simulationRunner->OnUpdate(deltaTime, keyboard, mouse, gamepad);
+        return;
+    }
+
+    SyncSimulationCamera();
+    UpdateSimulation(deltaTime, keyboardState, mouse.GetState(), gamepad.GetState(0));
+}
+
+void Game::RunScenario( const std::string& path )
+{
+    // Whatever the file holds now is used for the whole run, editing it meanwhile mustn't change the results
+    m_parameterStore.Pin();
+
+    Scenario scenario;
+    std::string error;
+
+    if (!scenario.Load(path, error))
+    {
+        std::cerr << "Scenario " << error << std::endl;
+        OnShutdown();
+        std::exit(EXIT_FAILURE);
+    }
+
+    if (const char* conformanceBackend = std::getenv(CONFORMANCE_ENVIRONMENT_VARIABLE))
+    {
+        RunConformance(scenario, path, conformanceBackend);
+    }
+
+    if (const char* slab = std::getenv(SLAB_ENVIRONMENT_VARIABLE))
+    {
+        RunDistributed(scenario, path, slab);
+    }
+
+    const std::string report = ScenarioRunner(*this).Run(scenario).ToString();
+    std::cout << report;
+
+    std::ofstream reportStream(path + ".report");
+    reportStream << report;
+
+    OnShutdown();
+    std::exit(reportStream ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+void Game::RunConformance( const Scenario& scenario, const std::string& path, const std::string& backendName )
+{
+    // Either one backend or "all" of them, each checked against the reference
+    std::vector<SimulationBackendType> backendTypes;
+    SimulationBackendType backendType;
+
+    if (backendName == "all")
+    {
+        for (int i = 1; i < static_cast<int>(SimulationBackendType::Count); i++)
+        {
+            backendTypes.push_back(static_cast<SimulationBackendType>(i));
+        }
+    }
+    else if (ParseSimulationBackendType(backendName, backendType))
+    {
+        backendTypes.push_back(backendType);
+    }
+    else
+    {
+        std::cerr << "Unknown simulation backend " << backendName << std::endl;
+        OnShutdown();
+        std::exit(EXIT_FAILURE);
+    }
+
+    std::ofstream reportStream(path + ".conformance");
+    bool isPassed = true;
+
+    for (SimulationBackendType type : backendTypes)
+    {
+        const ConformanceReport report = ScenarioRunner(*this).RunConformance(scenario, type, CONFORMANCE_TOLERANCE, path + ".reference");
+        std::cout << report.ToString();
+        reportStream << report.ToString();
+        isPassed = isPassed && report.IsPassed();
+    }
+
+    OnShutdown();
+    std::exit(isPassed && reportStream ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+void Game::RunDistributed( const Scenario& scenario, const std::string& path, const std::string& slab )
+{
+    // "<rank>/<ranks count>", every rank runs the same scenario and keeps only the boids of its slab
+    int rank = 0;
+    int ranksCount = 0;
+    char separator = 0;
+    std::istringstream slabStream(slab);
+
+    if (!(slabStream >> rank >> separator >> ranksCount) || separator != '/' || ranksCount < 1 || rank < 0 || rank >= ranksCount)
+    {
+        std::cerr << "Invalid slab " << slab << ", expected <rank>/<ranks count>" << std::endl;
+        OnShutdown();
+        std::exit(EXIT_FAILURE);
+    }
+
+    const char* socketDirectory = std::getenv(SLAB_SOCKET_DIRECTORY_ENVIRONMENT_VARIABLE);
+    DistributedSimulation distributedSimulation(*this, rank, ranksCount);
+    std::string error;
+
+    const auto exitOnError = [&]
+    {
+        std::cerr << "Slab " << rank << ": " << error << std::endl;
+        OnShutdown();
+        std::exit(EXIT_FAILURE);
+    };
+
+    if (!distributedSimulation.Connect(socketDirectory ? socketDirectory : DEFAULT_SLAB_SOCKET_DIRECTORY, error))
+    {
+        exitOnError();
+    }
+
+    const ScenarioReport scenarioReport = ScenarioRunner(*this).Run(scenario, [&](int)
+    {
+        if (!distributedSimulation.ExchangeBoids(error))
+        {
+            exitOnError();
+        }
+    });
+
+    const std::string report = scenarioReport.ToString() + distributedSimulation.GetReport().ToString();
+    std::cout << report;
+
+    std::ofstream reportStream(path + ".slab" + std::to_string(rank) + ".report");
+    reportStream << report;
+
+    OnShutdown();
+    std::exit(reportStream ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+void Game::ToggleReplay()
+{
+    if (m_trajectoryPlayer->IsOpen())
+    {
+        m_trajectoryPlayer->Close();
+        return;
+    }
+
+    if (!m_trajectoryPlayer->Open(TrajectoryFormat::DEFAULT_PATH))
+    {
+        // Open leaves the player closed, the simulation keeps running and F7 simply tries again
+        std::cerr << "Failed to open trajectory " << TrajectoryFormat::DEFAULT_PATH << std::endl;
+    }
+}
+
+void Game::UpdateSimulation( float deltaTime, const DirectX::Keyboard::State& keyboardState, const DirectX::Mouse::State& mouseState, const DirectX::GamePad::State& padState )
+{
+    // Parameters change between steps only, like state saves / loads
+    if (m_parameterStore.Update())
+    {
+        ApplyParameters();
+    }
+
+    // State is saved / loaded between updates, so it always matches a whole simulation step
+    if (m_saveStateKeyPressedLastFrame && !keyboardState.F5)
+    {
+        // A full disk or read only directory only costs the save, the game keeps running
+        if (!SimulationState::Save(QUICKSAVE_PATH, *this))
+        {
+            std::cerr << "Failed to save state to " << QUICKSAVE_PATH << std::endl;
+        }
+    }
+    else if (m_loadStateKeyPressedLastFrame && !keyboardState.F9)
+    {
+        if (!SimulationState::Load(QUICKSAVE_PATH, *this))
+        {
+            std::cerr << "Failed to load state from " << QUICKSAVE_PATH << std::endl;
+        }
+    }
+
+    m_saveStateKeyPressedLastFrame = keyboardState.F5;
+    m_loadStateKeyPressedLastFrame = keyboardState.F9;
+
+    m_boidManager->OnUpdate(deltaTime, keyboardState);
+    m_projectileController->OnUpdate(deltaTime, mouseState, padState);
+
+    // Sync point for spawns / despawns requested during the step or from other threads
+    m_boidManager->ApplyPendingCommands();
+
+    PublishSharedState();
+}
+
+void Game::SetParameters( const SimulationParameters& parameters )
+{
+    m_parameterStore.Set(parameters);
+    ApplyParameters();
+}
+
+void Game::ApplyParameters()
+{
+    m_boidManager->ApplyParameters(m_parameterStore.Get());
+    m_projectileController->ApplyParameters(m_parameterStore.Get());
+}
+
+void Game::PublishSharedState()
+{
+    if (!m_sharedStatePublisher)
+    {
+        return;
+    }
+
+    SharedStateFrame& frame = m_sharedStatePublisher->BeginFrame(m_boidManager->GetSimulationTime());
+    m_boidManager->WriteSharedState(frame);
+    m_projectileController->WriteSharedState(frame);
+    m_sharedStatePublisher->EndFrame();
 }
 
 void Game::OnRender( framework::RenderContextPtr& renderContext )
 {
 	m_city->OnRender( renderContext );
-    m_boidManager->OnRender(renderContext);
-    m_projectileController->OnRender(renderContext);
+
+    if (m_trajectoryPlayer->IsOpen())
+    {
+        m_trajectoryPlayer->OnRender(renderContext, *m_boidManager);
+    }
+    else if (m_simulationRunner)
+    {
+        m_simulationRunner->OnRender(renderContext);
+    }
+    else
+    {
+        m_boidManager->OnRender(renderContext);
+        m_projectileController->OnRender(renderContext);
+    }
+
     m_crosshair->OnRender( renderContext );
 }
 
 void Game::OnShutdown()
 {
+    if (m_simulationRunner)
+    {
+        m_simulationRunner->Stop();
+    }
+
 	m_city->OnShutdown();
     m_crosshair->OnShutdown();
     m_boidManager->OnShutdown();
     m_projectileController->OnShutdown();
+
+    if (m_sharedStatePublisher)
+    {
+        m_sharedStatePublisher->Close();
+    }
 }
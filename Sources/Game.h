@@ -7,6 +7,12 @@
 #include "Camera.h"
 #include "Crosshair.h"
 #include "ProjectileController.h"
+#include "ParameterStore.h"
+#include "SharedStatePublisher.h"
+#include "SimulationRunner.h"
+#include "TrajectoryPlayer.h"
+
+struct Scenario;
 
 class Game final : public framework::IGame
 {
@@ -26,17 +32,47 @@ public:
 	void OnShutdown() override;
 
 	const City& GetCity() const { return *m_city.get(); }
+	City& GetCity() { return *m_city.get(); }
 	const Camera& GetCamera() const { return *m_camera.get(); }
 	const ProjectileController& GetProjectileController() const { return *m_projectileController.get(); }
+	ProjectileController& GetProjectileController() { return *m_projectileController.get(); }
+
+	// Camera as seen by the simulation, only synced between steps so the simulation thread never reads the live one
+	const Camera& GetSimulationCamera() const { return *m_simulationCamera.get(); }
+	Camera& GetSimulationCamera() { return *m_simulationCamera.get(); }
+	void SyncSimulationCamera() { *m_simulationCamera = *m_camera; }
+
+	// Everything that mutates boids / projectiles, runs either on the main thread or inside a SimulationRunner step
+	void UpdateSimulation( float deltaTime, const DirectX::Keyboard::State& keyboardState, const DirectX::Mouse::State& mouseState, const DirectX::GamePad::State& padState );
 
 	BoidManager& GetBoidManager() { return *m_boidManager.get(); }
 	const BoidManager& GetBoidManager() const { return  *m_boidManager.get(); }
 
+	const SimulationParameters& GetParameters() const { return m_parameterStore.Get(); }
+	// Between simulation steps only, for parameters restored from a saved state
+	void SetParameters( const SimulationParameters& parameters );
+
 private:
+	void ToggleReplay();
+	void RunScenario( const std::string& path );
+	void RunConformance( const Scenario& scenario, const std::string& path, const std::string& backendName );
+	void RunDistributed( const Scenario& scenario, const std::string& path, const std::string& slab );
+	void PublishSharedState();
+	void ApplyParameters();
+
+	bool m_saveStateKeyPressedLastFrame = false;
+	bool m_loadStateKeyPressedLastFrame = false;
+	bool m_replayKeyPressedLastFrame = false;
+
     std::unique_ptr< City >					                m_city;
 	std::unique_ptr< Camera >				                m_camera;
+	std::unique_ptr< Camera >				                m_simulationCamera;
     std::unique_ptr< Crosshair >			                m_crosshair;
 	std::unique_ptr< BoidManager >			                m_boidManager;
 	std::unique_ptr< ProjectileController >			        m_projectileController;
+	std::unique_ptr< SimulationRunner >			            m_simulationRunner;
+	std::unique_ptr< TrajectoryPlayer >			            m_trajectoryPlayer;
+	std::unique_ptr< SharedStatePublisher >			        m_sharedStatePublisher;
+	ParameterStore											m_parameterStore;
 };
 
@@ -1,9 +1,58 @@
 #include "pch.h"
 #include "MathHelper.h"
 #include <random>
+#include <sstream>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#include <xmmintrin.h>
+#define MATH_HELPER_SSE 1
+#endif
+
+namespace
+{
+    constexpr size_t SIMD_WIDTH = 4;
+
+#if MATH_HELPER_SSE
+    // 12 bit hardware estimate, one Newton step brings it close to full float precision
+    __m128 InverseSqrtFast(__m128 value)
+    {
+        const __m128 estimate = _mm_rsqrt_ps(value);
+        const __m128 halfValueEstimateSquared = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), value), _mm_mul_ps(estimate, estimate));
+        return _mm_mul_ps(estimate, _mm_sub_ps(_mm_set1_ps(1.5f), halfValueEstimateSquared));
+    }
+#endif
+}
 
 namespace MathHelper
 {
+    std::mt19937& GetRandomEngine()
+    {
+        static std::mt19937 engine{ std::random_device()() };
+        return engine;
+    }
+
+    std::string SaveRandomState()
+    {
+        std::ostringstream stream;
+        stream << GetRandomEngine();
+        return stream.str();
+    }
+
+    bool LoadRandomState(const std::string& state)
+    {
+        std::istringstream stream(state);
+        std::mt19937 engine;
+        stream >> engine;
+
+        if (stream.fail())
+        {
+            return false;
+        }
+
+        GetRandomEngine() = engine;
+        return true;
+    }
+
     float RandomValue()
     {
         return RandomFromRange(0.0f, 1.0f);
@@ -38,6 +87,86 @@ namespace MathHelper
         return normalized_vector;
     }
 
+    float InverseSqrtFast(float value)
+    {
+#if MATH_HELPER_SSE
+        return _mm_cvtss_f32(::InverseSqrtFast(_mm_set_ss(value)));
+#else
+        // Bit level estimate has 3.5% error, two Newton steps are needed to get the same precision as the hardware path
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(float));
+        bits = 0x5f375a86 - (bits >> 1);
+
+        float estimate;
+        std::memcpy(&estimate, &bits, sizeof(float));
+        estimate *= 1.5f - 0.5f * value * estimate * estimate;
+        estimate *= 1.5f - 0.5f * value * estimate * estimate;
+        return estimate;
+#endif
+    }
+
+    Vector3 GetNormalizedFast(const Vector3& vector)
+    {
+        const float lengthSquared = vector.LengthSquared();
+        return lengthSquared > 0.0f ? vector * InverseSqrtFast(lengthSquared) : Vector3::Zero;
+    }
+
+    void GetNormalized(const Vector3* vectors, Vector3* normalized, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            const float length = vectors[i].Length();
+            normalized[i] = length > 0.0f ? vectors[i] / length : Vector3::Zero;
+        }
+    }
+
+    void GetNormalizedFast(const Vector3* vectors, Vector3* normalized, size_t count)
+    {
+        size_t i = 0;
+
+#if MATH_HELPER_SSE
+        // Four vectors are 12 floats in three registers, lengths are summed in scalar and the reciprocal square roots run four at a time,
+        // then each register is scaled by the matching lanes (s0 s0 s0 s1 | s1 s1 s2 s2 | s2 s3 s3 s3)
+        static_assert(sizeof(Vector3) == 3 * sizeof(float), "Batched normalization expects tightly packed vectors");
+        const float* input = reinterpret_cast<const float*>(vectors);
+        float* output = reinterpret_cast<float*>(normalized);
+
+        for (; i + SIMD_WIDTH <= count; i += SIMD_WIDTH)
+        {
+            const __m128 lengthsSquared = _mm_setr_ps(vectors[i].LengthSquared(), vectors[i + 1].LengthSquared(), vectors[i + 2].LengthSquared(), vectors[i + 3].LengthSquared());
+            const __m128 nonZeroMask = _mm_cmpgt_ps(lengthsSquared, _mm_setzero_ps());
+            const __m128 scales = _mm_and_ps(::InverseSqrtFast(lengthsSquared), nonZeroMask);
+
+            const __m128 first = _mm_loadu_ps(input + i * 3);
+            const __m128 second = _mm_loadu_ps(input + i * 3 + 4);
+            const __m128 third = _mm_loadu_ps(input + i * 3 + 8);
+            _mm_storeu_ps(output + i * 3, _mm_mul_ps(first, _mm_shuffle_ps(scales, scales, _MM_SHUFFLE(1, 0, 0, 0))));
+            _mm_storeu_ps(output + i * 3 + 4, _mm_mul_ps(second, _mm_shuffle_ps(scales, scales, _MM_SHUFFLE(2, 2, 1, 1))));
+            _mm_storeu_ps(output + i * 3 + 8, _mm_mul_ps(third, _mm_shuffle_ps(scales, scales, _MM_SHUFFLE(3, 3, 3, 2))));
+        }
+#endif
+
+        for (; i < count; i++)
+        {
+            normalized[i] = GetNormalizedFast(vectors[i]);
+        }
+    }
+
+    bool IsWithinCone(const Vector3& direction, const Vector3& vector, float cosHalfAngle)
+    {
+        // direction . vector >= cosHalfAngle * |vector|, compared squared with the signs handled separately
+        const float dot = direction.Dot(vector);
+        const float thresholdSquared = cosHalfAngle * cosHalfAngle * vector.LengthSquared();
+
+        // Non short circuit operators, the sign of the dot product is random per neighbor and would mispredict
+        if (cosHalfAngle > 0.0f)
+        {
+            return (dot > 0.0f) & (dot * dot >= thresholdSquared);
+        }
+
+        return (dot >= 0.0f) | (dot * dot <= thresholdSquared);
+    }
+
     float GetProportional(float minOld, float maxOld, float value, float minNew, float maxNew)
     {
         assert(minOld != maxOld);
@@ -49,6 +178,16 @@ namespace MathHelper
     {
         return std::max(std::max(vector.x, vector.y), vector.z);
     }
+
+    Vector3 HueToRGB(float hueDegrees)
+    {
+        // Full saturation and value, hue wrapped into [0, 360)
+        const float hue = std::fmod(std::fmod(hueDegrees, 360.0f) + 360.0f, 360.0f) / 60.0f;
+        const float r = std::abs(hue - 3.0f) - 1.0f;
+        const float g = 2.0f - std::abs(hue - 2.0f);
+        const float b = 2.0f - std::abs(hue - 4.0f);
+        return Vector3(std::clamp(r, 0.0f, 1.0f), std::clamp(g, 0.0f, 1.0f), std::clamp(b, 0.0f, 1.0f));
+    }
 };
 
 
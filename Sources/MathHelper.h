@@ -3,6 +3,11 @@
 
 namespace MathHelper
 {
+    // Shared engine so the random state can be saved and restored, not thread safe, only the simulation should draw from it
+    std::mt19937& GetRandomEngine();
+    std::string SaveRandomState();
+    bool LoadRandomState(const std::string& state);
+
     float RandomValue();
     float RandomBinomial();
 
@@ -14,8 +19,21 @@ namespace MathHelper
     float DegreesToRadians(float degrees);
     Vector3 GetNormalized(const Vector3& vector);
 
+    // Reciprocal square root estimate refined with Newton steps, relative error around 1e-6 instead of a sqrt and a divide.
+    // Good enough for steering directions that get summed and normalized again, not for anything accumulated over frames
+    float InverseSqrtFast(float value);
+    Vector3 GetNormalizedFast(const Vector3& vector);
+
+    // Batched versions, output may alias input, zero vectors stay zero like in GetNormalized
+    void GetNormalized(const Vector3* vectors, Vector3* normalized, size_t count);
+    void GetNormalizedFast(const Vector3* vectors, Vector3* normalized, size_t count);
+
+    // Whether the angle between a unit direction and a vector is within the cone, without normalizing the vector
+    bool IsWithinCone(const Vector3& direction, const Vector3& vector, float cosHalfAngle);
+
     float GetProportional(float minOld, float maxOld, float value, float minNew, float maxNew);
     float GetBiggest(const Vector3& vector);
+    Vector3 HueToRGB(float hueDegrees);
 
 
     template <typename T>
@@ -23,8 +41,7 @@ namespace MathHelper
     {
         static_assert(std::is_arithmetic_v<T>, "Template parameter must be an arithmetic type.");
 
-        std::random_device rd;
-        std::mt19937 gen(rd());
+        std::mt19937& gen = GetRandomEngine();
 
         if constexpr (std::is_integral_v<T>)
         {
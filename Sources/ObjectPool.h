@@ -0,0 +1,159 @@
+#pragma once
+
+/// Fixed block pool, objects are constructed in place inside blocks of BLOCK_SIZE slots that are never moved or freed until destruction,
+/// so pointers stay stable and creating / destroying objects after warm up never touches the general purpose heap.
+/// Freed slots are reused last in first out, the most recently freed (still cached) memory is handed out first.
+/// Handles add a generation per slot, so a handle to a destroyed object resolves to nullptr instead of to whatever reuses the slot.
+template<typename T, size_t BLOCK_SIZE = 512>
+class ObjectPool
+{
+public:
+    struct Handle
+    {
+        uint32_t index = INVALID_INDEX;
+        uint32_t generation = 0;
+
+        bool IsValid() const { return index != INVALID_INDEX; }
+    };
+
+    ObjectPool() = default;
+    ~ObjectPool() { Clear(); }
+
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    template<typename... Args>
+    T* Create(Args&&... args);
+    void Destroy(T* object);
+    // Destroys every live object, blocks are kept for reuse
+    void Clear();
+    void Reserve(size_t capacity);
+
+    Handle GetHandle(const T* object) const;
+    T* Get(Handle handle) const;
+
+    size_t GetLiveCount() const { return m_liveCount; }
+    size_t GetCapacity() const { return m_blocks.size() * BLOCK_SIZE; }
+
+private:
+    static constexpr uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+
+    // Storage first, so a T* is also the address of its slot
+    struct Slot
+    {
+        alignas(T) unsigned char storage[sizeof(T)];
+        uint32_t index;
+        uint32_t generation;
+        uint32_t nextFree;
+        bool isAlive;
+    };
+
+    static const Slot* GetSlot(const T* object) { return reinterpret_cast<const Slot*>(object); }
+    Slot& GetSlot(uint32_t index) const { return m_blocks[index / BLOCK_SIZE][index % BLOCK_SIZE]; }
+    void AddBlock();
+
+    std::vector<std::unique_ptr<Slot[]>> m_blocks;
+    uint32_t m_firstFree = INVALID_INDEX;
+    size_t m_liveCount = 0;
+};
+
+template<typename T, size_t BLOCK_SIZE>
+template<typename... Args>
+T* ObjectPool<T, BLOCK_SIZE>::Create(Args&&... args)
+{
+    if (m_firstFree == INVALID_INDEX)
+    {
+        AddBlock();
+    }
+
+    Slot& slot = GetSlot(m_firstFree);
+    T* object = new (slot.storage) T(std::forward<Args>(args)...);
+
+    m_firstFree = slot.nextFree;
+    slot.isAlive = true;
+    ++m_liveCount;
+    return object;
+}
+
+template<typename T, size_t BLOCK_SIZE>
+void ObjectPool<T, BLOCK_SIZE>::Destroy(T* object)
+{
+    Slot& slot = GetSlot(GetSlot(object)->index);
+    assert(slot.isAlive);
+
+    object->~T();
+    slot.isAlive = false;
+    ++slot.generation;
+    slot.nextFree = m_firstFree;
+    m_firstFree = slot.index;
+    --m_liveCount;
+}
+
+template<typename T, size_t BLOCK_SIZE>
+void ObjectPool<T, BLOCK_SIZE>::Clear()
+{
+    // Free list is rebuilt from the back, so slots are handed out again in address order
+    m_firstFree = INVALID_INDEX;
+
+    for (size_t i = GetCapacity(); i-- > 0; )
+    {
+        Slot& slot = GetSlot(static_cast<uint32_t>(i));
+        if (slot.isAlive)
+        {
+            reinterpret_cast<T*>(slot.storage)->~T();
+            slot.isAlive = false;
+            ++slot.generation;
+        }
+
+        slot.nextFree = m_firstFree;
+        m_firstFree = slot.index;
+    }
+
+    m_liveCount = 0;
+}
+
+template<typename T, size_t BLOCK_SIZE>
+void ObjectPool<T, BLOCK_SIZE>::Reserve(size_t capacity)
+{
+    while (GetCapacity() < capacity)
+    {
+        AddBlock();
+    }
+}
+
+template<typename T, size_t BLOCK_SIZE>
+typename ObjectPool<T, BLOCK_SIZE>::Handle ObjectPool<T, BLOCK_SIZE>::GetHandle(const T* object) const
+{
+    const Slot* slot = GetSlot(object);
+    return Handle{ slot->index, slot->generation };
+}
+
+template<typename T, size_t BLOCK_SIZE>
+T* ObjectPool<T, BLOCK_SIZE>::Get(Handle handle) const
+{
+    if (handle.index >= GetCapacity())
+    {
+        return nullptr;
+    }
+
+    Slot& slot = GetSlot(handle.index);
+    return slot.isAlive && slot.generation == handle.generation ? reinterpret_cast<T*>(slot.storage) : nullptr;
+}
+
+template<typename T, size_t BLOCK_SIZE>
+void ObjectPool<T, BLOCK_SIZE>::AddBlock()
+{
+    const uint32_t firstIndex = static_cast<uint32_t>(GetCapacity());
+    m_blocks.push_back(std::make_unique<Slot[]>(BLOCK_SIZE));
+    Slot* block = m_blocks.back().get();
+
+    // New slots go in front of the free list in address order, existing free slots stay behind them
+    for (size_t i = BLOCK_SIZE; i-- > 0; )
+    {
+        block[i].index = firstIndex + static_cast<uint32_t>(i);
+        block[i].generation = 0;
+        block[i].isAlive = false;
+        block[i].nextFree = m_firstFree;
+        m_firstFree = block[i].index;
+    }
+}
@@ -0,0 +1,36 @@
+#include "pch.h"
+#include "ParameterStore.h"
+#include <filesystem>
+#include <iostream>
+
+bool ParameterStore::Open(const std::string& path, bool isOptional)
+{
+    m_path = path;
+
+    std::error_code error;
+    const bool isQuiet = isOptional && !std::filesystem::exists(path, error);
+
+    if (!m_watcher.Watch(path) && !isQuiet)
+    {
+        std::cerr << "Can't watch " << path << ", parameters won't be reloaded" << std::endl;
+    }
+
+    return !isQuiet && Load();
+}
+
+bool ParameterStore::Update()
+{
+    return IsOpen() && !m_isPinned && m_watcher.HasChanged() && Load();
+}
+
+bool ParameterStore::Load()
+{
+    std::string error;
+    if (!m_parameters.Load(m_path, error))
+    {
+        std::cerr << "Parameters not loaded: " << error << std::endl;
+        return false;
+    }
+
+    return true;
+}
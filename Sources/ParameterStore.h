@@ -0,0 +1,32 @@
+#pragma once
+#include "FileWatcher.h"
+#include "SimulationParameters.h"
+
+/// Owner of the current SimulationParameters, loaded from a file and reloaded whenever it changes.
+/// Changes are only picked up by Update, which the simulation calls between steps, so a step never sees half applied values.
+/// A file that fails to load is reported and the previous values stay.
+class ParameterStore
+{
+public:
+    // False when the file couldn't be loaded, defaults are used and the file is still watched, so it can be created later.
+    // An optional file (the default path, nobody asked for it) that doesn't exist isn't reported
+    bool Open(const std::string& path, bool isOptional = false);
+
+    // True when new parameters were loaded since the last call, always false once pinned
+    bool Update();
+    // For runs that have to be reproducible (scenarios, conformance, distributed), the file is no longer reloaded
+    void Pin() { m_isPinned = true; }
+    // Parameters from somewhere else than the file (a loaded state), they stay until the file changes
+    void Set(const SimulationParameters& parameters) { m_parameters = parameters; }
+
+    const SimulationParameters& Get() const { return m_parameters; }
+    bool IsOpen() const { return !m_path.empty(); }
+
+private:
+    bool Load();
+
+    std::string m_path;
+    FileWatcher m_watcher;
+    SimulationParameters m_parameters;
+    bool m_isPinned = false;
+};
@@ -0,0 +1,40 @@
+#include "pch.h"
+#include "PreyClaimTable.h"
+
+void PreyClaimTable::BeginStep(size_t slotsCount)
+{
+    ++m_step;
+
+    // Grown tables start empty, and after the step counter wraps stale entries could pass as current, so both start over from step 1
+    if (slotsCount > m_slotsCount || m_step == 0)
+    {
+        const size_t newSlotsCount = std::max(slotsCount, m_slotsCount);
+        m_entries = std::make_unique<std::atomic<uint64_t>[]>(newSlotsCount);
+        for (size_t i = 0; i < newSlotsCount; i++)
+        {
+            m_entries[i].store(0, std::memory_order_relaxed);
+        }
+
+        m_slotsCount = newSlotsCount;
+        m_step = 1;
+    }
+}
+
+void PreyClaimTable::Claim(uint32_t slot, uint32_t predatorID)
+{
+    assert(slot < m_slotsCount);
+    std::atomic<uint64_t>& entry = m_entries[slot];
+    const uint64_t claim = MakeEntry(predatorID);
+
+    // Atomic min among this step's claims, on failure current is reloaded
+    uint64_t current = entry.load(std::memory_order_relaxed);
+    while ((current >> 32 != m_step || claim < current) && !entry.compare_exchange_weak(current, claim, std::memory_order_relaxed))
+    {
+    }
+}
+
+bool PreyClaimTable::IsClaimedBy(uint32_t slot, uint32_t predatorID) const
+{
+    assert(slot < m_slotsCount);
+    return m_entries[slot].load(std::memory_order_relaxed) == MakeEntry(predatorID);
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <atomic>
+
+/// Which predator gets each boid in a predation step. Predators claim the boids they touch from any thread, one CAS per claim,
+/// and the lowest predator id wins, so the outcome doesn't depend on which thread got there first.
+/// Entries are indexed by boid pool slot and tagged with the step they were claimed in, so starting a step doesn't clear the table.
+class PreyClaimTable
+{
+public:
+    // Not thread safe, call before the claims of a step
+    void BeginStep(size_t slotsCount);
+
+    void Claim(uint32_t slot, uint32_t predatorID);
+    // Only meaningful once every claim of the step is done
+    bool IsClaimedBy(uint32_t slot, uint32_t predatorID) const;
+
+private:
+    uint64_t MakeEntry(uint32_t predatorID) const { return (static_cast<uint64_t>(m_step) << 32) | predatorID; }
+
+    std::unique_ptr<std::atomic<uint64_t>[]> m_entries;
+    size_t m_slotsCount = 0;
+    uint32_t m_step = 0; // Entries from older steps count as unclaimed
+};
@@ -8,13 +8,15 @@ Projectile::OnDestroyDelegate Projectile::OnDestroy = nullptr;
 
 namespace
 {
-    constexpr float PREDATOR_PURSUE_RADIUS = 10.0f;
     constexpr float PREDATOR_ACCELERATION_MULTIPLIER = 30.0f;
     constexpr int PREDATOR_MAX_CONSUMPTION_COUNT = 10;
+    constexpr int MAX_BOUNCES_PER_STEP = 4;
+    constexpr float CONTACT_OFFSET = 1.0e-3f; // Kept from a hit surface, so the next sweep doesn't start touching it
 }
 
-Projectile::Projectile(Vector3 velocity, Vector3 position, Vector3 size, float drag, float energy, bool predator)
+Projectile::Projectile(uint32_t id, Vector3 velocity, Vector3 position, Vector3 size, float drag, float energy, bool predator)
     : MovingEntity(position, size, velocity)
+    , m_id(id)
     , m_drag(drag)
     , m_energy(energy)
     , m_isPredator(predator)
@@ -32,7 +34,7 @@ bool Projectile::ConsumedMax() const
     return m_consumedBoidsCount >= PREDATOR_MAX_CONSUMPTION_COUNT;
 }
 
-void Projectile::UpdateMovement(float deltaTime)
+void Projectile::UpdateMovement(float deltaTime, const City& city)
 {
     m_velocity *= std::max(0.0f, 1.0f - m_drag * deltaTime);
 
@@ -52,11 +54,49 @@ void Projectile::UpdateMovement(float deltaTime)
         return;
     }
 
-    UpdatePositionBasedOnVelocity(deltaTime);
+    MoveThroughCity(deltaTime, city);
 }
 
-void Projectile::CheckForBoids(const SpatialHashGrid<Boid>& boidsHashGrid)
+void Projectile::MoveThroughCity(float deltaTime, const City& city)
 {
+    // Swept instead of moved and checked, so fast projectiles and long steps bounce off thin skyscrapers instead of passing through them.
+    // After a hit the rest of the step continues along the reflected direction
+    Vector3 displacement = m_velocity * deltaTime;
+    for (int bounce = 0; bounce < MAX_BOUNCES_PER_STEP; bounce++)
+    {
+        float timeOfImpact;
+        Vector3 normal;
+        if (!city.SweepSphere(position, displacement, bounds.biggestExtent, timeOfImpact, normal))
+        {
+            Teleport(position + displacement);
+            return;
+        }
+
+        Teleport(position + displacement * timeOfImpact + normal * CONTACT_OFFSET);
+        displacement = Vector3::Reflect(displacement * (1.0f - timeOfImpact), normal);
+        m_velocity = Vector3::Reflect(m_velocity, normal);
+    }
+
+    // Out of bounces (wedged between skyscrapers), the rest of the step is dropped rather than risk moving into one
+}
+
+int Projectile::GetRemainingConsumptionCount() const
+{
+    return m_isPredator ? std::max(0, PREDATOR_MAX_CONSUMPTION_COUNT - m_consumedBoidsCount) : 0;
+}
+
+void Projectile::ConsumeBoid(Boid& boid)
+{
+    assert(CanConsume());
+    boid.Destroy();
+    ++m_consumedBoidsCount;
+    m_energy += 1.0f;
+}
+
+void Projectile::FindPrey(const SpatialHashGrid<Boid>& boidsHashGrid, float pursueRadius, std::vector<Boid*>& reachableBoids)
+{
+    reachableBoids.clear();
+
     if (!CanConsume())
     {
         //energy = 0.0f; don't empty energy so they can act as avoidance points
@@ -64,18 +104,22 @@ void Projectile::CheckForBoids(const SpatialHashGrid<Boid>& boidsHashGrid)
         return;
     }
 
-    const std::vector<Boid*> boids = boidsHashGrid.QueryInRadius(position, PREDATOR_PURSUE_RADIUS);
+    const std::vector<Boid*> boids = boidsHashGrid.QueryInRadius(position, pursueRadius);
 
     Vector3 bestDirection = m_acceleration; // if no valid boid will be found just use previous acceleration
     float closestDistanceSquared = std::numeric_limits<float>::max();
 
     for (Boid* boid : boids)
     {
-        if (CanConsume() && bounds.RadiusIntersects(boid->GetBounds()))
+        // A ghost is eaten, if at all, by this predator's copy in the process that owns it
+        if (boid->IsPendingDestroy() || boid->IsGhost())
+        {
+            continue;
+        }
+
+        if (bounds.RadiusIntersects(boid->GetPosition(), Boid::RADIUS))
         {
-            boid->Destroy();
-            ++m_consumedBoidsCount;
-            m_energy += 1.0f;
+            reachableBoids.push_back(boid);
             continue;
         }
 
@@ -90,26 +134,36 @@ void Projectile::CheckForBoids(const SpatialHashGrid<Boid>& boidsHashGrid)
     }
 
     m_acceleration = MathHelper::GetNormalized(bestDirection) * PREDATOR_ACCELERATION_MULTIPLIER;
+
+    // Eaten in id order, so which ones a predator close to its limit takes doesn't depend on the grid layout
+    std::sort(reachableBoids.begin(), reachableBoids.end(), [](const Boid* a, const Boid* b) { return a->id < b->id; });
 }
 
-void Projectile::CheckForSkyscrapers(const std::vector<Entity>& skyscrapers)
+void Projectile::CheckForSkyscrapers(const City& city)
 {
-    for (const Entity& skyscraper : skyscrapers)
+    // Pushes out of and bounces off the first skyscraper overlapped, for projectiles that start a step inside one (spawned there or a city change).
+    // Hits while moving are found by MoveThroughCity, only skyscrapers overlapping the projectile are visited
+    const Bounds* hitSkyscraper = nullptr;
+    city.ForEachSkyscraperInRange(bounds.min, bounds.max, [&](const Bounds& skyscraper)
     {
-        if (!skyscraper.GetBounds().IntersectsSphere(bounds))
+        if (!hitSkyscraper && skyscraper.IntersectsSphere(bounds))
         {
-            continue;
-        }
-        ;
-        const Vector3 normal = skyscraper.GetBounds().ClosestSurfaceNormal(position);
-        const Vector3 closestPoint = skyscraper.GetBounds().ClosestPoint(position);
-        const float penetrationDepth = bounds.biggestExtent - (position - closestPoint).Length();
-        if (penetrationDepth > 0.0f)
-        {
-            Teleport(position + normal * penetrationDepth);
+            hitSkyscraper = &skyscraper;
         }
+    });
 
-        m_velocity = Vector3::Reflect(m_velocity, normal);
+    if (!hitSkyscraper)
+    {
         return;
     }
+
+    const Vector3 normal = hitSkyscraper->ClosestSurfaceNormal(position);
+    const Vector3 closestPoint = hitSkyscraper->ClosestPoint(position);
+    const float penetrationDepth = bounds.biggestExtent - (position - closestPoint).Length();
+    if (penetrationDepth > 0.0f)
+    {
+        Teleport(position + normal * penetrationDepth);
+    }
+
+    m_velocity = Vector3::Reflect(m_velocity, normal);
 }
\ No newline at end of file
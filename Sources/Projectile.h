@@ -3,6 +3,7 @@
 #include "SpatialHashGrid.h"
 
 class Boid;
+class City;
 class Entity;
 
 class Projectile : public MovingEntity
@@ -11,20 +12,30 @@ public:
 	using OnDestroyDelegate = std::function<void(Vector3 position, Vector3 velocity)>;
 	static OnDestroyDelegate OnDestroy;
 
-	Projectile(Vector3 velocity, Vector3 position, Vector3 size, float drag, float energy, bool predator);
+	Projectile(uint32_t id, Vector3 velocity, Vector3 position, Vector3 size, float drag, float energy, bool predator);
 
 	bool ConsumedMax() const;
 
-	void UpdateMovement(float deltaTime);
-	void CheckForBoids(const SpatialHashGrid<Boid>& boidsHashGrid);
-	void CheckForSkyscrapers(const std::vector<Entity>& skyscrapers);
+	void UpdateMovement(float deltaTime, const City& city);
+	// Predation is split so predators can run in parallel: FindPrey only changes this projectile and returns the boids within reach,
+	// which of them get eaten is decided by ProjectileController through a PreyClaimTable
+	void FindPrey(const SpatialHashGrid<Boid>& boidsHashGrid, float pursueRadius, std::vector<Boid*>& reachableBoids);
+	void ConsumeBoid(Boid& boid);
+	int GetRemainingConsumptionCount() const;
+	void CheckForSkyscrapers(const City& city);
 
+	uint32_t GetID() const { return m_id; }
 	float GetEnergy() const { return m_energy; }
+	float GetDrag() const { return m_drag; }
+	int GetConsumedBoidsCount() const { return m_consumedBoidsCount; }
+	void SetConsumedBoidsCount(int consumedBoidsCount) { m_consumedBoidsCount = consumedBoidsCount; }
 	bool IsPredator() const { return m_isPredator;  }
 
 private:
 	bool CanConsume() const;
+	void MoveThroughCity(float deltaTime, const City& city);
 
+	uint32_t m_id;
 	float m_drag;
 	float m_energy;
 	bool m_isPredator;
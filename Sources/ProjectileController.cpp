@@ -1,20 +1,28 @@
 #include "pch.h"
 #include "ProjectileController.h"
+#include "FrameworkInstancedRenderContext.h"
 #include "Game.h"
 #include "Projectile.h"
+#include "SharedState.h"
+#include "SimulationState.h"
 
 namespace
 {
     constexpr float PROJECTILE_RADIUS = 1.0f;
+    constexpr size_t PROJECTILES_CAPACITY = 256; // Projectiles are values in one vector, erasing keeps the capacity so only waves above this allocate
+    constexpr size_t PARALLEL_PREDATION_MIN_PROJECTILES = 64;
+    constexpr size_t PREDATION_CHUNK_SIZE = 16;
 }
 
 ProjectileController::ProjectileController(const Game& game)
     :  m_game(game)
     , m_leftButtonPressedLastFrame(false)
     , m_rightButtonPressedLastFrame(false)
-    , m_projectileDrag(2.0f)
-    , m_projectileSpeed(65.0f)
-    , m_projectileEnergy(5.0f)
+    , m_projectileDrag(DEFAULT_SIMULATION_PARAMETERS.projectileDrag)
+    , m_projectileSpeed(DEFAULT_SIMULATION_PARAMETERS.projectileSpeed)
+    , m_projectileEnergy(DEFAULT_SIMULATION_PARAMETERS.projectileEnergy)
+    , m_predatorPursueRadius(DEFAULT_SIMULATION_PARAMETERS.predatorPursueRadius)
+    , m_nextProjectileID(0)
 {
 }
 
@@ -22,6 +30,16 @@ void ProjectileController::OnInitialize()
 {
     m_projectileShape.reset();
     m_projectileShape = GetEngine().CreateSpherePrimitive(PROJECTILE_RADIUS);
+    m_projectiles.reserve(PROJECTILES_CAPACITY);
+}
+
+void ProjectileController::ApplyParameters(const SimulationParameters& parameters)
+{
+    // Projectiles already flying keep the drag and energy they were shot with
+    m_projectileDrag = parameters.projectileDrag;
+    m_projectileSpeed = parameters.projectileSpeed;
+    m_projectileEnergy = parameters.projectileEnergy;
+    m_predatorPursueRadius = parameters.predatorPursueRadius;
 }
 
 void ProjectileController::OnShutdown()
@@ -30,18 +48,15 @@ void ProjectileController::OnShutdown()
     m_projectiles.clear();
 }
 
-void ProjectileController::OnUpdate(float deltaTime, DirectX::Mouse& mouse, DirectX::GamePad& gamepad)
+void ProjectileController::OnUpdate(float deltaTime, const DirectX::Mouse::State& mouseState, const DirectX::GamePad::State& padState)
 {
-    UpdateInput(mouse, gamepad);
+    UpdateInput(mouseState, padState);
     UpdateProjectiles(deltaTime);
     RemovePendingProjectiles();
 }
 
-void ProjectileController::UpdateInput(DirectX::Mouse& mouse, DirectX::GamePad& gamepad)
+void ProjectileController::UpdateInput(const DirectX::Mouse::State& mouseState, const DirectX::GamePad::State& padState)
 {
-    auto padState = gamepad.GetState(0);
-    auto mouseState = mouse.GetState();
-
     const bool leftButtonPressedThisFrame = mouseState.leftButton || (padState.IsConnected() && padState.IsRightTriggerPressed());
     const bool rightButtonPressedThisFrame = mouseState.rightButton || (padState.IsConnected() && padState.IsLeftTriggerPressed());
 
@@ -63,9 +78,77 @@ void ProjectileController::UpdateProjectiles(float deltaTime)
 {
     for (Projectile& projectile : m_projectiles)
     {
-        projectile.CheckForSkyscrapers(m_game.GetCity().GetSkyscrapers());
-        projectile.CheckForBoids(m_game.GetBoidManager().GetBoidsHashGrid());
-        projectile.UpdateMovement(deltaTime);
+        projectile.CheckForSkyscrapers(m_game.GetCity());
+    }
+
+    UpdatePredation();
+
+    for (Projectile& projectile : m_projectiles)
+    {
+        projectile.UpdateMovement(deltaTime, m_game.GetCity());
+    }
+}
+
+void ProjectileController::UpdatePredation()
+{
+    const BoidManager& boidManager = m_game.GetBoidManager();
+    const SpatialHashGrid<Boid>& boidsHashGrid = boidManager.GetBoidsHashGrid();
+    const ObjectPool<Boid>& boidPool = boidManager.GetBoidPool();
+
+    if (m_reachableBoids.size() < m_projectiles.size())
+    {
+        m_reachableBoids.resize(m_projectiles.size());
+    }
+
+    if (!m_predationWorkers && m_projectiles.size() >= PARALLEL_PREDATION_MIN_PROJECTILES)
+    {
+        m_predationWorkers = std::make_unique<WorkerPool>();
+    }
+
+    m_preyClaims.BeginStep(boidPool.GetCapacity());
+
+    // Every predator claims all boids within reach, boids are only read here
+    ForEachProjectileRange([&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            Projectile& projectile = m_projectiles[i];
+            projectile.FindPrey(boidsHashGrid, m_predatorPursueRadius, m_reachableBoids[i]);
+
+            for (const Boid* boid : m_reachableBoids[i])
+            {
+                m_preyClaims.Claim(boidPool.GetHandle(boid).index, projectile.GetID());
+            }
+        }
+    });
+
+    // Each boid has exactly one winner, so every boid is destroyed by one thread at most. Boids a predator won beyond
+    // its consumption limit aren't handed to the runner up, they survive this step and can be claimed again in the next one
+    ForEachProjectileRange([&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            Projectile& projectile = m_projectiles[i];
+            for (Boid* boid : m_reachableBoids[i])
+            {
+                if (projectile.GetRemainingConsumptionCount() > 0 && m_preyClaims.IsClaimedBy(boidPool.GetHandle(boid).index, projectile.GetID()))
+                {
+                    projectile.ConsumeBoid(*boid);
+                }
+            }
+        }
+    });
+}
+
+void ProjectileController::ForEachProjectileRange(const WorkerPool::RangeJob& job)
+{
+    if (m_predationWorkers)
+    {
+        m_predationWorkers->ParallelFor(m_projectiles.size(), PREDATION_CHUNK_SIZE, job);
+    }
+    else
+    {
+        job(0, m_projectiles.size());
     }
 }
 
@@ -86,18 +169,117 @@ void ProjectileController::RemovePendingProjectiles()
 
 void ProjectileController::OnRender(framework::RenderContextPtr& renderContext)
 {
-    for (Projectile& projectile : m_projectiles)
+    if (m_projectiles.empty())
+    {
+        return;
+    }
+
+    // Colors fade with energy so every projectile gets its own palette entry, but all of them still go in a single draw
+    m_projectileColors.clear();
+    m_projectileInstances.Begin(1);
+    m_projectileInstances.CountInstances(0, m_projectiles.size());
+    m_projectileInstances.Allocate();
+
+    for (const Projectile& projectile : m_projectiles)
     {
-        const XMVECTOR projectileColor = (!projectile.IsPredator() ? Colors::Green.v :
-                                            (projectile.ConsumedMax() ? Colors::Purple.v : Colors::Red.v));
-        const Color finalColor = Color::Lerp(Colors::Black.v, projectileColor, (projectile.GetEnergy() / m_projectileEnergy));
-        renderContext->RenderPrimitive(m_projectileShape, Vector3::One, projectile.GetPosition(), Vector3::Zero, finalColor);
+        m_projectileInstances.AddInstance(0, projectile.GetPosition(), static_cast<uint32_t>(m_projectileColors.size()));
+        m_projectileColors.push_back(GetProjectileColor(projectile));
     }
+
+    FrameworkInstancedRenderContext instancedRenderContext(renderContext);
+    RenderInstances(instancedRenderContext, m_projectileInstances, m_projectileColors);
+}
+
+void ProjectileController::RenderInstances(IInstancedRenderContext& instancedRenderContext, const RenderInstanceBuffer& projectileInstances, const std::vector<XMVECTOR>& projectileColors) const
+{
+    if (projectileInstances.GetBatchesCount() == 0 || projectileInstances.GetBatchSize(0) == 0)
+    {
+        return;
+    }
+
+    instancedRenderContext.RenderPrimitiveInstanced(m_projectileShape, Vector3::One, projectileInstances.GetBatchInstances(0), projectileInstances.GetBatchSize(0), projectileColors.data());
+}
+
+void ProjectileController::WriteSnapshot(SimulationSnapshot& snapshot) const
+{
+    for (const Projectile& projectile : m_projectiles)
+    {
+        snapshot.projectileIDs.push_back(projectile.GetID());
+        snapshot.projectilePositions.push_back(projectile.GetPosition());
+        snapshot.projectileColors.push_back(GetProjectileColor(projectile));
+    }
+}
+
+void ProjectileController::WriteSharedState(SharedStateFrame& frame) const
+{
+    const uint32_t count = static_cast<uint32_t>(std::min<size_t>(m_projectiles.size(), frame.projectilesCapacity));
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const Projectile& projectile = m_projectiles[i];
+        frame.projectilePositions[i] = projectile.GetPosition();
+        frame.projectileVelocities[i] = projectile.GetVelocity();
+        frame.projectilePredators[i] = projectile.IsPredator() ? 1 : 0;
+    }
+
+    frame.projectilesCount = count;
+}
+
+void ProjectileController::SaveState(SimulationStateWriter& writer) const
+{
+    writer.Write(SimulationStateSection::ProjectileController, ProjectileControllerState{ static_cast<uint32_t>(m_projectiles.size()), m_nextProjectileID });
+
+    ProjectileState* states = writer.Allocate<ProjectileState>(SimulationStateSection::Projectiles, m_projectiles.size());
+    for (const Projectile& projectile : m_projectiles)
+    {
+        ProjectileState& state = *states++;
+        state.id = projectile.GetID();
+        state.position = projectile.GetPosition();
+        state.velocity = projectile.GetVelocity();
+        state.acceleration = projectile.GetAcceleration();
+        state.drag = projectile.GetDrag();
+        state.energy = projectile.GetEnergy();
+        state.consumedBoidsCount = projectile.GetConsumedBoidsCount();
+        state.predator = projectile.IsPredator() ? 1 : 0;
+    }
+}
+
+bool ProjectileController::IsStateValid(const SimulationStateReader& reader) const
+{
+    const ProjectileControllerState* controllerState = reader.Get<ProjectileControllerState>(SimulationStateSection::ProjectileController, 1);
+    return controllerState && reader.Get<ProjectileState>(SimulationStateSection::Projectiles, controllerState->projectilesCount);
+}
+
+void ProjectileController::LoadState(const SimulationStateReader& reader)
+{
+    assert(IsStateValid(reader));
+
+    const ProjectileControllerState* controllerState = reader.Get<ProjectileControllerState>(SimulationStateSection::ProjectileController, 1);
+    const ProjectileState* states = reader.Get<ProjectileState>(SimulationStateSection::Projectiles, controllerState->projectilesCount);
+
+    m_projectiles.clear();
+    m_nextProjectileID = controllerState->nextProjectileID;
+
+    for (uint32_t i = 0; i < controllerState->projectilesCount; i++)
+    {
+        const ProjectileState& state = states[i];
+        Projectile projectile(state.id, state.velocity, state.position, Vector3::One * (PROJECTILE_RADIUS * 2.0f), state.drag, state.energy, state.predator != 0);
+        projectile.SetAcceleration(state.acceleration);
+        projectile.SetConsumedBoidsCount(state.consumedBoidsCount);
+        m_projectiles.push_back(std::move(projectile));
+    }
+}
+
+XMVECTOR ProjectileController::GetProjectileColor(const Projectile& projectile) const
+{
+    const XMVECTOR projectileColor = (!projectile.IsPredator() ? Colors::Green.v :
+                                        (projectile.ConsumedMax() ? Colors::Purple.v : Colors::Red.v));
+    return Color::Lerp(Colors::Black.v, projectileColor, (projectile.GetEnergy() / m_projectileEnergy));
 }
 
 void ProjectileController::SpawnProjectile(bool predator)
 {
-    Projectile projectile(m_game.GetCamera().GetCameraDir() * m_projectileSpeed, m_game.GetCamera().GetCameraPos(), Vector3::One *(PROJECTILE_RADIUS * 2.0f), m_projectileDrag, m_projectileEnergy, predator);
+    const Camera& camera = m_game.GetSimulationCamera();
+    Projectile projectile(m_nextProjectileID++, camera.GetCameraDir() * m_projectileSpeed, camera.GetCameraPos(), Vector3::One *(PROJECTILE_RADIUS * 2.0f), m_projectileDrag, m_projectileEnergy, predator);
     m_projectiles.push_back(std::move(projectile));
 }
 
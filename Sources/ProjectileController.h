@@ -1,11 +1,19 @@
 #pragma once
 #include "IRenderContext.h"
+#include "PreyClaimTable.h"
 #include "Projectile.h"
+#include "RenderInstanceBuffer.h"
+#include "SimulationParameters.h"
+#include "SimulationSnapshot.h"
 #include "SpatialHashGrid.h"
+#include "WorkerPool.h"
 
 class Boid;
 class Skyscraper;
 class Game;
+struct SharedStateFrame;
+class SimulationStateReader;
+class SimulationStateWriter;
 
 class ProjectileController
 {
@@ -13,13 +21,23 @@ public:
 	ProjectileController(const Game& game);
 
 	void OnInitialize();
-    void UpdateInput(DirectX::Mouse& mouse, DirectX::GamePad& gamepad);
-    void OnUpdate(float deltaTime, DirectX::Mouse& mouse, DirectX::GamePad& gamepad);
+	void ApplyParameters(const SimulationParameters& parameters);
+    void UpdateInput(const DirectX::Mouse::State& mouseState, const DirectX::GamePad::State& padState);
+    void OnUpdate(float deltaTime, const DirectX::Mouse::State& mouseState, const DirectX::GamePad::State& padState);
 	void OnRender(framework::RenderContextPtr& renderContext);
+	void RenderInstances(IInstancedRenderContext& instancedRenderContext, const RenderInstanceBuffer& projectileInstances, const std::vector<XMVECTOR>& projectileColors) const;
+	void WriteSnapshot(SimulationSnapshot& snapshot) const;
+	void WriteSharedState(SharedStateFrame& frame) const;
+
+	void SaveState(SimulationStateWriter& writer) const;
+	bool IsStateValid(const SimulationStateReader& reader) const;
+	void LoadState(const SimulationStateReader& reader);
 	void OnShutdown();
 
     void UpdateProjectiles(float deltaTime);
     void RemovePendingProjectiles();
+	void SpawnProjectile(bool predator);
+	void ClearProjectiles() { m_projectiles.clear(); }
 
 	const std::vector<Projectile>& GetProjectiles() const;
 private:
@@ -31,11 +49,21 @@ private:
 	float m_projectileDrag;
 	float m_projectileSpeed;
 	float m_projectileEnergy;
+	float m_predatorPursueRadius;
+	uint32_t m_nextProjectileID;
 
 	std::vector<Projectile> m_projectiles;
+	std::vector<XMVECTOR> m_projectileColors;
+	RenderInstanceBuffer m_projectileInstances;
 	std::unique_ptr< DirectX::GeometricPrimitive > m_projectileShape;
 
-	void SpawnProjectile(bool predator);
+	XMVECTOR GetProjectileColor(const Projectile& projectile) const;
+	void UpdatePredation();
+	void ForEachProjectileRange(const WorkerPool::RangeJob& job);
+
+	PreyClaimTable m_preyClaims;
+	std::vector<std::vector<Boid*>> m_reachableBoids; // Per projectile, reused between steps
+	std::unique_ptr<WorkerPool> m_predationWorkers; // Only started once there are enough projectiles to split
 
 };
 
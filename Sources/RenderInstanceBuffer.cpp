@@ -0,0 +1,50 @@
+#include "pch.h"
+#include "RenderInstanceBuffer.h"
+
+void RenderInstanceBuffer::Begin(int batchesCount)
+{
+    m_instances.clear();
+    m_batchCounts.assign(batchesCount, 0);
+}
+
+void RenderInstanceBuffer::Allocate()
+{
+    m_batchOffsets.resize(m_batchCounts.size());
+    m_batchCursors.resize(m_batchCounts.size());
+
+    size_t offset = 0;
+    for (size_t i = 0; i < m_batchCounts.size(); i++)
+    {
+        m_batchOffsets[i] = offset;
+        m_batchCursors[i] = offset;
+        offset += m_batchCounts[i];
+    }
+
+    m_instances.resize(offset);
+}
+
+void RenderInstanceBuffer::AddInstance(int batch, Vector3 position, uint32_t colorIndex)
+{
+    assert(m_batchCursors[batch] < m_batchOffsets[batch] + m_batchCounts[batch]);
+    RenderInstance& instance = m_instances[m_batchCursors[batch]++];
+    instance.position = position;
+    instance.colorIndex = colorIndex;
+}
+
+void HeadlessInstancedRenderContext::RenderPrimitiveInstanced(const std::unique_ptr<DirectX::GeometricPrimitive>& primitive, Vector3 scale,
+                                                              const RenderInstance* instances, size_t instancesCount, const XMVECTOR* palette)
+{
+    UNREFERENCED_PARAMETER(primitive);
+    UNREFERENCED_PARAMETER(scale);
+    UNREFERENCED_PARAMETER(instances);
+    UNREFERENCED_PARAMETER(palette);
+
+    ++m_drawCallsCount;
+    m_submittedInstancesCount += instancesCount;
+}
+
+void HeadlessInstancedRenderContext::ResetStats()
+{
+    m_drawCallsCount = 0;
+    m_submittedInstancesCount = 0;
+}
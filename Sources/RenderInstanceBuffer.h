@@ -0,0 +1,63 @@
+#pragma once
+
+namespace DirectX
+{
+    class GeometricPrimitive;
+}
+
+// 16 bytes per instance, laid out so it can be uploaded as is into a per instance vertex buffer
+struct RenderInstance
+{
+    Vector3 position;
+    uint32_t colorIndex;
+};
+
+/// Packs instances of all batches (flocks) into one contiguous buffer with per batch ranges.
+/// Filling is a two pass counting sort (CountInstance for every instance, Allocate, then AddInstance), so no per frame allocations after warm up.
+class RenderInstanceBuffer
+{
+public:
+    void Begin(int batchesCount);
+    void CountInstance(int batch) { ++m_batchCounts[batch]; }
+    void CountInstances(int batch, size_t count) { m_batchCounts[batch] += count; }
+    void Allocate();
+    void AddInstance(int batch, Vector3 position, uint32_t colorIndex);
+
+    int GetBatchesCount() const { return static_cast<int>(m_batchCounts.size()); }
+    const RenderInstance* GetBatchInstances(int batch) const { return m_instances.data() + m_batchOffsets[batch]; }
+    size_t GetBatchSize(int batch) const { return m_batchCounts[batch]; }
+    size_t GetInstancesCount() const { return m_instances.size(); }
+
+private:
+    std::vector<RenderInstance> m_instances;
+    std::vector<size_t> m_batchCounts;
+    std::vector<size_t> m_batchOffsets;
+    std::vector<size_t> m_batchCursors;
+};
+
+class IInstancedRenderContext
+{
+public:
+    virtual ~IInstancedRenderContext() = default;
+
+    // One draw for all instances, colors are looked up by RenderInstance::colorIndex in the palette
+    virtual void RenderPrimitiveInstanced(const std::unique_ptr<DirectX::GeometricPrimitive>& primitive, Vector3 scale,
+                                          const RenderInstance* instances, size_t instancesCount, const XMVECTOR* palette) = 0;
+};
+
+// Doesn't draw anything, only counts, so the packing and submission cost can be measured without a window or GPU
+class HeadlessInstancedRenderContext : public IInstancedRenderContext
+{
+public:
+    void RenderPrimitiveInstanced(const std::unique_ptr<DirectX::GeometricPrimitive>& primitive, Vector3 scale,
+                                  const RenderInstance* instances, size_t instancesCount, const XMVECTOR* palette) override;
+
+    void ResetStats();
+    int GetDrawCallsCount() const { return m_drawCallsCount; }
+    size_t GetSubmittedInstancesCount() const { return m_submittedInstancesCount; }
+    size_t GetSubmittedBytes() const { return m_submittedInstancesCount * sizeof(RenderInstance); }
+
+private:
+    int m_drawCallsCount = 0;
+    size_t m_submittedInstancesCount = 0;
+};
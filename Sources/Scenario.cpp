@@ -0,0 +1,394 @@
+#include "pch.h"
+#include "Scenario.h"
+#include "Game.h"
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+    size_t GetPeakMemoryBytes()
+    {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters;
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        {
+            return counters.PeakWorkingSetSize;
+        }
+
+        return 0;
+#else
+        rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) == 0)
+        {
+            return static_cast<size_t>(usage.ru_maxrss) * 1024; // kilobytes on Linux
+        }
+
+        return 0;
+#endif
+    }
+
+    constexpr float CONFORMANCE_STEERING_BUDGET_MILLISECONDS = 1.0e6f;
+
+    // Reference frames on disk: boids count, then positions and velocities
+    void WriteReferenceFrame(std::ostream& stream, const SimulationSnapshot& snapshot)
+    {
+        const uint64_t count = snapshot.boidPositions.size();
+        stream.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        stream.write(reinterpret_cast<const char*>(snapshot.boidPositions.data()), count * sizeof(Vector3));
+        stream.write(reinterpret_cast<const char*>(snapshot.boidVelocities.data()), count * sizeof(Vector3));
+    }
+
+    bool ReadReferenceFrame(std::istream& stream, SimulationSnapshot& snapshot)
+    {
+        uint64_t count = 0;
+        if (!stream.read(reinterpret_cast<char*>(&count), sizeof(count)))
+        {
+            return false;
+        }
+
+        snapshot.boidPositions.resize(count);
+        snapshot.boidVelocities.resize(count);
+        stream.read(reinterpret_cast<char*>(snapshot.boidPositions.data()), count * sizeof(Vector3));
+        stream.read(reinterpret_cast<char*>(snapshot.boidVelocities.data()), count * sizeof(Vector3));
+        return static_cast<bool>(stream);
+    }
+
+    // Nearest rank percentile of sorted values
+    double GetPercentile(const std::vector<double>& sortedValues, double percentile)
+    {
+        if (sortedValues.empty())
+        {
+            return 0.0;
+        }
+
+        const size_t rank = static_cast<size_t>(std::ceil(percentile * static_cast<double>(sortedValues.size())));
+        return sortedValues[std::clamp<size_t>(rank, 1, sortedValues.size()) - 1];
+    }
+
+    bool ParseEventType(const std::string& name, ScenarioEventType& type)
+    {
+        static const std::pair<const char*, ScenarioEventType> eventTypes[] =
+        {
+            { "spawn_boids", ScenarioEventType::SpawnBoids },
+            { "remove_boids", ScenarioEventType::RemoveBoids },
+            { "predator", ScenarioEventType::PredatorProjectiles },
+            { "attractor", ScenarioEventType::AttractorProjectiles }
+        };
+
+        for (const auto& eventType : eventTypes)
+        {
+            if (name == eventType.first)
+            {
+                type = eventType.second;
+                return true;
+            }
+        }
+
+        return false;
+    }
+}
+
+bool Scenario::Load(const std::string& path, std::string& error)
+{
+    std::ifstream stream(path);
+    if (!stream)
+    {
+        error = "can't open " + path;
+        return false;
+    }
+
+    std::string line;
+    for (int lineNumber = 1; std::getline(stream, line); lineNumber++)
+    {
+        line = line.substr(0, line.find('#'));
+        std::istringstream lineStream(line);
+        std::string statement;
+
+        if (!(lineStream >> statement))
+        {
+            continue;
+        }
+
+        bool isValid = true;
+
+        if (statement == "frames")
+        {
+            isValid = static_cast<bool>(lineStream >> framesCount) && framesCount > 0;
+        }
+        else if (statement == "time_step")
+        {
+            isValid = static_cast<bool>(lineStream >> timeStep) && timeStep > 0.0f;
+        }
+        else if (statement == "seed")
+        {
+            isValid = static_cast<bool>(lineStream >> seed);
+        }
+        else if (statement == "flocks")
+        {
+            hasFlocksCount = true;
+            isValid = static_cast<bool>(lineStream >> flocksCount) && flocksCount > 0 && flocksCount <= BoidManager::MAX_FLOCKS_COUNT;
+        }
+        else if (statement == "city")
+        {
+            generateCity = true;
+            isValid = static_cast<bool>(lineStream >> city.skyscrapersCount >> city.seed >> city.density);
+        }
+        else if (statement == "integration")
+        {
+            std::string methodName;
+            hasIntegration = true;
+            isValid = static_cast<bool>(lineStream >> methodName >> integration.substepsCount) && ParseIntegrationMethod(methodName, integration.method) && integration.substepsCount > 0;
+        }
+        else if (statement == "camera")
+        {
+            ScenarioCameraKey key;
+            isValid = static_cast<bool>(lineStream >> key.time >> key.position.x >> key.position.y >> key.position.z >> key.direction.x >> key.direction.y >> key.direction.z);
+            cameraKeys.push_back(key);
+        }
+        else if (statement == "at")
+        {
+            ScenarioEvent scenarioEvent;
+            std::string eventName;
+            isValid = static_cast<bool>(lineStream >> scenarioEvent.time >> eventName >> scenarioEvent.count) && ParseEventType(eventName, scenarioEvent.type);
+            events.push_back(scenarioEvent);
+        }
+        else
+        {
+            isValid = false;
+        }
+
+        if (!isValid)
+        {
+            error = path + ":" + std::to_string(lineNumber) + ": invalid statement '" + line + "'";
+            return false;
+        }
+    }
+
+    // Stable, events at the same time keep the file order
+    std::stable_sort(events.begin(), events.end(), [](const ScenarioEvent& a, const ScenarioEvent& b) { return a.time < b.time; });
+    std::stable_sort(cameraKeys.begin(), cameraKeys.end(), [](const ScenarioCameraKey& a, const ScenarioCameraKey& b) { return a.time < b.time; });
+    return true;
+}
+
+std::string ScenarioReport::ToString() const
+{
+    std::ostringstream stream;
+    stream << "frames: " << framesCount << "\n"
+           << "total: " << totalMilliseconds << " ms\n"
+           << "p50: " << p50Milliseconds << " ms\n"
+           << "p95: " << p95Milliseconds << " ms\n"
+           << "p99: " << p99Milliseconds << " ms\n"
+           << "max: " << maxMilliseconds << " ms\n"
+           << "peak memory: " << peakMemoryBytes / (1024 * 1024) << " MB\n"
+           << "final boids: " << finalBoidsCount << "\n"
+           << "final projectiles: " << finalProjectilesCount << "\n";
+    return stream.str();
+}
+
+std::string ConformanceReport::ToString() const
+{
+    std::ostringstream stream;
+    stream << "backend: " << GetSimulationBackendName(backendType) << (IsPassed() ? ", passed" : ", FAILED") << "\n"
+           << "frames: " << framesCount << ", tolerance: " << tolerance << "\n"
+           << "max position deviation: " << maxPositionDeviation << "\n"
+           << "max velocity deviation: " << maxVelocityDeviation << "\n";
+
+    if (!IsPassed())
+    {
+        stream << "first divergent frame: " << firstDivergentFrame << "\n";
+    }
+
+    return stream.str();
+}
+
+ScenarioRunner::ScenarioRunner(Game& game)
+    : m_game(game)
+{
+}
+
+ScenarioReport ScenarioRunner::Run(const Scenario& scenario, const FrameCallback& onFrameSimulated)
+{
+    std::vector<double> frameTimes = RunFrames(scenario, onFrameSimulated);
+
+    ScenarioReport report;
+    report.framesCount = scenario.framesCount;
+    report.totalMilliseconds = std::accumulate(frameTimes.begin(), frameTimes.end(), 0.0);
+
+    std::sort(frameTimes.begin(), frameTimes.end());
+    report.p50Milliseconds = GetPercentile(frameTimes, 0.50);
+    report.p95Milliseconds = GetPercentile(frameTimes, 0.95);
+    report.p99Milliseconds = GetPercentile(frameTimes, 0.99);
+    report.maxMilliseconds = frameTimes.empty() ? 0.0 : frameTimes.back();
+    report.peakMemoryBytes = GetPeakMemoryBytes();
+    report.finalBoidsCount = m_game.GetBoidManager().GetBoidsCount();
+    report.finalProjectilesCount = m_game.GetProjectileController().GetProjectiles().size();
+    return report;
+}
+
+ConformanceReport ScenarioRunner::RunConformance(const Scenario& scenario, SimulationBackendType backendType, float tolerance, const std::string& referencePath)
+{
+    BoidManager& boidManager = m_game.GetBoidManager();
+    const SimulationBackendType previousType = boidManager.GetSimulationBackendType();
+    boidManager.SetSteeringBudget(CONFORMANCE_STEERING_BUDGET_MILLISECONDS);
+
+    // Only one frame of each run is in memory at a time, the reference one goes through the file
+    SimulationSnapshot snapshot;
+    std::ofstream referenceOutput(referencePath, std::ios::binary | std::ios::trunc);
+    boidManager.SetSimulationBackend(SimulationBackendType::Reference);
+    RunFrames(scenario, [&](int frame)
+    {
+        UNREFERENCED_PARAMETER(frame);
+        snapshot.Clear();
+        boidManager.WriteSnapshot(snapshot);
+        WriteReferenceFrame(referenceOutput, snapshot);
+    });
+
+    referenceOutput.close();
+    if (!referenceOutput)
+    {
+        std::cerr << "Failed to write conformance reference frames to " << referencePath << std::endl;
+    }
+
+    ConformanceReport report;
+    report.backendType = backendType;
+    report.tolerance = tolerance;
+    report.framesCount = scenario.framesCount;
+
+    SimulationSnapshot reference;
+    std::ifstream referenceInput(referencePath, std::ios::binary);
+    boidManager.SetSimulationBackend(backendType);
+    RunFrames(scenario, [&](int frame)
+    {
+        snapshot.Clear();
+        boidManager.WriteSnapshot(snapshot);
+
+        // A missing reference frame can't pass
+        bool isDivergent = !ReadReferenceFrame(referenceInput, reference) || snapshot.boidPositions.size() != reference.boidPositions.size();
+        for (size_t i = 0; !isDivergent && i < snapshot.boidPositions.size(); i++)
+        {
+            const float positionDeviation = Vector3::Distance(snapshot.boidPositions[i], reference.boidPositions[i]);
+            const float velocityDeviation = Vector3::Distance(snapshot.boidVelocities[i], reference.boidVelocities[i]);
+            report.maxPositionDeviation = std::max(report.maxPositionDeviation, positionDeviation);
+            report.maxVelocityDeviation = std::max(report.maxVelocityDeviation, velocityDeviation);
+            isDivergent = positionDeviation > tolerance || velocityDeviation > tolerance;
+        }
+
+        if (isDivergent && report.firstDivergentFrame < 0)
+        {
+            report.firstDivergentFrame = frame;
+        }
+    });
+
+    referenceInput.close();
+    std::remove(referencePath.c_str());
+
+    boidManager.SetSimulationBackend(previousType);
+    return report;
+}
+
+std::vector<double> ScenarioRunner::RunFrames(const Scenario& scenario, const FrameCallback& onFrameSimulated)
+{
+    MathHelper::GetRandomEngine().seed(scenario.seed);
+
+    if (scenario.generateCity)
+    {
+        m_game.GetCity().Generate(scenario.city);
+    }
+
+    if (scenario.hasIntegration)
+    {
+        m_game.GetBoidManager().SetIntegration(scenario.integration);
+    }
+
+    if (scenario.hasFlocksCount)
+    {
+        m_game.GetBoidManager().SetFlocksCount(scenario.flocksCount);
+    }
+
+    m_game.GetBoidManager().ClearBoids();
+    m_game.GetProjectileController().ClearProjectiles();
+
+    const DirectX::Keyboard::State keyboardState = {};
+    const DirectX::Mouse::State mouseState = {};
+    const DirectX::GamePad::State padState = {};
+
+    std::vector<double> frameTimes;
+    frameTimes.reserve(scenario.framesCount);
+    size_t nextEvent = 0;
+
+    for (int frame = 0; frame < scenario.framesCount; frame++)
+    {
+        const float time = static_cast<float>(frame) * scenario.timeStep;
+
+        // Camera first, projectiles spawned by this frame's events leave from its new pose
+        UpdateCamera(scenario, time);
+
+        while (nextEvent < scenario.events.size() && scenario.events[nextEvent].time <= time)
+        {
+            ApplyEvent(scenario.events[nextEvent++]);
+        }
+
+        const auto frameStart = std::chrono::steady_clock::now();
+        m_game.UpdateSimulation(scenario.timeStep, keyboardState, mouseState, padState);
+        frameTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count());
+
+        if (onFrameSimulated)
+        {
+            onFrameSimulated(frame);
+        }
+    }
+
+    return frameTimes;
+}
+
+void ScenarioRunner::ApplyEvent(const ScenarioEvent& scenarioEvent)
+{
+    switch (scenarioEvent.type)
+    {
+    case ScenarioEventType::SpawnBoids:
+        m_game.GetBoidManager().SpawnBoids(scenarioEvent.count);
+        break;
+    case ScenarioEventType::RemoveBoids:
+        m_game.GetBoidManager().RemoveBoids(scenarioEvent.count);
+        break;
+    case ScenarioEventType::PredatorProjectiles:
+    case ScenarioEventType::AttractorProjectiles:
+        for (int i = 0; i < scenarioEvent.count; i++)
+        {
+            m_game.GetProjectileController().SpawnProjectile(scenarioEvent.type == ScenarioEventType::PredatorProjectiles);
+        }
+        break;
+    }
+}
+
+void ScenarioRunner::UpdateCamera(const Scenario& scenario, float time)
+{
+    const std::vector<ScenarioCameraKey>& keys = scenario.cameraKeys;
+    if (keys.empty())
+    {
+        return;
+    }
+
+    const auto next = std::upper_bound(keys.begin(), keys.end(), time, [](float keyTime, const ScenarioCameraKey& key) { return keyTime < key.time; });
+
+    if (next == keys.begin() || next == keys.end())
+    {
+        const ScenarioCameraKey& key = next == keys.begin() ? keys.front() : keys.back();
+        m_game.GetSimulationCamera().SetPose(key.position, key.direction);
+        return;
+    }
+
+    const ScenarioCameraKey& previous = *(next - 1);
+    const float alpha = (time - previous.time) / std::max(next->time - previous.time, std::numeric_limits<float>::epsilon());
+    m_game.GetSimulationCamera().SetPose(Vector3::Lerp(previous.position, next->position, alpha), Vector3::Lerp(previous.direction, next->direction, alpha));
+}
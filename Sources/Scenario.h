@@ -0,0 +1,107 @@
+#pragma once
+#include "CityGenerator.h"
+#include "SimulationBackend.h"
+
+class Game;
+
+enum class ScenarioEventType
+{
+    SpawnBoids,
+    RemoveBoids,
+    PredatorProjectiles,
+    AttractorProjectiles
+};
+
+struct ScenarioEvent
+{
+    float time;
+    ScenarioEventType type;
+    int count;
+};
+
+struct ScenarioCameraKey
+{
+    float time;
+    Vector3 position;
+    Vector3 direction;
+};
+
+/// Scripted workload, so different builds can be compared on exactly the same simulation.
+/// Text file, one statement per line, '#' starts a comment:
+///   frames <count>                          frames to simulate, default 600
+///   time_step <seconds>                     fixed step, default 1/30
+///   seed <value>                            random seed of the simulation
+///   flocks <count>                          flocks the boids are spread over, otherwise whatever the game was started with
+///   city <count> <seed> <density>           generated city instead of the loaded one
+///   integration euler | verlet <substeps>   boid integration, otherwise whatever the game was started with
+///   camera <time> <px> <py> <pz> <dx> <dy> <dz>   camera path key, linearly interpolated
+///   at <time> spawn_boids | remove_boids | predator | attractor <count>
+/// All boids and projectiles are cleared at the start, so only the script decides the workload.
+struct Scenario
+{
+    int framesCount = 600;
+    float timeStep = 1.0f / 30.0f;
+    uint32_t seed = 1;
+    bool hasFlocksCount = false;
+    int flocksCount = 0;
+    bool generateCity = false;
+    CityGeneratorSettings city;
+    bool hasIntegration = false;
+    BoidIntegrationSettings integration;
+    std::vector<ScenarioEvent> events;          // sorted by time
+    std::vector<ScenarioCameraKey> cameraKeys;  // sorted by time
+
+    bool Load(const std::string& path, std::string& error);
+};
+
+struct ScenarioReport
+{
+    int framesCount = 0;
+    double totalMilliseconds = 0.0;
+    double p50Milliseconds = 0.0;
+    double p95Milliseconds = 0.0;
+    double p99Milliseconds = 0.0;
+    double maxMilliseconds = 0.0;
+    size_t peakMemoryBytes = 0;
+    size_t finalBoidsCount = 0;
+    size_t finalProjectilesCount = 0;
+
+    std::string ToString() const;
+};
+
+// Trajectories of a backend against the reference one, boids matched by their order
+struct ConformanceReport
+{
+    SimulationBackendType backendType = SimulationBackendType::Reference;
+    float tolerance = 0.0f;
+    int framesCount = 0;
+    int firstDivergentFrame = -1; // First frame with a deviation over the tolerance or a different boids count, -1 if none
+    float maxPositionDeviation = 0.0f;
+    float maxVelocityDeviation = 0.0f;
+
+    bool IsPassed() const { return firstDivergentFrame < 0; }
+    std::string ToString() const;
+};
+
+/// Runs a scenario synchronously through Game::UpdateSimulation without rendering, timing every simulation frame.
+class ScenarioRunner
+{
+public:
+    using FrameCallback = std::function<void(int frame)>;
+
+    explicit ScenarioRunner(Game& game);
+
+    // onFrameSimulated runs after every simulation step and isn't part of the frame times
+    ScenarioReport Run(const Scenario& scenario, const FrameCallback& onFrameSimulated = {});
+    // Runs the scenario with the reference backend and then with the given one, comparing every frame. The steering budget is lifted
+    // so every boid is steered every frame, a time based schedule would differ between the two runs. Reference frames are streamed
+    // through referencePath instead of being kept in memory, the file is removed afterwards
+    ConformanceReport RunConformance(const Scenario& scenario, SimulationBackendType backendType, float tolerance, const std::string& referencePath);
+
+private:
+    std::vector<double> RunFrames(const Scenario& scenario, const FrameCallback& onFrameSimulated);
+    void ApplyEvent(const ScenarioEvent& scenarioEvent);
+    void UpdateCamera(const Scenario& scenario, float time);
+
+    Game& m_game;
+};
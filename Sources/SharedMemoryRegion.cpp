@@ -0,0 +1,192 @@
+#include "pch.h"
+#include "SharedMemoryRegion.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+#ifdef _WIN32
+    std::string GetSystemName(const std::string& name)
+    {
+        return "Local\\" + name;
+    }
+#else
+    std::string GetSystemName(const std::string& name)
+    {
+        return "/" + name;
+    }
+#endif
+}
+
+SharedMemoryRegion::~SharedMemoryRegion()
+{
+    Close();
+}
+
+#ifdef _WIN32
+
+bool SharedMemoryRegion::Create(const std::string& name, size_t size)
+{
+    Close();
+
+    const uint64_t size64 = size;
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(size64 >> 32), static_cast<DWORD>(size64), GetSystemName(name).c_str());
+    if (!mapping)
+    {
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (!view)
+    {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    m_mappingHandle = mapping;
+    m_data = static_cast<char*>(view);
+    m_size = size;
+    m_isOwner = true;
+    m_name = name;
+    return true;
+}
+
+bool SharedMemoryRegion::Open(const std::string& name)
+{
+    Close();
+
+    HANDLE mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, GetSystemName(name).c_str());
+    if (!mapping)
+    {
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    MEMORY_BASIC_INFORMATION viewInfo;
+    if (!view || !VirtualQuery(view, &viewInfo, sizeof(viewInfo)))
+    {
+        if (view)
+        {
+            UnmapViewOfFile(view);
+        }
+
+        CloseHandle(mapping);
+        return false;
+    }
+
+    m_mappingHandle = mapping;
+    m_data = static_cast<char*>(view);
+    m_size = viewInfo.RegionSize;
+    m_name = name;
+    return true;
+}
+
+void SharedMemoryRegion::Close()
+{
+    // Named mappings go away with their last handle, nothing to remove explicitly
+    if (m_data)
+    {
+        UnmapViewOfFile(m_data);
+        CloseHandle(m_mappingHandle);
+    }
+
+    m_data = nullptr;
+    m_size = 0;
+    m_isOwner = false;
+    m_mappingHandle = nullptr;
+}
+
+#else
+
+bool SharedMemoryRegion::Create(const std::string& name, size_t size)
+{
+    Close();
+
+    const std::string systemName = GetSystemName(name);
+    shm_unlink(systemName.c_str()); // Left behind by a crashed run
+
+    const int file = shm_open(systemName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (file < 0)
+    {
+        return false;
+    }
+
+    if (ftruncate(file, static_cast<off_t>(size)) != 0)
+    {
+        close(file);
+        shm_unlink(systemName.c_str());
+        return false;
+    }
+
+    void* view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    close(file);
+
+    if (view == MAP_FAILED)
+    {
+        shm_unlink(systemName.c_str());
+        return false;
+    }
+
+    m_data = static_cast<char*>(view);
+    m_size = size;
+    m_isOwner = true;
+    m_name = name;
+    return true;
+}
+
+bool SharedMemoryRegion::Open(const std::string& name)
+{
+    Close();
+
+    const int file = shm_open(GetSystemName(name).c_str(), O_RDONLY, 0);
+    if (file < 0)
+    {
+        return false;
+    }
+
+    struct stat fileStat;
+    if (fstat(file, &fileStat) != 0 || fileStat.st_size == 0)
+    {
+        close(file);
+        return false;
+    }
+
+    void* view = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_SHARED, file, 0);
+    close(file);
+
+    if (view == MAP_FAILED)
+    {
+        return false;
+    }
+
+    m_data = static_cast<char*>(view);
+    m_size = static_cast<size_t>(fileStat.st_size);
+    m_name = name;
+    return true;
+}
+
+void SharedMemoryRegion::Close()
+{
+    if (m_data)
+    {
+        munmap(m_data, m_size);
+
+        if (m_isOwner)
+        {
+            shm_unlink(GetSystemName(m_name).c_str());
+        }
+    }
+
+    m_data = nullptr;
+    m_size = 0;
+    m_isOwner = false;
+}
+
+#endif
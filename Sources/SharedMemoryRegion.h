@@ -0,0 +1,31 @@
+#pragma once
+
+/// Named shared memory, created read / write by one process and mapped read only by any number of others.
+/// The creator removes the name on Close, processes that still have it mapped keep their view until they close it too.
+class SharedMemoryRegion
+{
+public:
+    SharedMemoryRegion() = default;
+    ~SharedMemoryRegion();
+
+    SharedMemoryRegion(const SharedMemoryRegion&) = delete;
+    SharedMemoryRegion& operator=(const SharedMemoryRegion&) = delete;
+
+    bool Create(const std::string& name, size_t size);
+    bool Open(const std::string& name);
+    void Close();
+
+    bool IsOpen() const { return m_data != nullptr; }
+    char* GetData() const { return m_data; }
+    size_t GetSize() const { return m_size; }
+
+private:
+    char* m_data = nullptr;
+    size_t m_size = 0;
+    bool m_isOwner = false;
+    std::string m_name;
+
+#ifdef _WIN32
+    void* m_mappingHandle = nullptr;
+#endif
+};
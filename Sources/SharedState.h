@@ -0,0 +1,106 @@
+#pragma once
+#include <atomic>
+
+/// Layout of the shared memory region the simulation publishes its state into after every step, for external tools to read zero copy.
+/// A header followed by SLOTS_COUNT slots, each holding one whole frame as structure of arrays. The publisher writes the slot after the latest
+/// one and then points latestSlot at it, so a slot is only overwritten two publishes after it became the latest.
+/// Every slot is a seqlock: its sequence is odd while being written and increases by 2 per publish, a reader that sees the same even sequence
+/// before and after reading got a consistent frame. The publisher never waits for readers, a reader slower than two frames just retries.
+/// The region can be mapped before its creator initialized it, so the header magic is stored last and readers wait for it.
+namespace SharedState
+{
+    constexpr uint32_t MAGIC = 'B' | ('S' << 8) | ('H' << 16) | ('M' << 24); // "BSHM" in memory on little endian
+    constexpr uint32_t VERSION = 2;
+    constexpr uint32_t SLOTS_COUNT = 3;
+    constexpr uint32_t NO_SLOT = std::numeric_limits<uint32_t>::max();
+    constexpr size_t CACHE_LINE_SIZE = 64;
+    constexpr const char* DEFAULT_NAME = "boids-state";
+
+    struct Header
+    {
+        std::atomic<uint32_t> magic; // 0 until every other field and the slots are initialized, released last
+        uint32_t version;
+        uint32_t boidsCapacity;
+        uint32_t projectilesCapacity;
+        uint64_t slotSize;
+        std::atomic<uint32_t> latestSlot; // NO_SLOT until the first publish
+    };
+
+    struct SlotHeader
+    {
+        std::atomic<uint64_t> sequence;
+        uint64_t frameIndex;
+        float simulationTime;
+        uint32_t boidsCount;
+        uint32_t projectilesCount;
+        uint32_t droppedBoidsCount; // Boids over the capacity that weren't published
+    };
+
+    static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free, "Shared memory atomics have to be lock free");
+
+    // Byte offsets inside a slot
+    struct SlotLayout
+    {
+        size_t boidPositions;
+        size_t boidVelocities;
+        size_t boidFlockIDs;
+        size_t projectilePositions;
+        size_t projectileVelocities;
+        size_t projectilePredators;
+        size_t size;
+    };
+
+    inline size_t AlignUp(size_t value, size_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    inline SlotLayout GetSlotLayout(uint32_t boidsCapacity, uint32_t projectilesCapacity)
+    {
+        SlotLayout layout;
+        size_t offset = AlignUp(sizeof(SlotHeader), CACHE_LINE_SIZE);
+        const auto place = [&offset](size_t& arrayOffset, size_t bytes)
+        {
+            arrayOffset = offset;
+            offset = AlignUp(offset + bytes, CACHE_LINE_SIZE);
+        };
+
+        place(layout.boidPositions, boidsCapacity * sizeof(Vector3));
+        place(layout.boidVelocities, boidsCapacity * sizeof(Vector3));
+        place(layout.boidFlockIDs, boidsCapacity * sizeof(uint16_t));
+        place(layout.projectilePositions, projectilesCapacity * sizeof(Vector3));
+        place(layout.projectileVelocities, projectilesCapacity * sizeof(Vector3));
+        place(layout.projectilePredators, projectilesCapacity * sizeof(uint8_t));
+        layout.size = offset;
+        return layout;
+    }
+
+    inline size_t GetSlotOffset(uint32_t slot, uint64_t slotSize)
+    {
+        return AlignUp(sizeof(Header), CACHE_LINE_SIZE) + slot * slotSize;
+    }
+
+    inline size_t GetRegionSize(uint32_t boidsCapacity, uint32_t projectilesCapacity)
+    {
+        return GetSlotOffset(SLOTS_COUNT, GetSlotLayout(boidsCapacity, projectilesCapacity).size);
+    }
+}
+
+// One frame inside a slot, arrays point straight into the shared memory (written by the publisher, read only for readers)
+struct SharedStateFrame
+{
+    uint64_t frameIndex = 0;
+    float simulationTime = 0.0f;
+    uint32_t boidsCapacity = 0;
+    uint32_t boidsCount = 0;
+    uint32_t droppedBoidsCount = 0;
+    uint32_t projectilesCapacity = 0;
+    uint32_t projectilesCount = 0;
+
+    Vector3* boidPositions = nullptr;
+    Vector3* boidVelocities = nullptr;
+    uint16_t* boidFlockIDs = nullptr;
+    Vector3* projectilePositions = nullptr;
+    Vector3* projectileVelocities = nullptr;
+    uint8_t* projectilePredators = nullptr;
+};
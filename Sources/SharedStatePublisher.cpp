@@ -0,0 +1,74 @@
+#include "pch.h"
+#include "SharedStatePublisher.h"
+
+bool SharedStatePublisher::Create(const std::string& name, uint32_t boidsCapacity, uint32_t projectilesCapacity)
+{
+    if (!m_region.Create(name, SharedState::GetRegionSize(boidsCapacity, projectilesCapacity)))
+    {
+        return false;
+    }
+
+    m_layout = SharedState::GetSlotLayout(boidsCapacity, projectilesCapacity);
+
+    // Fresh pages are zeroed, so every slot sequence starts at 0 (even, nothing written yet)
+    for (uint32_t slot = 0; slot < SharedState::SLOTS_COUNT; slot++)
+    {
+        new (&GetSlotHeader(slot)) SharedState::SlotHeader{};
+    }
+
+    SharedState::Header* header = new (m_region.GetData()) SharedState::Header{};
+    header->version = SharedState::VERSION;
+    header->boidsCapacity = boidsCapacity;
+    header->projectilesCapacity = projectilesCapacity;
+    header->slotSize = m_layout.size;
+    header->latestSlot.store(SharedState::NO_SLOT, std::memory_order_relaxed);
+
+    // Readers that mapped the region already see the header as complete only from here on
+    header->magic.store(SharedState::MAGIC, std::memory_order_release);
+
+    m_frame.boidsCapacity = boidsCapacity;
+    m_frame.projectilesCapacity = projectilesCapacity;
+    m_writeSlot = 0;
+    m_nextFrameIndex = 0;
+    return true;
+}
+
+SharedStateFrame& SharedStatePublisher::BeginFrame(float simulationTime)
+{
+    SharedState::SlotHeader& slotHeader = GetSlotHeader(m_writeSlot);
+    slotHeader.sequence.store(slotHeader.sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    char* slotData = m_region.GetData() + SharedState::GetSlotOffset(m_writeSlot, m_layout.size);
+    m_frame.frameIndex = m_nextFrameIndex++;
+    m_frame.simulationTime = simulationTime;
+    m_frame.boidsCount = 0;
+    m_frame.droppedBoidsCount = 0;
+    m_frame.projectilesCount = 0;
+    m_frame.boidPositions = reinterpret_cast<Vector3*>(slotData + m_layout.boidPositions);
+    m_frame.boidVelocities = reinterpret_cast<Vector3*>(slotData + m_layout.boidVelocities);
+    m_frame.boidFlockIDs = reinterpret_cast<uint16_t*>(slotData + m_layout.boidFlockIDs);
+    m_frame.projectilePositions = reinterpret_cast<Vector3*>(slotData + m_layout.projectilePositions);
+    m_frame.projectileVelocities = reinterpret_cast<Vector3*>(slotData + m_layout.projectileVelocities);
+    m_frame.projectilePredators = reinterpret_cast<uint8_t*>(slotData + m_layout.projectilePredators);
+    return m_frame;
+}
+
+void SharedStatePublisher::EndFrame()
+{
+    SharedState::SlotHeader& slotHeader = GetSlotHeader(m_writeSlot);
+    slotHeader.frameIndex = m_frame.frameIndex;
+    slotHeader.simulationTime = m_frame.simulationTime;
+    slotHeader.boidsCount = m_frame.boidsCount;
+    slotHeader.projectilesCount = m_frame.projectilesCount;
+    slotHeader.droppedBoidsCount = m_frame.droppedBoidsCount;
+    slotHeader.sequence.store(slotHeader.sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+
+    GetHeader().latestSlot.store(m_writeSlot, std::memory_order_release);
+    m_writeSlot = (m_writeSlot + 1) % SharedState::SLOTS_COUNT;
+}
+
+SharedState::SlotHeader& SharedStatePublisher::GetSlotHeader(uint32_t slot) const
+{
+    return *reinterpret_cast<SharedState::SlotHeader*>(m_region.GetData() + SharedState::GetSlotOffset(slot, m_layout.size));
+}
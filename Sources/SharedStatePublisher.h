@@ -0,0 +1,26 @@
+#pragma once
+#include "SharedMemoryRegion.h"
+#include "SharedState.h"
+
+/// Writer side of the SharedState region, owned by the simulation. BeginFrame hands out the next slot's arrays,
+/// fill them and the counts, then EndFrame makes it the latest frame. Never blocks on readers.
+class SharedStatePublisher
+{
+public:
+    bool Create(const std::string& name, uint32_t boidsCapacity, uint32_t projectilesCapacity);
+    void Close() { m_region.Close(); }
+    bool IsOpen() const { return m_region.IsOpen(); }
+
+    SharedStateFrame& BeginFrame(float simulationTime);
+    void EndFrame();
+
+private:
+    SharedState::Header& GetHeader() const { return *reinterpret_cast<SharedState::Header*>(m_region.GetData()); }
+    SharedState::SlotHeader& GetSlotHeader(uint32_t slot) const;
+
+    SharedMemoryRegion m_region;
+    SharedState::SlotLayout m_layout = {};
+    SharedStateFrame m_frame;
+    uint32_t m_writeSlot = 0;
+    uint64_t m_nextFrameIndex = 0;
+};
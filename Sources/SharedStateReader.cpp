@@ -0,0 +1,105 @@
+#include "pch.h"
+#include "SharedStateReader.h"
+#include <chrono>
+#include <thread>
+
+namespace
+{
+    constexpr uint32_t READY_POLL_MILLISECONDS = 10;
+}
+
+bool SharedStateReader::Open(const std::string& name, uint32_t maxWaitMilliseconds)
+{
+    if (!m_region.Open(name) || m_region.GetSize() < sizeof(SharedState::Header))
+    {
+        m_region.Close();
+        return false;
+    }
+
+    const SharedState::Header& header = GetHeader();
+
+    // Acquire pairs with the publisher storing the magic last, every field read below was written before it
+    uint32_t waitedMilliseconds = 0;
+    while (header.magic.load(std::memory_order_acquire) != SharedState::MAGIC)
+    {
+        if (waitedMilliseconds >= maxWaitMilliseconds)
+        {
+            m_region.Close();
+            return false;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(READY_POLL_MILLISECONDS));
+        waitedMilliseconds += READY_POLL_MILLISECONDS;
+    }
+
+    m_layout = SharedState::GetSlotLayout(header.boidsCapacity, header.projectilesCapacity);
+
+    const bool isValid = header.version == SharedState::VERSION
+        && header.slotSize == m_layout.size
+        && m_region.GetSize() >= SharedState::GetRegionSize(header.boidsCapacity, header.projectilesCapacity);
+
+    if (!isValid)
+    {
+        m_region.Close();
+        return false;
+    }
+
+    return true;
+}
+
+bool SharedStateReader::VisitLatestFrame(const FrameVisitor& visitor, uint32_t maxAttempts) const
+{
+    if (!IsOpen())
+    {
+        return false;
+    }
+
+    const SharedState::Header& header = GetHeader();
+
+    for (uint32_t attempt = 0; attempt < maxAttempts; attempt++)
+    {
+        const uint32_t slot = header.latestSlot.load(std::memory_order_acquire);
+        if (slot >= SharedState::SLOTS_COUNT)
+        {
+            return false;
+        }
+
+        char* slotData = m_region.GetData() + SharedState::GetSlotOffset(slot, m_layout.size);
+        const SharedState::SlotHeader& slotHeader = *reinterpret_cast<const SharedState::SlotHeader*>(slotData);
+
+        const uint64_t sequence = slotHeader.sequence.load(std::memory_order_acquire);
+        if (sequence & 1)
+        {
+            m_tornReadsCount++;
+            continue;
+        }
+
+        SharedStateFrame frame;
+        frame.frameIndex = slotHeader.frameIndex;
+        frame.simulationTime = slotHeader.simulationTime;
+        frame.boidsCapacity = header.boidsCapacity;
+        frame.boidsCount = std::min(slotHeader.boidsCount, header.boidsCapacity);
+        frame.droppedBoidsCount = slotHeader.droppedBoidsCount;
+        frame.projectilesCapacity = header.projectilesCapacity;
+        frame.projectilesCount = std::min(slotHeader.projectilesCount, header.projectilesCapacity);
+        frame.boidPositions = reinterpret_cast<Vector3*>(slotData + m_layout.boidPositions);
+        frame.boidVelocities = reinterpret_cast<Vector3*>(slotData + m_layout.boidVelocities);
+        frame.boidFlockIDs = reinterpret_cast<uint16_t*>(slotData + m_layout.boidFlockIDs);
+        frame.projectilePositions = reinterpret_cast<Vector3*>(slotData + m_layout.projectilePositions);
+        frame.projectileVelocities = reinterpret_cast<Vector3*>(slotData + m_layout.projectileVelocities);
+        frame.projectilePredators = reinterpret_cast<uint8_t*>(slotData + m_layout.projectilePredators);
+
+        visitor(frame);
+
+        // Everything the visitor read has to happen before the sequence is checked again
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slotHeader.sequence.load(std::memory_order_relaxed) == sequence)
+        {
+            return true;
+        }
+
+        m_tornReadsCount++;
+    }
+
+    return false;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "SharedMemoryRegion.h"
+#include "SharedState.h"
+
+/// Reader side of the SharedState region, for tools running next to the simulation. Visits the latest frame in place, without copying,
+/// and validates it afterwards, a frame that was overwritten while being visited is retried so the visitor has to tolerate being called again.
+class SharedStateReader
+{
+public:
+    using FrameVisitor = std::function<void(const SharedStateFrame&)>;
+
+    // Waits up to maxWaitMilliseconds for a region that exists but isn't initialized yet, false if it doesn't get there
+    bool Open(const std::string& name, uint32_t maxWaitMilliseconds = 1000);
+    void Close() { m_region.Close(); }
+    bool IsOpen() const { return m_region.IsOpen(); }
+
+    // False when nothing was published yet or every attempt got torn, otherwise the visitor saw one consistent frame last
+    bool VisitLatestFrame(const FrameVisitor& visitor, uint32_t maxAttempts = 16) const;
+
+    uint32_t GetTornReadsCount() const { return m_tornReadsCount; }
+
+private:
+    const SharedState::Header& GetHeader() const { return *reinterpret_cast<const SharedState::Header*>(m_region.GetData()); }
+
+    SharedMemoryRegion m_region;
+    SharedState::SlotLayout m_layout = {};
+    mutable uint32_t m_tornReadsCount = 0;
+};
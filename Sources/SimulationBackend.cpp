@@ -0,0 +1,261 @@
+#include "pch.h"
+#include "SimulationBackend.h"
+
+#include "BoidManager.h"
+#include "WorkerPool.h"
+
+namespace
+{
+    constexpr const char* BACKEND_NAMES[] = { "reference", "parallel", "simd" };
+    static_assert(std::size(BACKEND_NAMES) == static_cast<size_t>(SimulationBackendType::Count), "Every backend needs a name");
+
+    constexpr const char* INTEGRATION_METHOD_NAMES[] = { "euler", "verlet" };
+    static_assert(std::size(INTEGRATION_METHOD_NAMES) == static_cast<size_t>(IntegrationMethod::Count), "Every integration method needs a name");
+
+    constexpr size_t MIN_STEERING_CHUNK = 64;
+    constexpr size_t MIN_INTEGRATION_CHUNK = 1024;
+
+    void SteerBoid(const BoidSteeringController& steeringController, Boid& boid, size_t batchIndex, float accelerationMultiplier)
+    {
+        boid.SetAcceleration(steeringController.GetBoidSteering(boid, batchIndex) * accelerationMultiplier);
+        boid.steeringStaleness = 0.0f;
+    }
+
+    // Both velocities are within the speed limits, so neither method moves a boid further than the max speed allows (BoidNeighborCache relies on it)
+    void MoveBoid(Boid& boid, Vector3 previousVelocity, IntegrationMethod method, float deltaTime)
+    {
+        if (method == IntegrationMethod::VelocityVerlet)
+        {
+            boid.SetPosition(boid.GetPosition() + (previousVelocity + boid.GetVelocity()) * (0.5f * deltaTime));
+        }
+        else
+        {
+            boid.UpdatePositionBasedOnVelocity(deltaTime);
+        }
+    }
+
+    void IntegrateBoidSubstep(Boid& boid, BoidSpeedLimits speedLimits, IntegrationMethod method, float deltaTime)
+    {
+        const Vector3 previousVelocity = boid.GetVelocity();
+        const Vector3 newVelocity = previousVelocity + boid.GetAcceleration() * deltaTime;
+        boid.SetVelocity(newVelocity);
+
+        const float currentSpeedSquared = boid.GetVelocity().LengthSquared();
+
+        if (currentSpeedSquared > speedLimits.max * speedLimits.max)
+        {
+            Vector3 direction;
+            boid.GetVelocity().Normalize(direction);
+            boid.SetVelocity(direction * speedLimits.max);
+        }
+        else if (currentSpeedSquared < speedLimits.min * speedLimits.min)
+        {
+            Vector3 direction;
+            boid.GetVelocity().Normalize(direction);
+            boid.SetVelocity(direction * speedLimits.min);
+        }
+
+        MoveBoid(boid, previousVelocity, method, deltaTime);
+    }
+
+    void IntegrateBoid(Boid& boid, BoidSpeedLimits speedLimits, BoidIntegrationSettings integration, float deltaTime)
+    {
+        boid.steeringStaleness += deltaTime;
+
+        const float substepTime = deltaTime / static_cast<float>(integration.substepsCount);
+        for (int substep = 0; substep < integration.substepsCount; substep++)
+        {
+            IntegrateBoidSubstep(boid, speedLimits, integration.method, substepTime);
+        }
+    }
+
+    class ReferenceSimulationBackend final : public SimulationBackend
+    {
+    public:
+        SimulationBackendType GetType() const override { return SimulationBackendType::Reference; }
+
+        void ComputeSteering(const BoidSteeringController& steeringController, const std::vector<Boid*>& boids, float accelerationMultiplier) override
+        {
+            for (size_t i = 0; i < boids.size(); i++)
+            {
+                SteerBoid(steeringController, *boids[i], i, accelerationMultiplier);
+            }
+        }
+
+        void Integrate(const std::vector<Boid*>& boids, BoidSpeedLimits speedLimits, BoidIntegrationSettings integration, float deltaTime) override
+        {
+            for (Boid* boid : boids)
+            {
+                IntegrateBoid(*boid, speedLimits, integration, deltaTime);
+            }
+        }
+    };
+
+    // Every boid only reads the others and writes itself, so the reference per boid code runs unchanged on any thread
+    class ParallelSimulationBackend final : public SimulationBackend
+    {
+    public:
+        SimulationBackendType GetType() const override { return SimulationBackendType::Parallel; }
+
+        void ComputeSteering(const BoidSteeringController& steeringController, const std::vector<Boid*>& boids, float accelerationMultiplier) override
+        {
+            m_workerPool.ParallelFor(boids.size(), MIN_STEERING_CHUNK, [&](size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; i++)
+                {
+                    SteerBoid(steeringController, *boids[i], i, accelerationMultiplier);
+                }
+            });
+        }
+
+        void Integrate(const std::vector<Boid*>& boids, BoidSpeedLimits speedLimits, BoidIntegrationSettings integration, float deltaTime) override
+        {
+            m_workerPool.ParallelFor(boids.size(), MIN_INTEGRATION_CHUNK, [&](size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; i++)
+                {
+                    IntegrateBoid(*boids[i], speedLimits, integration, deltaTime);
+                }
+            });
+        }
+
+    private:
+        WorkerPool m_workerPool;
+    };
+
+    // Velocities are gathered into structure of arrays and clamped in branch free loops the compiler vectorizes,
+    // with the same operations as the reference (normalize by dividing by the length, then scale) so the results match it
+    class SimdSimulationBackend final : public SimulationBackend
+    {
+    public:
+        SimulationBackendType GetType() const override { return SimulationBackendType::Simd; }
+
+        void ComputeSteering(const BoidSteeringController& steeringController, const std::vector<Boid*>& boids, float accelerationMultiplier) override
+        {
+            for (size_t i = 0; i < boids.size(); i++)
+            {
+                SteerBoid(steeringController, *boids[i], i, accelerationMultiplier);
+            }
+        }
+
+        void Integrate(const std::vector<Boid*>& boids, BoidSpeedLimits speedLimits, BoidIntegrationSettings integration, float deltaTime) override
+        {
+            for (Boid* boid : boids)
+            {
+                boid->steeringStaleness += deltaTime;
+            }
+
+            // Substeps of all boids one after the other instead of all substeps of one boid, each boid still goes through the same operations
+            const float substepTime = deltaTime / static_cast<float>(integration.substepsCount);
+            for (int substep = 0; substep < integration.substepsCount; substep++)
+            {
+                IntegrateSubstep(boids, speedLimits, integration.method, substepTime);
+            }
+        }
+
+    private:
+        void IntegrateSubstep(const std::vector<Boid*>& boids, BoidSpeedLimits speedLimits, IntegrationMethod method, float deltaTime)
+        {
+            const size_t count = boids.size();
+            m_velocityX.resize(count);
+            m_velocityY.resize(count);
+            m_velocityZ.resize(count);
+            m_previousVelocities.resize(count);
+
+            for (size_t i = 0; i < count; i++)
+            {
+                Boid& boid = *boids[i];
+                m_previousVelocities[i] = boid.GetVelocity();
+
+                // Stored and read back like the reference does, so compact boid state rounds at the same points
+                boid.SetVelocity(m_previousVelocities[i] + boid.GetAcceleration() * deltaTime);
+                const Vector3 velocity = boid.GetVelocity();
+                m_velocityX[i] = velocity.x;
+                m_velocityY[i] = velocity.y;
+                m_velocityZ[i] = velocity.z;
+            }
+
+            const float minSpeedSquared = speedLimits.min * speedLimits.min;
+            const float maxSpeedSquared = speedLimits.max * speedLimits.max;
+            float* velocityX = m_velocityX.data();
+            float* velocityY = m_velocityY.data();
+            float* velocityZ = m_velocityZ.data();
+
+            for (size_t i = 0; i < count; i++)
+            {
+                const float speedSquared = velocityX[i] * velocityX[i] + velocityY[i] * velocityY[i] + velocityZ[i] * velocityZ[i];
+                const float length = std::sqrt(speedSquared);
+                const bool isTooFast = speedSquared > maxSpeedSquared;
+                const bool isClamped = isTooFast || speedSquared < minSpeedSquared;
+                const float targetSpeed = isTooFast ? speedLimits.max : speedLimits.min;
+
+                velocityX[i] = isClamped ? velocityX[i] / length * targetSpeed : velocityX[i];
+                velocityY[i] = isClamped ? velocityY[i] / length * targetSpeed : velocityY[i];
+                velocityZ[i] = isClamped ? velocityZ[i] / length * targetSpeed : velocityZ[i];
+            }
+
+            for (size_t i = 0; i < count; i++)
+            {
+                Boid& boid = *boids[i];
+                boid.SetVelocity(Vector3(velocityX[i], velocityY[i], velocityZ[i]));
+                MoveBoid(boid, m_previousVelocities[i], method, deltaTime);
+            }
+        }
+
+        std::vector<Vector3> m_previousVelocities;
+        std::vector<float> m_velocityX;
+        std::vector<float> m_velocityY;
+        std::vector<float> m_velocityZ;
+    };
+}
+
+const char* GetSimulationBackendName(SimulationBackendType type)
+{
+    return BACKEND_NAMES[static_cast<size_t>(type)];
+}
+
+bool ParseSimulationBackendType(const std::string& name, SimulationBackendType& type)
+{
+    for (size_t i = 0; i < std::size(BACKEND_NAMES); i++)
+    {
+        if (name == BACKEND_NAMES[i])
+        {
+            type = static_cast<SimulationBackendType>(i);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const char* GetIntegrationMethodName(IntegrationMethod method)
+{
+    return INTEGRATION_METHOD_NAMES[static_cast<size_t>(method)];
+}
+
+bool ParseIntegrationMethod(const std::string& name, IntegrationMethod& method)
+{
+    for (size_t i = 0; i < std::size(INTEGRATION_METHOD_NAMES); i++)
+    {
+        if (name == INTEGRATION_METHOD_NAMES[i])
+        {
+            method = static_cast<IntegrationMethod>(i);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+std::unique_ptr<SimulationBackend> SimulationBackend::Create(SimulationBackendType type)
+{
+    switch (type)
+    {
+    case SimulationBackendType::Parallel:
+        return std::make_unique<ParallelSimulationBackend>();
+    case SimulationBackendType::Simd:
+        return std::make_unique<SimdSimulationBackend>();
+    default:
+        return std::make_unique<ReferenceSimulationBackend>();
+    }
+}
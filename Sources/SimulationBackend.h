@@ -0,0 +1,56 @@
+#pragma once
+
+class Boid;
+class BoidSteeringController;
+
+enum class SimulationBackendType
+{
+    Reference,  // Scalar, one boid after the other, what every other backend is validated against
+    Parallel,   // Steering and integration split across a worker pool
+    Simd,       // Speed clamping on structure of arrays velocities, vectorized
+    Count
+};
+
+const char* GetSimulationBackendName(SimulationBackendType type);
+bool ParseSimulationBackendType(const std::string& name, SimulationBackendType& type);
+
+enum class IntegrationMethod
+{
+    SemiImplicitEuler,  // Velocity first, then position with the new velocity
+    VelocityVerlet,     // Position with the average of the old and new velocity, exact for the constant acceleration held between steerings
+    Count
+};
+
+const char* GetIntegrationMethodName(IntegrationMethod method);
+bool ParseIntegrationMethod(const std::string& name, IntegrationMethod& method);
+
+struct BoidSpeedLimits
+{
+    float min;
+    float max;
+};
+
+// Steering is evaluated once per step and held for every substep, so a longer step with more substeps trades steering rate for cost
+// while positions still advance in short, speed clamped increments
+struct BoidIntegrationSettings
+{
+    IntegrationMethod method = IntegrationMethod::SemiImplicitEuler;
+    int substepsCount = 1;
+};
+
+/// Per boid work of a simulation step: steering of the scheduled boids and integration of all of them.
+/// BoidManager keeps the hash grid, scheduling, spawning and removal, so every backend gets exactly the same inputs
+/// and has to produce the same trajectories as the reference one (see ScenarioRunner::RunConformance).
+class SimulationBackend
+{
+public:
+    virtual ~SimulationBackend() = default;
+
+    static std::unique_ptr<SimulationBackend> Create(SimulationBackendType type);
+
+    virtual SimulationBackendType GetType() const = 0;
+
+    // BoidSteeringController::PrepareSteeringBatch has already run for these boids
+    virtual void ComputeSteering(const BoidSteeringController& steeringController, const std::vector<Boid*>& boids, float accelerationMultiplier) = 0;
+    virtual void Integrate(const std::vector<Boid*>& boids, BoidSpeedLimits speedLimits, BoidIntegrationSettings integration, float deltaTime) = 0;
+};
@@ -0,0 +1,124 @@
+#include "pch.h"
+#include "SimulationParameters.h"
+#include <sstream>
+
+namespace
+{
+    struct ParameterDescriptor
+    {
+        const char* name;
+        float SimulationParameters::* value;
+        float minValue; // Inclusive, everything here has to stay positive except the multipliers that may be switched off
+    };
+
+    constexpr float POSITIVE = std::numeric_limits<float>::min();
+
+    constexpr ParameterDescriptor PARAMETERS[] =
+    {
+        { "boid_min_speed", &SimulationParameters::boidMinSpeed, POSITIVE },
+        { "boid_max_speed", &SimulationParameters::boidMaxSpeed, POSITIVE },
+        { "boid_acceleration_multiplier", &SimulationParameters::boidAccelerationMultiplier, 0.0f },
+        { "hash_grid_cell_size", &SimulationParameters::hashGridCellSize, POSITIVE },
+        { "neighbors_detection_radius", &SimulationParameters::neighborsDetectionRadius, POSITIVE },
+        { "bounds_multiplier", &SimulationParameters::boundsMultiplier, 0.0f },
+        { "camera_multiplier", &SimulationParameters::cameraMultiplier, 0.0f },
+        { "projectile_multiplier", &SimulationParameters::projectileMultiplier, 0.0f },
+        { "skyscrapers_multiplier", &SimulationParameters::skyscrapersMultiplier, 0.0f },
+        { "cohesion_multiplier", &SimulationParameters::cohesionMultiplier, 0.0f },
+        { "alignment_multiplier", &SimulationParameters::alignmentMultiplier, 0.0f },
+        { "separation_multiplier", &SimulationParameters::separationMultiplier, 0.0f },
+        { "predator_pursue_radius", &SimulationParameters::predatorPursueRadius, POSITIVE },
+        { "projectile_speed", &SimulationParameters::projectileSpeed, 0.0f },
+        { "projectile_drag", &SimulationParameters::projectileDrag, 0.0f },
+        { "projectile_energy", &SimulationParameters::projectileEnergy, POSITIVE },
+    };
+
+    const ParameterDescriptor* FindParameter(const std::string& name)
+    {
+        for (const ParameterDescriptor& parameter : PARAMETERS)
+        {
+            if (name == parameter.name)
+            {
+                return &parameter;
+            }
+        }
+
+        return nullptr;
+    }
+}
+
+bool SimulationParameters::Load(const std::string& path, std::string& error)
+{
+    std::ifstream stream(path);
+    if (!stream)
+    {
+        error = "can't open " + path;
+        return false;
+    }
+
+    SimulationParameters loaded = DEFAULT_SIMULATION_PARAMETERS;
+
+    std::string line;
+    for (int lineNumber = 1; std::getline(stream, line); lineNumber++)
+    {
+        line = line.substr(0, line.find('#'));
+        std::istringstream lineStream(line);
+        std::string name;
+
+        if (!(lineStream >> name))
+        {
+            continue;
+        }
+
+        const ParameterDescriptor* parameter = FindParameter(name);
+        float value = 0.0f;
+        std::string trailing;
+        const bool isValid = parameter && static_cast<bool>(lineStream >> value) && !(lineStream >> trailing) && std::isfinite(value) && value >= parameter->minValue;
+
+        if (!isValid)
+        {
+            error = path + ":" + std::to_string(lineNumber) + ": invalid parameter '" + line + "'";
+            return false;
+        }
+
+        loaded.*(parameter->value) = value;
+    }
+
+    if (!loaded.Validate(error))
+    {
+        error = path + ": " + error;
+        return false;
+    }
+
+    *this = loaded;
+    return true;
+}
+
+bool SimulationParameters::Validate(std::string& error) const
+{
+    for (const ParameterDescriptor& parameter : PARAMETERS)
+    {
+        const float value = this->*(parameter.value);
+        if (!std::isfinite(value) || value < parameter.minValue)
+        {
+            error = std::string(parameter.name) + " is out of range";
+            return false;
+        }
+    }
+
+    if (boidMinSpeed > boidMaxSpeed)
+    {
+        error = "boid_min_speed is above boid_max_speed";
+        return false;
+    }
+
+    if (hashGridCellSize < neighborsDetectionRadius * MIN_HASH_GRID_CELL_SIZE_TO_RADIUS)
+    {
+        std::ostringstream message;
+        message << "hash_grid_cell_size has to be at least " << MIN_HASH_GRID_CELL_SIZE_TO_RADIUS << " x neighbors_detection_radius";
+        error = message.str();
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+/// Tuning values that can change while the game runs (see ParameterStore), the defaults are the built in values.
+/// Text file, one "<name> <value>" per line, '#' starts a comment, names that aren't listed keep their defaults:
+///   boid_min_speed, boid_max_speed, boid_acceleration_multiplier, hash_grid_cell_size, neighbors_detection_radius,
+///   bounds_multiplier, camera_multiplier, projectile_multiplier, skyscrapers_multiplier, cohesion_multiplier,
+///   alignment_multiplier, separation_multiplier, predator_pursue_radius, projectile_speed, projectile_drag, projectile_energy
+struct SimulationParameters
+{
+    // Smaller hash grid cells make every neighbor query visit more than the 5 x 5 x 5 cells around the boid
+    static constexpr float MIN_HASH_GRID_CELL_SIZE_TO_RADIUS = 0.5f;
+
+    float boidMinSpeed = 6.5f;
+    float boidMaxSpeed = 10.5f;
+    float boidAccelerationMultiplier = 50.0f;
+    float hashGridCellSize = 6.0f;
+    float neighborsDetectionRadius = 3.0f;
+
+    float boundsMultiplier = 3.0f;
+    float cameraMultiplier = 2.0f;
+    float projectileMultiplier = 2.2f;
+    float skyscrapersMultiplier = 4.0f;
+    float cohesionMultiplier = 1.75f;
+    float alignmentMultiplier = 1.0f;
+    float separationMultiplier = 1.2f;
+
+    float predatorPursueRadius = 10.0f;
+    float projectileSpeed = 65.0f;
+    float projectileDrag = 2.0f;
+    float projectileEnergy = 5.0f;
+
+    // Either fully loaded or left unchanged
+    bool Load(const std::string& path, std::string& error);
+    // Ranges and relations between values, for parameters that don't come from a file (saved states)
+    bool Validate(std::string& error) const;
+};
+
+inline constexpr SimulationParameters DEFAULT_SIMULATION_PARAMETERS = {};
@@ -0,0 +1,242 @@
+#include "pch.h"
+#include "SimulationRunner.h"
+
+#include "FrameworkInstancedRenderContext.h"
+#include "Game.h"
+
+SimulationRunner::SimulationRunner(Game& game, float fixedTimeStep)
+    : m_game(game)
+    , m_fixedTimeStep(fixedTimeStep)
+    , m_accumulator(0.0f)
+    , m_simulationTime(0.0f)
+    , m_stepRequested(false)
+    , m_stepRunning(false)
+    , m_stopRequested(false)
+    , m_keyboardState()
+    , m_mouseState()
+    , m_gamepadState()
+    , m_latchedKeyboardState()
+    , m_latchedMouseState()
+    , m_latchedGamepadState()
+    , m_isInputLatched(false)
+    , m_previousSnapshot(std::make_unique<SimulationSnapshot>())
+    , m_currentSnapshot(std::make_unique<SimulationSnapshot>())
+    , m_writeSnapshot(std::make_unique<SimulationSnapshot>())
+    , m_writeSnapshotReady(false)
+{
+}
+
+SimulationRunner::~SimulationRunner()
+{
+    Stop();
+}
+
+void SimulationRunner::Start()
+{
+    assert(!m_worker.joinable());
+
+    // Both snapshots start as the initial state, so there is something to render before the first step is published
+    m_game.GetBoidManager().WriteSnapshot(*m_currentSnapshot);
+    m_game.GetProjectileController().WriteSnapshot(*m_currentSnapshot);
+    *m_previousSnapshot = *m_currentSnapshot;
+
+    m_stopRequested = false;
+    m_worker = std::thread(&SimulationRunner::WorkerLoop, this);
+}
+
+void SimulationRunner::Stop()
+{
+    if (!m_worker.joinable())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopRequested = true;
+    }
+
+    m_condition.notify_one();
+    m_worker.join();
+}
+
+void SimulationRunner::OnUpdate(float deltaTime, DirectX::Keyboard& keyboard, DirectX::Mouse& mouse, DirectX::GamePad& gamepad)
+{
+    m_accumulator += deltaTime;
+    LatchInput(keyboard, mouse, gamepad);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (m_stepRunning || m_stepRequested)
+        {
+            // Simulation is behind, don't build up a debt of steps it will never catch up with
+            m_accumulator = std::min(m_accumulator, m_fixedTimeStep);
+            return;
+        }
+
+        if (m_accumulator < m_fixedTimeStep)
+        {
+            return;
+        }
+
+        if (m_writeSnapshotReady)
+        {
+            // previous <- current <- freshly written, the oldest one becomes the next write target
+            std::swap(m_previousSnapshot, m_currentSnapshot);
+            std::swap(m_currentSnapshot, m_writeSnapshot);
+            m_writeSnapshotReady = false;
+        }
+
+        m_keyboardState = m_latchedKeyboardState;
+        m_mouseState = m_latchedMouseState;
+        m_gamepadState = m_latchedGamepadState;
+        m_isInputLatched = false;
+        m_game.SyncSimulationCamera();
+
+        m_accumulator -= m_fixedTimeStep;
+        m_stepRequested = true;
+    }
+
+    m_condition.notify_one();
+}
+
+void SimulationRunner::LatchInput(DirectX::Keyboard& keyboard, DirectX::Mouse& mouse, DirectX::GamePad& gamepad)
+{
+    const DirectX::Keyboard::State keyboardState = keyboard.GetState();
+    const DirectX::Mouse::State mouseState = mouse.GetState();
+    const DirectX::GamePad::State gamepadState = gamepad.GetState(0);
+
+    if (!m_isInputLatched)
+    {
+        m_latchedKeyboardState = keyboardState;
+        m_latchedMouseState = mouseState;
+        m_latchedGamepadState = gamepadState;
+        m_isInputLatched = true;
+        return;
+    }
+
+    // Anything pressed in any frame since the last step counts as pressed for the next one, the simulation only reacts to
+    // releases so a tap then shows up as pressed for one step and released in the following one.
+    // Keyboard state is a plain bit set, merged word by word like DirectX::Keyboard::KeyboardStateTracker reads it
+    uint32_t* latchedKeys = reinterpret_cast<uint32_t*>(&m_latchedKeyboardState);
+    const uint32_t* keys = reinterpret_cast<const uint32_t*>(&keyboardState);
+    for (size_t i = 0; i < sizeof(DirectX::Keyboard::State) / sizeof(uint32_t); i++)
+    {
+        latchedKeys[i] |= keys[i];
+    }
+
+    // Cursor, wheel and sticks stay the latest values, only buttons and triggers are merged
+    const DirectX::Mouse::State previousMouseState = m_latchedMouseState;
+    m_latchedMouseState = mouseState;
+    m_latchedMouseState.leftButton = mouseState.leftButton || previousMouseState.leftButton;
+    m_latchedMouseState.middleButton = mouseState.middleButton || previousMouseState.middleButton;
+    m_latchedMouseState.rightButton = mouseState.rightButton || previousMouseState.rightButton;
+
+    const DirectX::GamePad::State previousGamepadState = m_latchedGamepadState;
+    m_latchedGamepadState = gamepadState;
+    m_latchedGamepadState.triggers.left = std::max(gamepadState.triggers.left, previousGamepadState.triggers.left);
+    m_latchedGamepadState.triggers.right = std::max(gamepadState.triggers.right, previousGamepadState.triggers.right);
+}
+
+void SimulationRunner::WorkerLoop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (true)
+    {
+        m_condition.wait(lock, [this] { return m_stepRequested || m_stopRequested; });
+
+        if (m_stopRequested)
+        {
+            return;
+        }
+
+        m_stepRequested = false;
+        m_stepRunning = true;
+        lock.unlock();
+
+        Step();
+
+        lock.lock();
+        m_stepRunning = false;
+        m_writeSnapshotReady = true;
+    }
+}
+
+void SimulationRunner::Step()
+{
+    m_simulationTime += m_fixedTimeStep;
+
+    m_game.UpdateSimulation(m_fixedTimeStep, m_keyboardState, m_mouseState, m_gamepadState);
+
+    m_writeSnapshot->Clear();
+    m_writeSnapshot->simulationTime = m_simulationTime;
+    m_game.GetBoidManager().WriteSnapshot(*m_writeSnapshot);
+    m_game.GetProjectileController().WriteSnapshot(*m_writeSnapshot);
+}
+
+void SimulationRunner::OnRender(framework::RenderContextPtr& renderContext)
+{
+    const float alpha = std::clamp(m_accumulator / m_fixedTimeStep, 0.0f, 1.0f);
+    InterpolateBoids(alpha);
+    InterpolateProjectiles(alpha);
+
+    // Only shapes, colors and bounds are read from the managers here, they never change after initialization
+    FrameworkInstancedRenderContext instancedRenderContext(renderContext);
+    m_game.GetBoidManager().RenderInstances(instancedRenderContext, m_boidInstances);
+    m_game.GetBoidManager().RenderOverlay(renderContext, m_currentSnapshot->hudLines);
+    m_game.GetProjectileController().RenderInstances(instancedRenderContext, m_projectileInstances, m_currentSnapshot->projectileColors);
+}
+
+void SimulationRunner::InterpolateBoids(float alpha)
+{
+    const SimulationSnapshot& previous = *m_previousSnapshot;
+    const SimulationSnapshot& current = *m_currentSnapshot;
+
+    m_boidInstances.Begin(m_game.GetBoidManager().GetFlocksCount());
+
+    for (uint16_t flockID : current.boidFlockIDs)
+    {
+        m_boidInstances.CountInstance(flockID);
+    }
+
+    m_boidInstances.Allocate();
+
+    size_t previousIndex = 0;
+    for (size_t i = 0; i < current.boidIDs.size(); i++)
+    {
+        while (previousIndex < previous.boidIDs.size() && previous.boidIDs[previousIndex] < current.boidIDs[i])
+        {
+            ++previousIndex;
+        }
+
+        // Boids spawned during the last step have nothing to interpolate from
+        const bool existedBefore = previousIndex < previous.boidIDs.size() && previous.boidIDs[previousIndex] == current.boidIDs[i];
+        const Vector3 position = existedBefore ? Vector3::Lerp(previous.boidPositions[previousIndex], current.boidPositions[i], alpha) : current.boidPositions[i];
+        m_boidInstances.AddInstance(current.boidFlockIDs[i], position, current.boidFlockIDs[i]);
+    }
+}
+
+void SimulationRunner::InterpolateProjectiles(float alpha)
+{
+    const SimulationSnapshot& previous = *m_previousSnapshot;
+    const SimulationSnapshot& current = *m_currentSnapshot;
+
+    m_projectileInstances.Begin(1);
+    m_projectileInstances.CountInstances(0, current.projectileIDs.size());
+    m_projectileInstances.Allocate();
+
+    size_t previousIndex = 0;
+    for (size_t i = 0; i < current.projectileIDs.size(); i++)
+    {
+        while (previousIndex < previous.projectileIDs.size() && previous.projectileIDs[previousIndex] < current.projectileIDs[i])
+        {
+            ++previousIndex;
+        }
+
+        const bool existedBefore = previousIndex < previous.projectileIDs.size() && previous.projectileIDs[previousIndex] == current.projectileIDs[i];
+        const Vector3 position = existedBefore ? Vector3::Lerp(previous.projectilePositions[previousIndex], current.projectilePositions[i], alpha) : current.projectilePositions[i];
+        m_projectileInstances.AddInstance(0, position, static_cast<uint32_t>(i));
+    }
+}
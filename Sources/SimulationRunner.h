@@ -0,0 +1,64 @@
+#pragma once
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "IRenderContext.h"
+#include "RenderInstanceBuffer.h"
+#include "SimulationSnapshot.h"
+
+class Game;
+
+/// Runs boids and projectiles at a fixed rate on a worker thread and renders by interpolating the last two published snapshots,
+/// so a heavy simulation step no longer drops the render frame rate.
+/// While a step is running the main thread never touches BoidManager / ProjectileController, it only reads snapshots.
+class SimulationRunner
+{
+public:
+    SimulationRunner(Game& game, float fixedTimeStep);
+    ~SimulationRunner();
+
+    void Start();
+    void Stop();
+
+    void OnUpdate(float deltaTime, DirectX::Keyboard& keyboard, DirectX::Mouse& mouse, DirectX::GamePad& gamepad);
+    void OnRender(framework::RenderContextPtr& renderContext);
+
+private:
+    void LatchInput(DirectX::Keyboard& keyboard, DirectX::Mouse& mouse, DirectX::GamePad& gamepad);
+    void WorkerLoop();
+    void Step();
+    void InterpolateBoids(float alpha);
+    void InterpolateProjectiles(float alpha);
+
+    Game& m_game;
+    float m_fixedTimeStep;
+    float m_accumulator;
+    float m_simulationTime;
+
+    std::thread m_worker;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stepRequested;
+    bool m_stepRunning;
+    bool m_stopRequested;
+
+    // Input is captured on the main thread when a step is requested, the worker only sees these copies
+    DirectX::Keyboard::State m_keyboardState;
+    DirectX::Mouse::State m_mouseState;
+    DirectX::GamePad::State m_gamepadState;
+
+    // Sampled every render frame and merged until the next step takes it, so a press shorter than a step isn't lost
+    DirectX::Keyboard::State m_latchedKeyboardState;
+    DirectX::Mouse::State m_latchedMouseState;
+    DirectX::GamePad::State m_latchedGamepadState;
+    bool m_isInputLatched;
+
+    // Triple buffer, the worker writes into m_writeSnapshot while the renderer reads the other two
+    std::unique_ptr<SimulationSnapshot> m_previousSnapshot;
+    std::unique_ptr<SimulationSnapshot> m_currentSnapshot;
+    std::unique_ptr<SimulationSnapshot> m_writeSnapshot;
+    bool m_writeSnapshotReady;
+
+    RenderInstanceBuffer m_boidInstances;
+    RenderInstanceBuffer m_projectileInstances;
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+/// Immutable copy of everything the renderer needs from one simulation step.
+/// Boids and projectiles are stored sorted by id, so two snapshots can be matched with a single merge walk.
+struct SimulationSnapshot
+{
+    float simulationTime = 0.0f;
+
+    std::vector<uint32_t> boidIDs;
+    std::vector<Vector3> boidPositions;
+    std::vector<Vector3> boidVelocities;
+    std::vector<uint16_t> boidFlockIDs;
+
+    std::vector<uint32_t> projectileIDs;
+    std::vector<Vector3> projectilePositions;
+    std::vector<XMVECTOR> projectileColors;
+
+    std::vector<std::string> hudLines;
+
+    void Clear()
+    {
+        boidIDs.clear();
+        boidPositions.clear();
+        boidVelocities.clear();
+        boidFlockIDs.clear();
+        projectileIDs.clear();
+        projectilePositions.clear();
+        projectileColors.clear();
+        hudLines.clear();
+    }
+};
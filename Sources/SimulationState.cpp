@@ -0,0 +1,134 @@
+#include "pch.h"
+#include "SimulationState.h"
+
+#include <filesystem>
+#include "Game.h"
+
+namespace
+{
+    constexpr size_t SECTION_ALIGNMENT = 16;
+
+    size_t AlignUp(size_t value)
+    {
+        return (value + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1);
+    }
+}
+
+SimulationStateWriter::SimulationStateWriter()
+{
+    m_buffer.resize(AlignUp(sizeof(SimulationStateHeader)), 0);
+
+    SimulationStateHeader& header = *reinterpret_cast<SimulationStateHeader*>(m_buffer.data());
+    header.magic = SimulationStateHeader::MAGIC;
+    header.version = SimulationStateHeader::VERSION;
+    header.sectionsCount = static_cast<uint32_t>(SimulationStateSection::Count);
+}
+
+char* SimulationStateWriter::AllocateBytes(SimulationStateSection section, size_t size)
+{
+    const size_t offset = m_buffer.size();
+    m_buffer.resize(AlignUp(offset + size), 0);
+
+    SimulationStateHeader& header = *reinterpret_cast<SimulationStateHeader*>(m_buffer.data());
+    header.sections[static_cast<size_t>(section)] = { offset, size };
+    return m_buffer.data() + offset;
+}
+
+bool SimulationStateWriter::SaveToFile(const std::string& path) const
+{
+    const std::filesystem::path filePath(path);
+    if (filePath.has_parent_path())
+    {
+        std::error_code error;
+        std::filesystem::create_directories(filePath.parent_path(), error);
+    }
+
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    stream.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+    return stream.good();
+}
+
+bool SimulationStateReader::Open(const std::string& path)
+{
+    m_header = nullptr;
+
+    if (!m_file.Open(path) || m_file.GetSize() < sizeof(SimulationStateHeader))
+    {
+        return false;
+    }
+
+    const SimulationStateHeader* header = reinterpret_cast<const SimulationStateHeader*>(m_file.GetData());
+    if (header->magic != SimulationStateHeader::MAGIC || header->version != SimulationStateHeader::VERSION
+        || header->sectionsCount != static_cast<uint32_t>(SimulationStateSection::Count))
+    {
+        return false;
+    }
+
+    for (const SimulationStateHeader::Section& section : header->sections)
+    {
+        if (section.offset > m_file.GetSize() || section.size > m_file.GetSize() - section.offset)
+        {
+            return false;
+        }
+    }
+
+    m_header = header;
+    return true;
+}
+
+size_t SimulationStateReader::GetSectionSize(SimulationStateSection section) const
+{
+    return m_header ? static_cast<size_t>(m_header->sections[static_cast<size_t>(section)].size) : 0;
+}
+
+namespace SimulationState
+{
+    bool Save(const std::string& path, const Game& game)
+    {
+        SimulationStateWriter writer;
+        game.GetBoidManager().SaveState(writer);
+        game.GetProjectileController().SaveState(writer);
+        writer.Write(SimulationStateSection::Parameters, game.GetParameters());
+
+        const std::string randomState = MathHelper::SaveRandomState();
+        std::memcpy(writer.Allocate<char>(SimulationStateSection::RandomEngine, randomState.size()), randomState.data(), randomState.size());
+
+        return writer.SaveToFile(path);
+    }
+
+    bool Load(const std::string& path, Game& game)
+    {
+        SimulationStateReader reader;
+        if (!reader.Open(path))
+        {
+            return false;
+        }
+
+        // Everything is checked before anything is applied, a bad file leaves the running simulation untouched.
+        // The random engine is only replaced once its state parsed, so it is restored right before the rest
+        // The state continues with the parameters it was saved with, not the ones currently loaded from the file
+        const SimulationParameters* parameters = reader.Get<SimulationParameters>(SimulationStateSection::Parameters, 1);
+        std::string error;
+        if (!parameters || !parameters->Validate(error))
+        {
+            return false;
+        }
+
+        if (!game.GetBoidManager().IsStateValid(reader) || !game.GetProjectileController().IsStateValid(reader))
+        {
+            return false;
+        }
+
+        const size_t randomStateSize = reader.GetSectionSize(SimulationStateSection::RandomEngine);
+        const char* randomState = reader.Get<char>(SimulationStateSection::RandomEngine, randomStateSize);
+        if (!randomState || !MathHelper::LoadRandomState(std::string(randomState, randomStateSize)))
+        {
+            return false;
+        }
+
+        game.SetParameters(*parameters);
+        game.GetBoidManager().LoadState(reader);
+        game.GetProjectileController().LoadState(reader);
+        return true;
+    }
+}
@@ -0,0 +1,135 @@
+#pragma once
+#include "MappedFile.h"
+
+class Game;
+
+/// Versioned binary snapshot of the whole simulation.
+/// The file is a header with a section table followed by 16 byte aligned raw arrays (boids are stored as SoA),
+/// so saving is one bulk write and loading maps the file and reads the arrays in place, without any parsing.
+enum class SimulationStateSection : uint32_t
+{
+    BoidManager,
+    BoidIDs,
+    BoidFlockIDs,
+    BoidPositions,
+    BoidVelocities,
+    BoidAccelerations,
+    BoidSteeringStaleness,
+    ProjectileController,
+    Projectiles,
+    RandomEngine,
+    Parameters,
+    Count
+};
+
+struct SimulationStateHeader
+{
+    static constexpr uint32_t MAGIC = 0x4D495342; // "BSIM"
+    static constexpr uint32_t VERSION = 2;
+
+    struct Section
+    {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t sectionsCount;
+    uint32_t reserved;
+    Section sections[static_cast<size_t>(SimulationStateSection::Count)];
+};
+
+struct BoidManagerState
+{
+    uint32_t boidsCount;
+    uint32_t nextBoidID;
+    uint32_t flocksCount;
+    uint32_t flockingMode;
+    Vector3 boundsCenter;
+    Vector3 boundsSize;
+    float hashGridCellSize;
+    float steeringBudget;
+    float flockingErrorTimer;
+};
+
+struct ProjectileControllerState
+{
+    uint32_t projectilesCount;
+    uint32_t nextProjectileID;
+};
+
+struct ProjectileState
+{
+    uint32_t id;
+    Vector3 position;
+    Vector3 velocity;
+    Vector3 acceleration;
+    float drag;
+    float energy;
+    int32_t consumedBoidsCount;
+    uint32_t predator;
+};
+
+class SimulationStateWriter
+{
+public:
+    SimulationStateWriter();
+
+    // Returned memory is only valid until the next Allocate call, fill it right away
+    template <typename T>
+    T* Allocate(SimulationStateSection section, size_t count);
+
+    template <typename T>
+    void Write(SimulationStateSection section, const T& value) { *Allocate<T>(section, 1) = value; }
+
+    bool SaveToFile(const std::string& path) const;
+
+private:
+    char* AllocateBytes(SimulationStateSection section, size_t size);
+
+    std::vector<char> m_buffer;
+};
+
+class SimulationStateReader
+{
+public:
+    bool Open(const std::string& path);
+
+    // Points straight into the mapped file, nullptr when the section is missing or too small
+    template <typename T>
+    const T* Get(SimulationStateSection section, size_t count) const;
+
+    size_t GetSectionSize(SimulationStateSection section) const;
+
+private:
+    MappedFile m_file;
+    const SimulationStateHeader* m_header = nullptr;
+};
+
+namespace SimulationState
+{
+    bool Save(const std::string& path, const Game& game);
+    bool Load(const std::string& path, Game& game);
+}
+
+template <typename T>
+T* SimulationStateWriter::Allocate(SimulationStateSection section, size_t count)
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Simulation state sections are raw memory.");
+    static_assert(alignof(T) <= 16, "Sections are only 16 byte aligned.");
+    return reinterpret_cast<T*>(AllocateBytes(section, sizeof(T) * count));
+}
+
+template <typename T>
+const T* SimulationStateReader::Get(SimulationStateSection section, size_t count) const
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Simulation state sections are raw memory.");
+
+    if (GetSectionSize(section) < sizeof(T) * count)
+    {
+        return nullptr;
+    }
+
+    return reinterpret_cast<const T*>(m_file.GetData() + m_header->sections[static_cast<size_t>(section)].offset);
+}
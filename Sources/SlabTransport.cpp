@@ -0,0 +1,249 @@
+#include "pch.h"
+#include "SlabTransport.h"
+#include <chrono>
+#include <thread>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    using MessageSize = uint64_t;
+
+    constexpr int CONNECT_RETRY_MILLISECONDS = 50;
+    constexpr int EXCHANGE_TIMEOUT_MILLISECONDS = 30000;
+
+    std::string GetSocketPath(const std::string& socketDirectory, int rank)
+    {
+        return socketDirectory + "/boids-slab-" + std::to_string(rank) + ".sock";
+    }
+}
+
+SlabTransport::~SlabTransport()
+{
+    Close();
+}
+
+#ifdef _WIN32
+
+bool SlabTransport::Connect(int rank, int ranksCount, const std::string& socketDirectory, float timeoutSeconds, std::string& error)
+{
+    UNREFERENCED_PARAMETER(rank);
+    UNREFERENCED_PARAMETER(ranksCount);
+    UNREFERENCED_PARAMETER(socketDirectory);
+    UNREFERENCED_PARAMETER(timeoutSeconds);
+    error = "distributed mode is only supported on Linux";
+    return false;
+}
+
+void SlabTransport::Close()
+{
+}
+
+bool SlabTransport::Exchange(const std::vector<char> (&outgoing)[SidesCount], std::vector<char> (&incoming)[SidesCount], std::string& error)
+{
+    UNREFERENCED_PARAMETER(outgoing);
+    UNREFERENCED_PARAMETER(incoming);
+    error = "distributed mode is only supported on Linux";
+    return false;
+}
+
+#else
+
+bool SlabTransport::Connect(int rank, int ranksCount, const std::string& socketDirectory, float timeoutSeconds, std::string& error)
+{
+    Close();
+
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+
+    // Listening first, so the right neighbor can connect while this rank still waits for its left one
+    if (rank + 1 < ranksCount)
+    {
+        m_listenPath = GetSocketPath(socketDirectory, rank);
+        if (m_listenPath.size() >= sizeof(address.sun_path))
+        {
+            error = "socket path too long: " + m_listenPath;
+            return false;
+        }
+
+        std::strcpy(address.sun_path, m_listenPath.c_str());
+        unlink(m_listenPath.c_str());
+
+        m_listenSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (m_listenSocket < 0 || bind(m_listenSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(m_listenSocket, 1) != 0)
+        {
+            error = "can't listen on " + m_listenPath + ": " + std::strerror(errno);
+            Close();
+            return false;
+        }
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<float>(timeoutSeconds);
+
+    // Left neighbor may not be listening yet, retried until the timeout
+    if (rank > 0)
+    {
+        const std::string leftPath = GetSocketPath(socketDirectory, rank - 1);
+        std::strcpy(address.sun_path, leftPath.c_str());
+
+        while (m_sockets[Left] < 0)
+        {
+            const int connection = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (connect(connection, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0)
+            {
+                m_sockets[Left] = connection;
+                break;
+            }
+
+            close(connection);
+            if (std::chrono::steady_clock::now() > deadline)
+            {
+                error = "can't connect to " + leftPath + ": " + std::strerror(errno);
+                Close();
+                return false;
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(CONNECT_RETRY_MILLISECONDS));
+        }
+    }
+
+    if (m_listenSocket >= 0)
+    {
+        const int remainingMilliseconds = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count());
+        pollfd listenPoll = { m_listenSocket, POLLIN, 0 };
+
+        if (poll(&listenPoll, 1, std::max(0, remainingMilliseconds)) <= 0 || (m_sockets[Right] = accept(m_listenSocket, nullptr, nullptr)) < 0)
+        {
+            error = "rank " + std::to_string(rank + 1) + " didn't connect to " + m_listenPath;
+            Close();
+            return false;
+        }
+    }
+
+    for (int socketHandle : m_sockets)
+    {
+        if (socketHandle >= 0)
+        {
+            fcntl(socketHandle, F_SETFL, fcntl(socketHandle, F_GETFL) | O_NONBLOCK);
+        }
+    }
+
+    return true;
+}
+
+void SlabTransport::Close()
+{
+    for (int& socketHandle : m_sockets)
+    {
+        if (socketHandle >= 0)
+        {
+            close(socketHandle);
+            socketHandle = -1;
+        }
+    }
+
+    if (m_listenSocket >= 0)
+    {
+        close(m_listenSocket);
+        unlink(m_listenPath.c_str());
+        m_listenSocket = -1;
+    }
+}
+
+bool SlabTransport::Exchange(const std::vector<char> (&outgoing)[SidesCount], std::vector<char> (&incoming)[SidesCount], std::string& error)
+{
+    // Per side progress, the size prefix is sent and received like the rest of the message
+    struct Progress
+    {
+        MessageSize outgoingSize = 0;
+        size_t sent = 0;
+        MessageSize incomingSize = 0;
+        size_t received = 0;
+    };
+
+    Progress progress[SidesCount];
+    const auto isSendDone = [&](int side) { return m_sockets[side] < 0 || progress[side].sent == sizeof(MessageSize) + outgoing[side].size(); };
+    const auto isReceiveDone = [&](int side) { return m_sockets[side] < 0 || (progress[side].received >= sizeof(MessageSize) && progress[side].received == sizeof(MessageSize) + progress[side].incomingSize); };
+
+    for (int side = 0; side < SidesCount; side++)
+    {
+        progress[side].outgoingSize = outgoing[side].size();
+        incoming[side].clear();
+    }
+
+    while (!(isSendDone(Left) && isSendDone(Right) && isReceiveDone(Left) && isReceiveDone(Right)))
+    {
+        pollfd polls[SidesCount];
+        for (int side = 0; side < SidesCount; side++)
+        {
+            polls[side] = { m_sockets[side], static_cast<short>((isSendDone(side) ? 0 : POLLOUT) | (isReceiveDone(side) ? 0 : POLLIN)), 0 };
+        }
+
+        if (poll(polls, SidesCount, EXCHANGE_TIMEOUT_MILLISECONDS) <= 0)
+        {
+            error = "exchange with neighbors timed out";
+            return false;
+        }
+
+        for (int side = 0; side < SidesCount; side++)
+        {
+            Progress& sideProgress = progress[side];
+
+            if (polls[side].revents & (POLLERR | POLLNVAL))
+            {
+                error = "neighbor connection broken";
+                return false;
+            }
+
+            if ((polls[side].revents & POLLOUT) && !isSendDone(side))
+            {
+                const bool isSendingSize = sideProgress.sent < sizeof(MessageSize);
+                const char* data = isSendingSize ? reinterpret_cast<const char*>(&sideProgress.outgoingSize) + sideProgress.sent
+                                                 : outgoing[side].data() + (sideProgress.sent - sizeof(MessageSize));
+                const size_t length = isSendingSize ? sizeof(MessageSize) - sideProgress.sent : outgoing[side].size() - (sideProgress.sent - sizeof(MessageSize));
+
+                const ssize_t written = send(m_sockets[side], data, length, MSG_NOSIGNAL);
+                if (written < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+                {
+                    error = std::string("send failed: ") + std::strerror(errno);
+                    return false;
+                }
+
+                sideProgress.sent += std::max<ssize_t>(written, 0);
+            }
+
+            if ((polls[side].revents & (POLLIN | POLLHUP)) && !isReceiveDone(side))
+            {
+                const bool isReceivingSize = sideProgress.received < sizeof(MessageSize);
+                if (!isReceivingSize && incoming[side].size() != sideProgress.incomingSize)
+                {
+                    incoming[side].resize(sideProgress.incomingSize);
+                }
+
+                char* data = isReceivingSize ? reinterpret_cast<char*>(&sideProgress.incomingSize) + sideProgress.received
+                                             : incoming[side].data() + (sideProgress.received - sizeof(MessageSize));
+                const size_t length = isReceivingSize ? sizeof(MessageSize) - sideProgress.received : sideProgress.incomingSize - (sideProgress.received - sizeof(MessageSize));
+
+                const ssize_t readCount = recv(m_sockets[side], data, length, 0);
+                if (readCount == 0 || (readCount < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+                {
+                    error = "neighbor closed the connection";
+                    return false;
+                }
+
+                sideProgress.received += std::max<ssize_t>(readCount, 0);
+            }
+        }
+    }
+
+    return true;
+}
+
+#endif
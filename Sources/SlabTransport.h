@@ -0,0 +1,35 @@
+#pragma once
+
+/// Links of one slab process to its left and right neighbors over Unix domain sockets, slabs form a chain along X.
+/// Rank r listens on <directory>/boids-slab-<r>.sock for rank r + 1 and connects to the socket of rank r - 1.
+/// Messages are length prefixed byte blobs, Exchange sends to and receives from both neighbors at once with non blocking sockets,
+/// so two neighbors sending big messages to each other never wait on each other's full socket buffers. Linux / POSIX only.
+class SlabTransport
+{
+public:
+    enum Side
+    {
+        Left,
+        Right,
+        SidesCount
+    };
+
+    SlabTransport() = default;
+    ~SlabTransport();
+
+    SlabTransport(const SlabTransport&) = delete;
+    SlabTransport& operator=(const SlabTransport&) = delete;
+
+    bool Connect(int rank, int ranksCount, const std::string& socketDirectory, float timeoutSeconds, std::string& error);
+    void Close();
+
+    bool HasNeighbor(Side side) const { return m_sockets[side] >= 0; }
+
+    // Blocks until the messages for both existing neighbors are sent and theirs are received
+    bool Exchange(const std::vector<char> (&outgoing)[SidesCount], std::vector<char> (&incoming)[SidesCount], std::string& error);
+
+private:
+    int m_sockets[SidesCount] = { -1, -1 };
+    int m_listenSocket = -1;
+    std::string m_listenPath;
+};
@@ -2,20 +2,56 @@
 #include <unordered_map>
 #include "MathHelper.h"
 
+/// Each cell keeps its entities bucketed per flock (T needs to expose flockID), so same flock queries never touch other flocks.
+/// Optional per flock aggregates (count, position and velocity sums) are kept up to date incrementally,
+/// they need T to expose GetVelocity() and the aggregatedPosition / aggregatedVelocity bookkeeping.
 template<typename T>
 class SpatialHashGrid
 {
 public:
+    struct CellAggregate
+    {
+        int count = 0;
+        Vector3 positionSum = Vector3::Zero;
+        Vector3 velocitySum = Vector3::Zero;
+    };
+
     SpatialHashGrid(float cellSize);
 
     void AddEntity(T* entity);
     void RemoveEntity(T* entity);
     void UpdateEntity(T* entity);
     void Clear();
+    // Cells are never removed, reserving the cells the simulation volume can touch avoids rehashing while boids spread out
+    void ReserveCells(size_t cellsCount) { m_cells.reserve(cellsCount); }
+
+    float GetCellSize() const { return m_cellSize; }
+    // Drops every cell, entities have to be added again
+    void SetCellSize(float cellSize) { m_cellSize = cellSize; m_cells.clear(); }
+
+    void SetAggregatesEnabled(bool enabled);
+    bool AreAggregatesEnabled() const { return m_aggregatesEnabled; }
 
     std::vector<T*> QueryInRadius(Vector3 position, float radius) const;
+    void QueryInRadius(Vector3 position, float radius, int flockID, std::vector<T*>& sameFlock, std::vector<T*>& otherFlocks) const;
+
+    const std::vector<T*>* GetCellEntities(const Vector3Int& cellIndex, int flockID) const;
+    const CellAggregate* GetCellAggregate(const Vector3Int& cellIndex, int flockID) const;
 
 private:
+    struct FlockBucket
+    {
+        std::vector<T*> entities;
+        CellAggregate aggregate; // Only maintained when aggregates are enabled
+    };
+
+    static constexpr size_t INITIAL_BUCKET_CAPACITY = 8;
+
+    struct Cell
+    {
+        std::vector<FlockBucket> flocks; // Indexed by flockID, grows on demand
+    };
+
     struct CellKeyHasher
     {
         size_t operator()(const Vector3Int& key) const
@@ -25,14 +61,22 @@ private:
     };
 
     float m_cellSize;
-    std::unordered_map<Vector3Int, std::vector<T*>, CellKeyHasher> m_cells;
+    bool m_aggregatesEnabled;
+    std::unordered_map<Vector3Int, Cell, CellKeyHasher> m_cells;
 
     Vector3Int GetCellIndex(Vector3 position) const;
+    const FlockBucket* FindBucket(const Vector3Int& cellIndex, int flockID) const;
+    void AddToAggregate(CellAggregate& aggregate, T* entity);
+    void RemoveFromAggregate(CellAggregate& aggregate, const T* entity);
+
+    template <typename Callback>
+    void ForEachCellInRadius(Vector3 position, float radius, Callback callback) const;
 };
 
 template <typename T>
 SpatialHashGrid<T>::SpatialHashGrid(float cellSize)
     : m_cellSize(cellSize)
+    , m_aggregatesEnabled(false)
 {
 }
 
@@ -41,17 +85,43 @@ void SpatialHashGrid<T>::AddEntity(T* entity)
 {
     const Vector3Int cellIndex = GetCellIndex(entity->GetPosition());
     entity->SetCellIndex(cellIndex);
-    m_cells[cellIndex].push_back(entity);
+
+    Cell& cell = m_cells[cellIndex];
+    if (entity->flockID >= cell.flocks.size())
+    {
+        const size_t previousSize = cell.flocks.size();
+        cell.flocks.resize(entity->flockID + 1);
+
+        // Buckets start with room for a few entities and never shrink, boids moving between cells stop allocating once every cell has been visited
+        for (size_t i = previousSize; i < cell.flocks.size(); i++)
+        {
+            cell.flocks[i].entities.reserve(INITIAL_BUCKET_CAPACITY);
+        }
+    }
+
+    FlockBucket& bucket = cell.flocks[entity->flockID];
+    bucket.entities.push_back(entity);
+
+    if (m_aggregatesEnabled)
+    {
+        AddToAggregate(bucket.aggregate, entity);
+    }
 }
 
 template <typename T>
 void SpatialHashGrid<T>::RemoveEntity(T* entity)
 {
     auto it = m_cells.find(entity->GetCellIndex());
-    if (it != m_cells.end())
+    if (it != m_cells.end() && entity->flockID < it->second.flocks.size())
     {
-        std::vector<T*>& cellEntities = it->second;
-        cellEntities.erase(std::remove(cellEntities.begin(), cellEntities.end(), entity), cellEntities.end());
+        FlockBucket& bucket = it->second.flocks[entity->flockID];
+        std::vector<T*>& bucketEntities = bucket.entities;
+        bucketEntities.erase(std::remove(bucketEntities.begin(), bucketEntities.end(), entity), bucketEntities.end());
+
+        if (m_aggregatesEnabled)
+        {
+            RemoveFromAggregate(bucket.aggregate, entity);
+        }
     }
 }
 
@@ -62,6 +132,14 @@ void SpatialHashGrid<T>::UpdateEntity(T* entity)
 
     if (currentIndex == entity->GetCellIndex())
     {
+        if (m_aggregatesEnabled)
+        {
+            // Same cell, only the sums moved
+            CellAggregate& aggregate = m_cells[currentIndex].flocks[entity->flockID].aggregate;
+            RemoveFromAggregate(aggregate, entity);
+            AddToAggregate(aggregate, entity);
+        }
+
         return;
     }
 
@@ -75,11 +153,82 @@ void SpatialHashGrid<T>::Clear()
     m_cells.clear();
 }
 
+template <typename T>
+void SpatialHashGrid<T>::SetAggregatesEnabled(bool enabled)
+{
+    m_aggregatesEnabled = enabled;
+
+    for (auto& [cellIndex, cell] : m_cells)
+    {
+        for (FlockBucket& bucket : cell.flocks)
+        {
+            bucket.aggregate = CellAggregate();
+
+            if (!enabled)
+            {
+                continue;
+            }
+
+            for (T* entity : bucket.entities)
+            {
+                AddToAggregate(bucket.aggregate, entity);
+            }
+        }
+    }
+}
+
 template <typename T>
 std::vector<T*> SpatialHashGrid<T>::QueryInRadius(Vector3 position, float radius) const
 {
     std::vector<T*> result;
 
+    ForEachCellInRadius(position, radius, [&](const Cell& cell)
+    {
+        for (const FlockBucket& bucket : cell.flocks)
+        {
+            for (T* entity : bucket.entities) {
+                const float distanceSquared = (entity->GetPosition() - position).LengthSquared();
+
+                if (distanceSquared < radius * radius)
+                {
+                    result.push_back(entity);
+                }
+            }
+        }
+    });
+
+    return result;
+}
+
+template <typename T>
+void SpatialHashGrid<T>::QueryInRadius(Vector3 position, float radius, int flockID, std::vector<T*>& sameFlock, std::vector<T*>& otherFlocks) const
+{
+    sameFlock.clear();
+    otherFlocks.clear();
+
+    ForEachCellInRadius(position, radius, [&](const Cell& cell)
+    {
+        for (size_t i = 0; i < cell.flocks.size(); ++i)
+        {
+            // Flock split happens once per bucket instead of once per entity
+            std::vector<T*>& result = static_cast<int>(i) == flockID ? sameFlock : otherFlocks;
+
+            for (T* entity : cell.flocks[i].entities) {
+                const float distanceSquared = (entity->GetPosition() - position).LengthSquared();
+
+                if (distanceSquared < radius * radius)
+                {
+                    result.push_back(entity);
+                }
+            }
+        }
+    });
+}
+
+template <typename T>
+template <typename Callback>
+void SpatialHashGrid<T>::ForEachCellInRadius(Vector3 position, float radius, Callback callback) const
+{
     const Vector3Int minCellIndex = GetCellIndex({ position - Vector3::One * radius });
     const Vector3Int maxCellIndex = GetCellIndex({ position + Vector3::One * radius });
 
@@ -102,18 +251,60 @@ std::vector<T*> SpatialHashGrid<T>::QueryInRadius(Vector3 position, float radius
         auto it = m_cells.find({ x, y, z });
         if (it != m_cells.end())
         {
-            for (T* entity : it->second) {
-                const float distanceSquared = (entity->GetPosition() - position).LengthSquared();
-
-                if (distanceSquared < radius * radius)
-                {
-                    result.push_back(entity);
-                }
-            }
+            callback(it->second);
         }
     }
+}
 
-    return result;
+template <typename T>
+const typename SpatialHashGrid<T>::FlockBucket* SpatialHashGrid<T>::FindBucket(const Vector3Int& cellIndex, int flockID) const
+{
+    auto it = m_cells.find(cellIndex);
+    if (it == m_cells.end() || flockID >= static_cast<int>(it->second.flocks.size()))
+    {
+        return nullptr;
+    }
+
+    return &it->second.flocks[flockID];
+}
+
+template <typename T>
+const std::vector<T*>* SpatialHashGrid<T>::GetCellEntities(const Vector3Int& cellIndex, int flockID) const
+{
+    const FlockBucket* bucket = FindBucket(cellIndex, flockID);
+    return bucket ? &bucket->entities : nullptr;
+}
+
+template <typename T>
+const typename SpatialHashGrid<T>::CellAggregate* SpatialHashGrid<T>::GetCellAggregate(const Vector3Int& cellIndex, int flockID) const
+{
+    assert(m_aggregatesEnabled);
+    const FlockBucket* bucket = FindBucket(cellIndex, flockID);
+    return bucket && bucket->aggregate.count > 0 ? &bucket->aggregate : nullptr;
+}
+
+template <typename T>
+void SpatialHashGrid<T>::AddToAggregate(CellAggregate& aggregate, T* entity)
+{
+    entity->aggregatedPosition = entity->GetPosition();
+    entity->aggregatedVelocity = entity->GetVelocity();
+    ++aggregate.count;
+    aggregate.positionSum += entity->aggregatedPosition;
+    aggregate.velocitySum += entity->aggregatedVelocity;
+}
+
+template <typename T>
+void SpatialHashGrid<T>::RemoveFromAggregate(CellAggregate& aggregate, const T* entity)
+{
+    // Subtract exactly what was added, so the sums don't drift away from the cell content
+    --aggregate.count;
+    aggregate.positionSum -= entity->aggregatedPosition;
+    aggregate.velocitySum -= entity->aggregatedVelocity;
+
+    if (aggregate.count == 0)
+    {
+        aggregate = CellAggregate();
+    }
 }
 
 template <typename T>
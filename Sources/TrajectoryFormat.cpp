@@ -0,0 +1,368 @@
+#include "pch.h"
+#include "TrajectoryFormat.h"
+
+namespace TrajectoryFormat
+{
+    namespace
+    {
+        constexpr float POSITION_QUANTIZATION_STEPS = 65535.0f;
+        constexpr float VELOCITY_QUANTIZATION_STEPS = 32767.0f;
+
+        uint16_t QuantizePosition(float value, float min, float range)
+        {
+            const float normalized = std::clamp((value - min) / range, 0.0f, 1.0f);
+            return static_cast<uint16_t>(std::lround(normalized * POSITION_QUANTIZATION_STEPS));
+        }
+
+        float DequantizePosition(uint16_t value, float min, float range)
+        {
+            return min + range * (static_cast<float>(value) / POSITION_QUANTIZATION_STEPS);
+        }
+
+        int16_t QuantizeVelocity(float value, float range)
+        {
+            const float normalized = std::clamp(value / range, -1.0f, 1.0f);
+            return static_cast<int16_t>(std::lround(normalized * VELOCITY_QUANTIZATION_STEPS));
+        }
+
+        float DequantizeVelocity(int16_t value, float range)
+        {
+            return range * (static_cast<float>(value) / VELOCITY_QUANTIZATION_STEPS);
+        }
+
+        void WriteVarint(uint32_t value, std::vector<uint8_t>& output)
+        {
+            while (value >= 0x80)
+            {
+                output.push_back(static_cast<uint8_t>(value | 0x80));
+                value >>= 7;
+            }
+
+            output.push_back(static_cast<uint8_t>(value));
+        }
+
+        bool ReadVarint(const uint8_t*& data, const uint8_t* end, uint32_t& value)
+        {
+            value = 0;
+            for (int shift = 0; shift < 35 && data < end; shift += 7)
+            {
+                const uint8_t byte = *data++;
+                value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+
+                if ((byte & 0x80) == 0)
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        uint32_t ZigZag(int32_t value)
+        {
+            return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+        }
+
+        int32_t UnZigZag(uint32_t value)
+        {
+            return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+        }
+
+        void WriteRaw(const void* value, size_t size, std::vector<uint8_t>& output)
+        {
+            const uint8_t* bytes = static_cast<const uint8_t*>(value);
+            output.insert(output.end(), bytes, bytes + size);
+        }
+
+        // Prediction works in the integer domain, so encoder and decoder see the exact same values
+        template <typename T>
+        int32_t Predict(FramePrediction prediction, const std::vector<T>& previous, const std::vector<T>& beforePrevious, size_t index)
+        {
+            if (prediction == FramePrediction::SecondOrder)
+            {
+                return 2 * static_cast<int32_t>(previous[index]) - static_cast<int32_t>(beforePrevious[index]);
+            }
+
+            return static_cast<int32_t>(previous[index]);
+        }
+    }
+
+    FrameEncoder::FrameEncoder(const FileHeader& header)
+        : m_header(header)
+        , m_framesSinceKeyframe(0)
+    {
+    }
+
+    void FrameEncoder::BeginChunk()
+    {
+        m_framesSinceKeyframe = 0;
+    }
+
+    void FrameEncoder::EncodeFrame(const Frame& frame, std::vector<uint8_t>& output)
+    {
+        const size_t count = frame.ids.size();
+
+        std::swap(m_beforePrevious, m_previous);
+        std::swap(m_previous, m_current);
+
+        m_current.ids = frame.ids;
+        m_current.flockIDs = frame.flockIDs;
+        m_current.positions.resize(count * 3);
+        m_current.velocities.resize(count * 3);
+
+        for (size_t i = 0; i < count; i++)
+        {
+            m_current.positions[i * 3 + 0] = QuantizePosition(frame.positions[i].x, m_header.positionMin.x, m_header.positionRange.x);
+            m_current.positions[i * 3 + 1] = QuantizePosition(frame.positions[i].y, m_header.positionMin.y, m_header.positionRange.y);
+            m_current.positions[i * 3 + 2] = QuantizePosition(frame.positions[i].z, m_header.positionMin.z, m_header.positionRange.z);
+            m_current.velocities[i * 3 + 0] = QuantizeVelocity(frame.velocities[i].x, m_header.velocityRange);
+            m_current.velocities[i * 3 + 1] = QuantizeVelocity(frame.velocities[i].y, m_header.velocityRange);
+            m_current.velocities[i * 3 + 2] = QuantizeVelocity(frame.velocities[i].z, m_header.velocityRange);
+        }
+
+        // Any spawn or despawn changes the id list, that frame becomes a keyframe
+        FramePrediction prediction = FramePrediction::Keyframe;
+        if (m_framesSinceKeyframe > 0 && m_current.ids == m_previous.ids)
+        {
+            prediction = m_framesSinceKeyframe > 1 && m_previous.ids == m_beforePrevious.ids ? FramePrediction::SecondOrder : FramePrediction::FirstOrder;
+        }
+
+        m_framesSinceKeyframe = prediction == FramePrediction::Keyframe ? 1 : m_framesSinceKeyframe + 1;
+
+        WriteRaw(&frame.time, sizeof(frame.time), output);
+        WriteVarint(static_cast<uint32_t>(count), output);
+        output.push_back(static_cast<uint8_t>(prediction));
+
+        if (prediction == FramePrediction::Keyframe)
+        {
+            uint32_t previousID = 0;
+            for (uint32_t id : m_current.ids)
+            {
+                WriteVarint(id - previousID, output); // Ids are increasing, the gaps are tiny
+                previousID = id;
+            }
+
+            for (uint16_t flockID : m_current.flockIDs)
+            {
+                WriteVarint(flockID, output);
+            }
+
+            for (uint16_t value : m_current.positions)
+            {
+                WriteVarint(value, output);
+            }
+
+            for (int16_t value : m_current.velocities)
+            {
+                WriteVarint(ZigZag(value), output);
+            }
+
+            return;
+        }
+
+        for (size_t i = 0; i < m_current.positions.size(); i++)
+        {
+            WriteVarint(ZigZag(m_current.positions[i] - Predict(prediction, m_previous.positions, m_beforePrevious.positions, i)), output);
+        }
+
+        for (size_t i = 0; i < m_current.velocities.size(); i++)
+        {
+            WriteVarint(ZigZag(m_current.velocities[i] - Predict(prediction, m_previous.velocities, m_beforePrevious.velocities, i)), output);
+        }
+    }
+
+    FrameDecoder::FrameDecoder(const FileHeader& header)
+        : m_header(header)
+    {
+    }
+
+    void FrameDecoder::BeginChunk()
+    {
+        m_current = QuantizedFrame();
+        m_previous = QuantizedFrame();
+        m_beforePrevious = QuantizedFrame();
+    }
+
+    size_t FrameDecoder::DecodeFrame(const uint8_t* data, size_t size, Frame& frame)
+    {
+        const uint8_t* cursor = data;
+        const uint8_t* end = data + size;
+
+        uint32_t count = 0;
+        if (size < sizeof(frame.time) + 2)
+        {
+            return 0;
+        }
+
+        std::memcpy(&frame.time, cursor, sizeof(frame.time));
+        cursor += sizeof(frame.time);
+
+        if (!ReadVarint(cursor, end, count) || cursor >= end)
+        {
+            return 0;
+        }
+
+        const FramePrediction prediction = static_cast<FramePrediction>(*cursor++);
+
+        std::swap(m_beforePrevious, m_previous);
+        std::swap(m_previous, m_current);
+
+        if (prediction == FramePrediction::Keyframe)
+        {
+            m_current.ids.resize(count);
+            m_current.flockIDs.resize(count);
+        }
+        else if (m_previous.ids.size() != count)
+        {
+            return 0;
+        }
+        else
+        {
+            m_current.ids = m_previous.ids;
+            m_current.flockIDs = m_previous.flockIDs;
+        }
+
+        m_current.positions.resize(count * 3);
+        m_current.velocities.resize(count * 3);
+
+        uint32_t value = 0;
+        if (prediction == FramePrediction::Keyframe)
+        {
+            uint32_t previousID = 0;
+            for (uint32_t& id : m_current.ids)
+            {
+                if (!ReadVarint(cursor, end, value))
+                {
+                    return 0;
+                }
+
+                id = previousID + value;
+                previousID = id;
+            }
+
+            for (uint16_t& flockID : m_current.flockIDs)
+            {
+                if (!ReadVarint(cursor, end, value))
+                {
+                    return 0;
+                }
+
+                flockID = static_cast<uint16_t>(value);
+            }
+
+            for (uint16_t& position : m_current.positions)
+            {
+                if (!ReadVarint(cursor, end, value))
+                {
+                    return 0;
+                }
+
+                position = static_cast<uint16_t>(value);
+            }
+
+            for (int16_t& velocity : m_current.velocities)
+            {
+                if (!ReadVarint(cursor, end, value))
+                {
+                    return 0;
+                }
+
+                velocity = static_cast<int16_t>(UnZigZag(value));
+            }
+        }
+        else
+        {
+            for (size_t i = 0; i < m_current.positions.size(); i++)
+            {
+                if (!ReadVarint(cursor, end, value))
+                {
+                    return 0;
+                }
+
+                m_current.positions[i] = static_cast<uint16_t>(Predict(prediction, m_previous.positions, m_beforePrevious.positions, i) + UnZigZag(value));
+            }
+
+            for (size_t i = 0; i < m_current.velocities.size(); i++)
+            {
+                if (!ReadVarint(cursor, end, value))
+                {
+                    return 0;
+                }
+
+                m_current.velocities[i] = static_cast<int16_t>(Predict(prediction, m_previous.velocities, m_beforePrevious.velocities, i) + UnZigZag(value));
+            }
+        }
+
+        frame.ids = m_current.ids;
+        frame.flockIDs = m_current.flockIDs;
+        frame.positions.resize(count);
+        frame.velocities.resize(count);
+
+        for (size_t i = 0; i < count; i++)
+        {
+            frame.positions[i] = Vector3(DequantizePosition(m_current.positions[i * 3 + 0], m_header.positionMin.x, m_header.positionRange.x),
+                                         DequantizePosition(m_current.positions[i * 3 + 1], m_header.positionMin.y, m_header.positionRange.y),
+                                         DequantizePosition(m_current.positions[i * 3 + 2], m_header.positionMin.z, m_header.positionRange.z));
+            frame.velocities[i] = Vector3(DequantizeVelocity(m_current.velocities[i * 3 + 0], m_header.velocityRange),
+                                          DequantizeVelocity(m_current.velocities[i * 3 + 1], m_header.velocityRange),
+                                          DequantizeVelocity(m_current.velocities[i * 3 + 2], m_header.velocityRange));
+        }
+
+        return static_cast<size_t>(cursor - data);
+    }
+
+    void CompressZeroRuns(const std::vector<uint8_t>& input, std::vector<uint8_t>& output)
+    {
+        // Well predicted residuals are mostly zero bytes, a zero is followed by the length of its run
+        output.clear();
+        output.reserve(input.size());
+
+        for (size_t i = 0; i < input.size(); )
+        {
+            if (input[i] != 0)
+            {
+                output.push_back(input[i++]);
+                continue;
+            }
+
+            size_t runLength = 0;
+            while (i < input.size() && input[i] == 0)
+            {
+                ++runLength;
+                ++i;
+            }
+
+            output.push_back(0);
+            WriteVarint(static_cast<uint32_t>(runLength), output);
+        }
+    }
+
+    bool DecompressZeroRuns(const uint8_t* input, size_t size, std::vector<uint8_t>& output, size_t expectedSize)
+    {
+        output.clear();
+        output.reserve(expectedSize);
+
+        const uint8_t* cursor = input;
+        const uint8_t* end = input + size;
+
+        while (cursor < end)
+        {
+            const uint8_t byte = *cursor++;
+            if (byte != 0)
+            {
+                output.push_back(byte);
+                continue;
+            }
+
+            uint32_t runLength = 0;
+            if (!ReadVarint(cursor, end, runLength) || output.size() + runLength > expectedSize)
+            {
+                return false;
+            }
+
+            output.insert(output.end(), runLength, 0);
+        }
+
+        return output.size() == expectedSize;
+    }
+}
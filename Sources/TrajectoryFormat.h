@@ -0,0 +1,102 @@
+#pragma once
+#include "SimulationParameters.h"
+
+/// Chunked trajectory stream shared by TrajectoryRecorder and TrajectoryPlayer.
+/// File header, then chunks of up to CHUNK_FRAMES_COUNT frames; the first frame of a chunk is always a keyframe so playback can seek to any chunk.
+/// Positions are quantized to 16 bits inside the recorded range and velocities to 16 bits of +-max speed,
+/// the following frames store the residual against a first / second order prediction as zigzag varints, then the chunk payload is zero run length packed.
+namespace TrajectoryFormat
+{
+    constexpr uint32_t FILE_MAGIC = 0x4A525442; // "BTRJ"
+    constexpr uint32_t CHUNK_MAGIC = 0x4B4E4843; // "CHNK"
+    constexpr uint32_t VERSION = 4;
+    constexpr int CHUNK_FRAMES_COUNT = 30;
+    constexpr const char* DEFAULT_PATH = "../../data/recordings/trajectory.btrj";
+
+    enum class Compression : uint32_t
+    {
+        None,
+        ZeroRunLength
+    };
+
+    enum class FramePrediction : uint8_t
+    {
+        Keyframe,   // Absolute values, ids and flock ids
+        FirstOrder, // Residual to the previous frame, same ids
+        SecondOrder // Residual to previous + (previous - one before), same ids
+    };
+
+    struct FileHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        Vector3 positionMin;
+        Vector3 positionRange;
+        float velocityRange;
+        Compression compression;
+        SimulationParameters parameters; // When the recording started, a file change while recording isn't tracked
+    };
+
+    struct ChunkHeader
+    {
+        uint32_t magic;
+        uint32_t firstFrameIndex;
+        uint32_t framesCount;
+        float firstFrameTime; // Lets playback seek by time without decoding
+        Compression compression;
+        uint32_t rawSize;
+        uint32_t storedSize;
+    };
+
+    struct Frame
+    {
+        float time = 0.0f;
+        std::vector<uint32_t> ids;
+        std::vector<uint16_t> flockIDs;
+        std::vector<Vector3> positions;
+        std::vector<Vector3> velocities;
+    };
+
+    struct QuantizedFrame
+    {
+        std::vector<uint32_t> ids;
+        std::vector<uint16_t> flockIDs;
+        std::vector<uint16_t> positions;  // xyz interleaved
+        std::vector<int16_t> velocities;  // xyz interleaved
+    };
+
+    class FrameEncoder
+    {
+    public:
+        explicit FrameEncoder(const FileHeader& header);
+
+        void BeginChunk();
+        void EncodeFrame(const Frame& frame, std::vector<uint8_t>& output);
+
+    private:
+        const FileHeader& m_header;
+        QuantizedFrame m_current;
+        QuantizedFrame m_previous;
+        QuantizedFrame m_beforePrevious;
+        int m_framesSinceKeyframe;
+    };
+
+    class FrameDecoder
+    {
+    public:
+        explicit FrameDecoder(const FileHeader& header);
+
+        void BeginChunk();
+        // Returns the number of bytes consumed, 0 on corrupted data
+        size_t DecodeFrame(const uint8_t* data, size_t size, Frame& frame);
+
+    private:
+        const FileHeader& m_header;
+        QuantizedFrame m_current;
+        QuantizedFrame m_previous;
+        QuantizedFrame m_beforePrevious;
+    };
+
+    void CompressZeroRuns(const std::vector<uint8_t>& input, std::vector<uint8_t>& output);
+    bool DecompressZeroRuns(const uint8_t* input, size_t size, std::vector<uint8_t>& output, size_t expectedSize);
+}
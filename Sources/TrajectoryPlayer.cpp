@@ -0,0 +1,282 @@
+#include "pch.h"
+#include "TrajectoryPlayer.h"
+#include "BoidManager.h"
+#include "FrameworkInstancedRenderContext.h"
+
+namespace
+{
+    constexpr size_t NO_CHUNK = static_cast<size_t>(-1);
+    constexpr float SEEK_TIME = 1.0f;
+
+    // Headers inside the mapping aren't aligned, so they are copied out instead of cast in place
+    template<typename T>
+    bool ReadHeader(const MappedFile& file, size_t offset, T& header)
+    {
+        if (offset + sizeof(T) > file.GetSize())
+        {
+            return false;
+        }
+
+        std::memcpy(&header, file.GetData() + offset, sizeof(T));
+        return true;
+    }
+}
+
+TrajectoryPlayer::TrajectoryPlayer()
+    : m_header()
+    , m_decoder(m_header)
+    , m_framesCount(0)
+    , m_loadedChunk(NO_CHUNK)
+    , m_chunkData(nullptr)
+    , m_chunkSize(0)
+    , m_chunkCursor(0)
+    , m_nextDecodedFrameIndex(0)
+    , m_currentFrameIndex(0)
+    , m_hasNextFrame(false)
+    , m_playbackTime(0.0f)
+    , m_seekBackwardKeyPressedLastFrame(false)
+    , m_seekForwardKeyPressedLastFrame(false)
+{
+}
+
+bool TrajectoryPlayer::Open(const std::string& path)
+{
+    Close();
+
+    if (!m_file.Open(path))
+    {
+        return false;
+    }
+
+    if (!ReadHeader(m_file, 0, m_header) || m_header.magic != TrajectoryFormat::FILE_MAGIC || m_header.version != TrajectoryFormat::VERSION)
+    {
+        Close();
+        return false;
+    }
+
+    // Frame index, only chunk headers are touched, payloads stay untouched in the mapping until played
+    size_t offset = sizeof(TrajectoryFormat::FileHeader);
+    TrajectoryFormat::ChunkHeader chunkHeader;
+
+    while (ReadHeader(m_file, offset, chunkHeader))
+    {
+        const size_t payloadOffset = offset + sizeof(TrajectoryFormat::ChunkHeader);
+        const bool isValid = chunkHeader.magic == TrajectoryFormat::CHUNK_MAGIC
+                          && chunkHeader.firstFrameIndex == m_framesCount
+                          && chunkHeader.framesCount > 0
+                          && payloadOffset + chunkHeader.storedSize <= m_file.GetSize();
+
+        // A recording cut short (crash, full disk) is still playable up to its last whole chunk
+        if (!isValid)
+        {
+            break;
+        }
+
+        m_chunks.push_back({ chunkHeader.firstFrameIndex, chunkHeader.framesCount, payloadOffset, chunkHeader });
+        m_framesCount += chunkHeader.framesCount;
+        offset = payloadOffset + chunkHeader.storedSize;
+    }
+
+    if (m_chunks.empty() || !SeekToFrame(0))
+    {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void TrajectoryPlayer::Close()
+{
+    m_file.Close();
+    m_chunks.clear();
+    m_framesCount = 0;
+    m_loadedChunk = NO_CHUNK;
+    m_chunkData = nullptr;
+    m_chunkSize = 0;
+    m_chunkCursor = 0;
+    m_nextDecodedFrameIndex = 0;
+    m_currentFrame = TrajectoryFormat::Frame();
+    m_currentFrameIndex = 0;
+    m_hasNextFrame = false;
+    m_playbackTime = 0.0f;
+}
+
+void TrajectoryPlayer::OnUpdate(float deltaTime, const DirectX::Keyboard::State& keyboardState)
+{
+    if (!IsOpen())
+    {
+        return;
+    }
+
+    if (m_seekBackwardKeyPressedLastFrame && !keyboardState.F3)
+    {
+        SeekToTime(m_currentFrame.time - SEEK_TIME);
+    }
+    else if (m_seekForwardKeyPressedLastFrame && !keyboardState.F4)
+    {
+        SeekToTime(m_currentFrame.time + SEEK_TIME);
+    }
+
+    m_seekBackwardKeyPressedLastFrame = keyboardState.F3;
+    m_seekForwardKeyPressedLastFrame = keyboardState.F4;
+
+    // Frames are stepped at the recorded timestamps, independent of the render frame rate
+    m_playbackTime += deltaTime;
+
+    while (m_hasNextFrame && m_nextFrame.time <= m_playbackTime)
+    {
+        std::swap(m_currentFrame, m_nextFrame);
+        ++m_currentFrameIndex;
+        m_hasNextFrame = ReadFrame(m_currentFrameIndex + 1, m_nextFrame);
+    }
+
+    if (!m_hasNextFrame)
+    {
+        SeekToFrame(0);
+    }
+}
+
+void TrajectoryPlayer::OnRender(const framework::RenderContextPtr& renderContext, const BoidManager& boidManager)
+{
+    if (!IsOpen())
+    {
+        return;
+    }
+
+    // Recordings may come from a setup with more flocks, those wrap around the current palette
+    const int flocksCount = boidManager.GetFlocksCount();
+    m_boidInstances.Begin(flocksCount);
+
+    for (uint16_t flockID : m_currentFrame.flockIDs)
+    {
+        m_boidInstances.CountInstance(flockID % flocksCount);
+    }
+
+    m_boidInstances.Allocate();
+
+    for (size_t i = 0; i < m_currentFrame.positions.size(); i++)
+    {
+        const int flock = m_currentFrame.flockIDs[i] % flocksCount;
+        m_boidInstances.AddInstance(flock, m_currentFrame.positions[i], flock);
+    }
+
+    FrameworkInstancedRenderContext instancedRenderContext(renderContext);
+    boidManager.RenderInstances(instancedRenderContext, m_boidInstances);
+
+    std::vector<std::string> hudLines;
+    hudLines.push_back("replay frame: " + std::to_string(m_currentFrameIndex + 1) + " / " + std::to_string(m_framesCount) + ", time: " + std::to_string(m_currentFrame.time) + " s");
+    hudLines.push_back("boids count: " + std::to_string(m_currentFrame.positions.size()));
+    boidManager.RenderOverlay(renderContext, hudLines);
+}
+
+bool TrajectoryPlayer::SeekToFrame(uint32_t frameIndex)
+{
+    if (frameIndex >= m_framesCount || !ReadFrame(frameIndex, m_currentFrame))
+    {
+        return false;
+    }
+
+    m_currentFrameIndex = frameIndex;
+    m_playbackTime = m_currentFrame.time;
+    m_hasNextFrame = ReadFrame(frameIndex + 1, m_nextFrame);
+    return true;
+}
+
+bool TrajectoryPlayer::SeekToTime(float time)
+{
+    // Last chunk starting at or before the time, then decoded forward to the last frame at or before it.
+    // Recordings don't have to be at a fixed rate, so frame counts can't stand in for time
+    const auto iter = std::upper_bound(m_chunks.begin(), m_chunks.end(), time,
+        [](float seekTime, const ChunkEntry& chunk) { return seekTime < chunk.header.firstFrameTime; });
+
+    const ChunkEntry& chunk = iter == m_chunks.begin() ? m_chunks.front() : *(iter - 1);
+    if (!ReadFrame(chunk.firstFrameIndex, m_currentFrame))
+    {
+        return false;
+    }
+
+    m_currentFrameIndex = chunk.firstFrameIndex;
+    m_hasNextFrame = ReadFrame(m_currentFrameIndex + 1, m_nextFrame);
+
+    while (m_hasNextFrame && m_nextFrame.time <= time)
+    {
+        std::swap(m_currentFrame, m_nextFrame);
+        ++m_currentFrameIndex;
+        m_hasNextFrame = ReadFrame(m_currentFrameIndex + 1, m_nextFrame);
+    }
+
+    m_playbackTime = m_currentFrame.time;
+    return true;
+}
+
+bool TrajectoryPlayer::ReadFrame(uint32_t frameIndex, TrajectoryFormat::Frame& frame)
+{
+    if (frameIndex >= m_framesCount)
+    {
+        return false;
+    }
+
+    // Anything but the next frame in decode order restarts from the keyframe of its chunk
+    const size_t chunkIndex = FindChunk(frameIndex);
+    if (chunkIndex != m_loadedChunk || frameIndex < m_nextDecodedFrameIndex)
+    {
+        if (!LoadChunk(chunkIndex))
+        {
+            return false;
+        }
+    }
+
+    while (m_nextDecodedFrameIndex <= frameIndex)
+    {
+        const size_t consumed = m_decoder.DecodeFrame(m_chunkData + m_chunkCursor, m_chunkSize - m_chunkCursor, frame);
+        if (consumed == 0)
+        {
+            m_loadedChunk = NO_CHUNK;
+            return false;
+        }
+
+        m_chunkCursor += consumed;
+        ++m_nextDecodedFrameIndex;
+    }
+
+    return true;
+}
+
+bool TrajectoryPlayer::LoadChunk(size_t chunkIndex)
+{
+    const ChunkEntry& chunk = m_chunks[chunkIndex];
+    const uint8_t* payload = reinterpret_cast<const uint8_t*>(m_file.GetData()) + chunk.payloadOffset;
+
+    m_loadedChunk = NO_CHUNK;
+
+    if (chunk.header.compression == TrajectoryFormat::Compression::ZeroRunLength)
+    {
+        if (!TrajectoryFormat::DecompressZeroRuns(payload, chunk.header.storedSize, m_decompressedChunk, chunk.header.rawSize))
+        {
+            return false;
+        }
+
+        m_chunkData = m_decompressedChunk.data();
+        m_chunkSize = m_decompressedChunk.size();
+    }
+    else
+    {
+        m_chunkData = payload;
+        m_chunkSize = chunk.header.storedSize;
+    }
+
+    m_decoder.BeginChunk();
+    m_loadedChunk = chunkIndex;
+    m_chunkCursor = 0;
+    m_nextDecodedFrameIndex = chunk.firstFrameIndex;
+    return true;
+}
+
+size_t TrajectoryPlayer::FindChunk(uint32_t frameIndex) const
+{
+    const auto iter = std::upper_bound(m_chunks.begin(), m_chunks.end(), frameIndex,
+        [](uint32_t index, const ChunkEntry& chunk) { return index < chunk.firstFrameIndex; });
+
+    return static_cast<size_t>(iter - m_chunks.begin()) - 1;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "IRenderContext.h"
+#include "MappedFile.h"
+#include "RenderInstanceBuffer.h"
+#include "TrajectoryFormat.h"
+
+class BoidManager;
+
+/// Plays back a trajectory recorded by TrajectoryRecorder straight from a memory mapped file.
+/// On open only the chunk headers are scanned to build a frame index, frames are decoded lazily one ahead of the playback time,
+/// so memory use doesn't grow with the recording length. Seeking jumps to the keyframe of the chunk holding the frame and decodes forward.
+class TrajectoryPlayer
+{
+public:
+    TrajectoryPlayer();
+
+    bool Open(const std::string& path);
+    void Close();
+    bool IsOpen() const { return m_file.IsOpen(); }
+
+    void OnUpdate(float deltaTime, const DirectX::Keyboard::State& keyboardState);
+    void OnRender(const framework::RenderContextPtr& renderContext, const BoidManager& boidManager);
+
+    bool SeekToFrame(uint32_t frameIndex);
+    bool SeekToTime(float time);
+    uint32_t GetFramesCount() const { return m_framesCount; }
+    const SimulationParameters& GetParameters() const { return m_header.parameters; }
+    uint32_t GetCurrentFrameIndex() const { return m_currentFrameIndex; }
+    const TrajectoryFormat::Frame& GetCurrentFrame() const { return m_currentFrame; }
+
+private:
+    struct ChunkEntry
+    {
+        uint32_t firstFrameIndex;
+        uint32_t framesCount;
+        size_t payloadOffset;
+        TrajectoryFormat::ChunkHeader header;
+    };
+
+    bool ReadFrame(uint32_t frameIndex, TrajectoryFormat::Frame& frame);
+    bool LoadChunk(size_t chunkIndex);
+    size_t FindChunk(uint32_t frameIndex) const;
+
+    MappedFile m_file;
+    TrajectoryFormat::FileHeader m_header;
+    TrajectoryFormat::FrameDecoder m_decoder;
+    std::vector<ChunkEntry> m_chunks;
+    uint32_t m_framesCount;
+
+    // Decoder position, uncompressed chunks are read in place from the mapping
+    size_t m_loadedChunk;
+    std::vector<uint8_t> m_decompressedChunk;
+    const uint8_t* m_chunkData;
+    size_t m_chunkSize;
+    size_t m_chunkCursor;
+    uint32_t m_nextDecodedFrameIndex;
+
+    TrajectoryFormat::Frame m_currentFrame;
+    TrajectoryFormat::Frame m_nextFrame;
+    uint32_t m_currentFrameIndex;
+    bool m_hasNextFrame;
+    float m_playbackTime;
+
+    bool m_seekBackwardKeyPressedLastFrame;
+    bool m_seekForwardKeyPressedLastFrame;
+
+    RenderInstanceBuffer m_boidInstances;
+};
@@ -0,0 +1,205 @@
+#include "pch.h"
+#include "TrajectoryRecorder.h"
+
+#include <filesystem>
+
+namespace
+{
+    constexpr size_t MAX_QUEUED_FRAMES = 8;
+    constexpr TrajectoryFormat::Compression RECORDING_COMPRESSION = TrajectoryFormat::Compression::ZeroRunLength;
+}
+
+TrajectoryRecorder::TrajectoryRecorder()
+    : m_header()
+    , m_encoder(m_header)
+    , m_stopRequested(false)
+    , m_chunkFirstFrameIndex(0)
+    , m_chunkFirstFrameTime(0.0f)
+    , m_chunkFramesCount(0)
+    , m_writtenFramesCount(0)
+    , m_submittedFramesCount(0)
+    , m_droppedFramesCount(0)
+{
+}
+
+TrajectoryRecorder::~TrajectoryRecorder()
+{
+    Stop();
+}
+
+bool TrajectoryRecorder::Start(const std::string& path, Vector3 positionMin, Vector3 positionRange, float velocityRange, const SimulationParameters& parameters)
+{
+    Stop();
+
+    const std::filesystem::path filePath(path);
+    if (filePath.has_parent_path())
+    {
+        std::error_code error;
+        std::filesystem::create_directories(filePath.parent_path(), error);
+    }
+
+    m_stream.open(path, std::ios::binary | std::ios::trunc);
+    if (!m_stream)
+    {
+        return false;
+    }
+
+    m_header.magic = TrajectoryFormat::FILE_MAGIC;
+    m_header.version = TrajectoryFormat::VERSION;
+    m_header.positionMin = positionMin;
+    m_header.positionRange = positionRange;
+    m_header.velocityRange = velocityRange;
+    m_header.compression = RECORDING_COMPRESSION;
+    m_header.parameters = parameters;
+    m_stream.write(reinterpret_cast<const char*>(&m_header), sizeof(m_header));
+    if (!m_stream)
+    {
+        m_stream.close();
+        return false;
+    }
+
+    m_chunkBuffer.clear();
+    m_chunkFirstFrameIndex = 0;
+    m_chunkFirstFrameTime = 0.0f;
+    m_chunkFramesCount = 0;
+    m_writtenFramesCount = 0;
+    m_submittedFramesCount = 0;
+    m_droppedFramesCount = 0;
+    m_encoder.BeginChunk();
+
+    m_stopRequested = false;
+    m_writer = std::thread(&TrajectoryRecorder::WriterLoop, this);
+    return true;
+}
+
+void TrajectoryRecorder::Stop()
+{
+    if (!m_writer.joinable())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopRequested = true;
+    }
+
+    m_condition.notify_one();
+    m_writer.join();
+
+    FlushChunk();
+    m_stream.close();
+}
+
+TrajectoryFormat::Frame* TrajectoryRecorder::AcquireFrame()
+{
+    assert(!m_acquiredFrame);
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_queuedFrames.size() >= MAX_QUEUED_FRAMES)
+    {
+        ++m_droppedFramesCount;
+        return nullptr;
+    }
+
+    if (m_freeFrames.empty())
+    {
+        m_acquiredFrame = std::make_unique<TrajectoryFormat::Frame>();
+    }
+    else
+    {
+        m_acquiredFrame = std::move(m_freeFrames.back());
+        m_freeFrames.pop_back();
+    }
+
+    return m_acquiredFrame.get();
+}
+
+void TrajectoryRecorder::SubmitFrame(TrajectoryFormat::Frame* frame)
+{
+    assert(frame == m_acquiredFrame.get());
+    UNREFERENCED_PARAMETER(frame);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queuedFrames.push_back(std::move(m_acquiredFrame));
+    }
+
+    ++m_submittedFramesCount;
+    m_condition.notify_one();
+}
+
+void TrajectoryRecorder::WriterLoop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (true)
+    {
+        m_condition.wait(lock, [this] { return !m_queuedFrames.empty() || m_stopRequested; });
+
+        // Whatever is still queued is written before stopping
+        if (m_queuedFrames.empty())
+        {
+            return;
+        }
+
+        std::unique_ptr<TrajectoryFormat::Frame> frame = std::move(m_queuedFrames.front());
+        m_queuedFrames.pop_front();
+        lock.unlock();
+
+        WriteFrame(*frame);
+
+        lock.lock();
+        m_freeFrames.push_back(std::move(frame));
+    }
+}
+
+void TrajectoryRecorder::WriteFrame(const TrajectoryFormat::Frame& frame)
+{
+    if (m_chunkFramesCount == 0)
+    {
+        m_chunkFirstFrameTime = frame.time;
+    }
+
+    m_encoder.EncodeFrame(frame, m_chunkBuffer);
+    ++m_chunkFramesCount;
+    ++m_writtenFramesCount;
+
+    if (m_chunkFramesCount >= TrajectoryFormat::CHUNK_FRAMES_COUNT)
+    {
+        FlushChunk();
+    }
+}
+
+void TrajectoryRecorder::FlushChunk()
+{
+    if (m_chunkFramesCount == 0)
+    {
+        return;
+    }
+
+    const std::vector<uint8_t>* payload = &m_chunkBuffer;
+    if (m_header.compression == TrajectoryFormat::Compression::ZeroRunLength)
+    {
+        TrajectoryFormat::CompressZeroRuns(m_chunkBuffer, m_compressedBuffer);
+        payload = &m_compressedBuffer;
+    }
+
+    TrajectoryFormat::ChunkHeader chunkHeader;
+    chunkHeader.magic = TrajectoryFormat::CHUNK_MAGIC;
+    chunkHeader.firstFrameIndex = m_chunkFirstFrameIndex;
+    chunkHeader.framesCount = m_chunkFramesCount;
+    chunkHeader.firstFrameTime = m_chunkFirstFrameTime;
+    chunkHeader.compression = m_header.compression;
+    chunkHeader.rawSize = static_cast<uint32_t>(m_chunkBuffer.size());
+    chunkHeader.storedSize = static_cast<uint32_t>(payload->size());
+
+    m_stream.write(reinterpret_cast<const char*>(&chunkHeader), sizeof(chunkHeader));
+    m_stream.write(reinterpret_cast<const char*>(payload->data()), static_cast<std::streamsize>(payload->size()));
+
+    // Next chunk starts with a keyframe, so playback can seek straight to it
+    m_chunkBuffer.clear();
+    m_chunkFirstFrameIndex = m_writtenFramesCount;
+    m_chunkFramesCount = 0;
+    m_encoder.BeginChunk();
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include "TrajectoryFormat.h"
+
+/// Streams recorded frames to disk on a background thread.
+/// The simulation only fills a pooled frame and hands it over, quantization, delta encoding, compression and file writes all happen on the writer thread.
+/// The queue is bounded, when the writer can't keep up frames are dropped instead of stalling the simulation.
+class TrajectoryRecorder
+{
+public:
+    TrajectoryRecorder();
+    ~TrajectoryRecorder();
+
+    bool Start(const std::string& path, Vector3 positionMin, Vector3 positionRange, float velocityRange, const SimulationParameters& parameters);
+    void Stop();
+    bool IsRecording() const { return m_writer.joinable(); }
+
+    // nullptr when the queue is full, the frame is then dropped
+    TrajectoryFormat::Frame* AcquireFrame();
+    void SubmitFrame(TrajectoryFormat::Frame* frame);
+
+    int GetSubmittedFramesCount() const { return m_submittedFramesCount; }
+    int GetDroppedFramesCount() const { return m_droppedFramesCount; }
+
+private:
+    void WriterLoop();
+    void WriteFrame(const TrajectoryFormat::Frame& frame);
+    void FlushChunk();
+
+    TrajectoryFormat::FileHeader m_header;
+    TrajectoryFormat::FrameEncoder m_encoder;
+    std::ofstream m_stream;
+
+    std::thread m_writer;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stopRequested;
+
+    std::deque<std::unique_ptr<TrajectoryFormat::Frame>> m_queuedFrames;
+    std::vector<std::unique_ptr<TrajectoryFormat::Frame>> m_freeFrames;
+    std::unique_ptr<TrajectoryFormat::Frame> m_acquiredFrame;
+
+    std::vector<uint8_t> m_chunkBuffer;
+    std::vector<uint8_t> m_compressedBuffer;
+    uint32_t m_chunkFirstFrameIndex;
+    float m_chunkFirstFrameTime;
+    uint32_t m_chunkFramesCount;
+    uint32_t m_writtenFramesCount;
+
+    std::atomic<int> m_submittedFramesCount;
+    std::atomic<int> m_droppedFramesCount;
+};
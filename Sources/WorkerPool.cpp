@@ -0,0 +1,109 @@
+#include "pch.h"
+#include "WorkerPool.h"
+
+namespace
+{
+    constexpr size_t CHUNKS_PER_THREAD = 4; // A few chunks each, so one slow chunk doesn't leave the other threads idle
+}
+
+WorkerPool::WorkerPool(size_t workersCount)
+    : m_job(nullptr)
+    , m_count(0)
+    , m_chunkSize(1)
+    , m_nextBegin(0)
+    , m_busyWorkersCount(0)
+    , m_jobGeneration(0)
+    , m_stopRequested(false)
+{
+    m_workers.reserve(workersCount);
+    for (size_t i = 0; i < workersCount; i++)
+    {
+        m_workers.emplace_back(&WorkerPool::WorkerLoop, this);
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopRequested = true;
+    }
+
+    m_workAvailable.notify_all();
+    for (std::thread& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+void WorkerPool::ParallelFor(size_t count, size_t minChunkSize, const RangeJob& job)
+{
+    const size_t chunkSize = std::max(minChunkSize, count / (GetThreadsCount() * CHUNKS_PER_THREAD) + 1);
+
+    // Not worth waking anybody up
+    if (m_workers.empty() || count <= chunkSize)
+    {
+        job(0, count);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = &job;
+        m_count = count;
+        m_chunkSize = chunkSize;
+        m_nextBegin = 0;
+        m_busyWorkersCount = m_workers.size();
+        ++m_jobGeneration;
+    }
+
+    m_workAvailable.notify_all();
+    ProcessChunks();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_workDone.wait(lock, [this] { return m_busyWorkersCount == 0; });
+    m_job = nullptr;
+}
+
+void WorkerPool::WorkerLoop()
+{
+    uint64_t lastJobGeneration = 0;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_workAvailable.wait(lock, [&] { return m_stopRequested || m_jobGeneration != lastJobGeneration; });
+
+            if (m_stopRequested)
+            {
+                return;
+            }
+
+            lastJobGeneration = m_jobGeneration;
+        }
+
+        ProcessChunks();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            --m_busyWorkersCount;
+        }
+
+        m_workDone.notify_one();
+    }
+}
+
+void WorkerPool::ProcessChunks()
+{
+    while (true)
+    {
+        const size_t begin = m_nextBegin.fetch_add(m_chunkSize);
+        if (begin >= m_count)
+        {
+            return;
+        }
+
+        (*m_job)(begin, std::min(begin + m_chunkSize, m_count));
+    }
+}
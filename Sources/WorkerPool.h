@@ -0,0 +1,41 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/// Persistent worker threads for data parallel loops. ParallelFor splits [0, count) into chunks that the workers and the calling thread
+/// pull from a shared counter until all are done, so the caller can treat it like a plain loop. One ParallelFor at a time.
+class WorkerPool
+{
+public:
+    using RangeJob = std::function<void(size_t begin, size_t end)>;
+
+    explicit WorkerPool(size_t workersCount = std::max(1u, std::thread::hardware_concurrency()) - 1);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    void ParallelFor(size_t count, size_t minChunkSize, const RangeJob& job);
+
+    size_t GetThreadsCount() const { return m_workers.size() + 1; }
+
+private:
+    void WorkerLoop();
+    void ProcessChunks();
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_workAvailable;
+    std::condition_variable m_workDone;
+
+    const RangeJob* m_job;
+    size_t m_count;
+    size_t m_chunkSize;
+    std::atomic<size_t> m_nextBegin;
+    size_t m_busyWorkersCount;
+    uint64_t m_jobGeneration;
+    bool m_stopRequested;
+};
@@ -0,0 +1,123 @@
+#include "pch.h"
+#include "BoidQuantization.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+
+/// Accuracy and throughput of the compact boid state (USE_COMPACT_BOID_STATE) against full floats.
+/// Usage: BoidStateBenchmark [boidsCount]
+namespace
+{
+    // Same frame BoidManager sets up, default bounds plus the out of bounds margin, and its speed limits
+    const Vector3 BOUNDS_SIZE = Vector3(45.0f, 35.0f, 45.0f);
+    const Vector3 BOUNDS_MIN = Vector3(-22.5f, 0.0f, -22.5f);
+    constexpr float OUT_OF_BOUNDS_MARGIN = 0.25f;
+    constexpr float MIN_SPEED = 6.5f;
+    constexpr float MAX_SPEED = 10.5f;
+    constexpr int NEIGHBORS_COUNT = 32;
+    constexpr float RADIANS_TO_DEGREES = 57.2957795f;
+
+    struct FullBoid
+    {
+        Vector3 position;
+        Vector3 velocity;
+    };
+
+    struct CompactBoid
+    {
+        BoidQuantization::QuantizedPosition position;
+        BoidQuantization::EncodedVelocity velocity;
+    };
+
+    // Cohesion / alignment style gather, every boid reads a few random neighbors, which is what makes the steering loop bandwidth bound
+    template<typename TBoid>
+    double MeasureGather(const std::vector<TBoid>& boids, const std::vector<uint32_t>& neighbors, Vector3& checksum)
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < boids.size(); i++)
+        {
+            Vector3 positionSum = Vector3::Zero;
+            Vector3 velocitySum = Vector3::Zero;
+
+            for (int j = 0; j < NEIGHBORS_COUNT; j++)
+            {
+                const TBoid& neighbor = boids[neighbors[i * NEIGHBORS_COUNT + j]];
+                positionSum += BoidQuantization::Decode(neighbor.position);
+                velocitySum += BoidQuantization::Decode(neighbor.velocity);
+            }
+
+            checksum += positionSum + velocitySum;
+        }
+
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return seconds * 1e9 / static_cast<double>(boids.size());
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const size_t boidsCount = argc > 1 ? static_cast<size_t>(std::atoll(argv[1])) : 1000000;
+
+    const Vector3 margin = BOUNDS_SIZE * OUT_OF_BOUNDS_MARGIN;
+    BoidQuantization::SetFrame(BOUNDS_MIN - margin, BOUNDS_SIZE + margin * 2.0f);
+
+    std::mt19937 engine(1);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+
+    std::vector<FullBoid> fullBoids(boidsCount);
+    std::vector<CompactBoid> compactBoids(boidsCount);
+
+    float maxPositionError = 0.0f;
+    float maxDirectionError = 0.0f;
+    float maxSpeedError = 0.0f;
+
+    for (size_t i = 0; i < boidsCount; i++)
+    {
+        Vector3 direction(normal(engine), normal(engine), normal(engine));
+        direction /= direction.Length();
+
+        FullBoid& boid = fullBoids[i];
+        boid.position = BOUNDS_MIN + Vector3(unit(engine), unit(engine), unit(engine)) * BOUNDS_SIZE;
+        boid.velocity = direction * (MIN_SPEED + (MAX_SPEED - MIN_SPEED) * unit(engine));
+
+        BoidQuantization::Encode(boid.position, compactBoids[i].position);
+        BoidQuantization::Encode(boid.velocity, compactBoids[i].velocity);
+
+        const Vector3 position = BoidQuantization::Decode(compactBoids[i].position);
+        const Vector3 velocity = BoidQuantization::Decode(compactBoids[i].velocity);
+        const float cosine = std::clamp(velocity.Dot(boid.velocity) / (velocity.Length() * boid.velocity.Length()), -1.0f, 1.0f);
+
+        maxPositionError = std::max(maxPositionError, (position - boid.position).Length());
+        maxDirectionError = std::max(maxDirectionError, std::acos(cosine) * RADIANS_TO_DEGREES);
+        maxSpeedError = std::max(maxSpeedError, std::abs(velocity.Length() - boid.velocity.Length()));
+    }
+
+    // Random neighbors are the worst case (every read a cache miss), nearby neighbors are what a cell sorted flock looks like
+    std::vector<uint32_t> randomNeighbors(boidsCount * NEIGHBORS_COUNT);
+    std::vector<uint32_t> nearbyNeighbors(boidsCount * NEIGHBORS_COUNT);
+    std::uniform_int_distribution<uint32_t> neighborIndex(0, static_cast<uint32_t>(boidsCount - 1));
+
+    for (size_t i = 0; i < randomNeighbors.size(); i++)
+    {
+        randomNeighbors[i] = neighborIndex(engine);
+        nearbyNeighbors[i] = static_cast<uint32_t>((i / NEIGHBORS_COUNT + i % NEIGHBORS_COUNT) % boidsCount);
+    }
+
+    Vector3 fullChecksum = Vector3::Zero;
+    Vector3 compactChecksum = Vector3::Zero;
+    const double fullRandomNanoseconds = MeasureGather(fullBoids, randomNeighbors, fullChecksum);
+    const double compactRandomNanoseconds = MeasureGather(compactBoids, randomNeighbors, compactChecksum);
+    const double fullNearbyNanoseconds = MeasureGather(fullBoids, nearbyNeighbors, fullChecksum);
+    const double compactNearbyNanoseconds = MeasureGather(compactBoids, nearbyNeighbors, compactChecksum);
+
+    std::cout << "boids: " << boidsCount << ", " << sizeof(FullBoid) << " -> " << sizeof(CompactBoid) << " bytes per boid state\n"
+              << "max position error: " << maxPositionError << "\n"
+              << "max direction error: " << maxDirectionError << " deg\n"
+              << "max speed error: " << maxSpeedError << "\n"
+              << "random gather of " << NEIGHBORS_COUNT << " neighbors, full: " << fullRandomNanoseconds << " ns/boid, compact: " << compactRandomNanoseconds << " ns/boid\n"
+              << "nearby gather of " << NEIGHBORS_COUNT << " neighbors, full: " << fullNearbyNanoseconds << " ns/boid, compact: " << compactNearbyNanoseconds << " ns/boid\n"
+              << "checksum difference: " << (fullChecksum - compactChecksum).Length() / static_cast<float>(boidsCount) << std::endl;
+    return 0;
+}
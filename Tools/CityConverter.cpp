@@ -0,0 +1,82 @@
+#include "pch.h"
+#include "CityFormat.h"
+#include "CityGenerator.h"
+#include "MappedFile.h"
+#include <iostream>
+
+/// Compiles a city into the binary city format loaded by City, either from the legacy json or generated.
+/// Usage: CityConverter <city.json> <city.bcity>
+///        CityConverter --generate <count> <seed> <density> <city.bcity>
+namespace
+{
+    bool LoadJson(const char* path, std::vector<Bounds>& skyscrapers)
+    {
+        MappedFile jsonFile;
+        if (!jsonFile.Open(path))
+        {
+            std::cerr << "Can't open " << path << std::endl;
+            return false;
+        }
+
+        if (!CityFormat::ParseJson(jsonFile.GetData(), jsonFile.GetSize(), skyscrapers))
+        {
+            std::cerr << "Invalid city json " << path << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    bool WriteCity(const char* path, const std::vector<Bounds>& skyscrapers)
+    {
+        std::vector<uint8_t> image;
+        CityFormat::Build(skyscrapers, image);
+
+        std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+        stream.write(reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(image.size()));
+        if (!stream)
+        {
+            std::cerr << "Can't write " << path << std::endl;
+            return false;
+        }
+
+        CityFormat::Header header;
+        std::memcpy(&header, image.data(), sizeof(header));
+        std::cout << "Skyscrapers: " << header.skyscrapersCount << ", grid: " << header.gridSizeX << " x " << header.gridSizeZ
+                  << " cells of " << header.cellSize << ", " << image.size() << " bytes" << std::endl;
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<Bounds> skyscrapers;
+    const char* outputPath = nullptr;
+
+    if (argc == 6 && std::string(argv[1]) == "--generate")
+    {
+        CityGeneratorSettings settings;
+        settings.skyscrapersCount = std::atoi(argv[2]);
+        settings.seed = static_cast<uint32_t>(std::strtoul(argv[3], nullptr, 10));
+        settings.density = static_cast<float>(std::atof(argv[4]));
+        CityGenerator::Generate(settings, skyscrapers);
+        outputPath = argv[5];
+    }
+    else if (argc == 3)
+    {
+        if (!LoadJson(argv[1], skyscrapers))
+        {
+            return 1;
+        }
+
+        outputPath = argv[2];
+    }
+    else
+    {
+        std::cerr << "Usage: CityConverter <city.json> <city.bcity>" << std::endl;
+        std::cerr << "       CityConverter --generate <count> <seed> <density> <city.bcity>" << std::endl;
+        return 1;
+    }
+
+    return WriteCity(outputPath, skyscrapers) ? 0 : 1;
+}
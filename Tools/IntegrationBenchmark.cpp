@@ -0,0 +1,120 @@
+#include "pch.h"
+#include "BoidManager.h"
+#include "SimulationBackend.h"
+#include <chrono>
+#include <iostream>
+
+/// Steering rate against trajectory quality for the integration settings (BoidIntegrationSettings).
+/// Boids seek targets circling the bounds, with steering evaluated once per step and held for its substeps like BoidManager does.
+/// Every setting is compared to a ground truth that steers and integrates at 480 Hz; the error is the RMS position deviation after DURATION.
+/// Usage: IntegrationBenchmark [boidsCount]
+namespace
+{
+    constexpr float DURATION = 5.0f;
+    constexpr float GROUND_TRUTH_STEP = 1.0f / 480.0f;
+    constexpr float STEERING_STEPS[] = { 1.0f / 60.0f, 1.0f / 30.0f, 1.0f / 15.0f, 1.0f / 10.0f };
+    constexpr int SUBSTEPS_COUNTS[] = { 1, 2, 4, 8 };
+
+    // Same values BoidManager uses
+    constexpr BoidSpeedLimits SPEED_LIMITS = { 6.5f, 10.5f };
+    constexpr float ACCELERATION_MULTIPLIER = 50.0f;
+    constexpr float TARGET_ORBIT_RADIUS = 15.0f;
+    constexpr float TARGET_ANGULAR_SPEED = 1.5f;
+
+    struct RunResult
+    {
+        std::vector<Vector3> positions;
+        double integrationNanosecondsPerBoid = 0.0; // Per step, all substeps included
+    };
+
+    // Cheap stand in for the flocking rules, what matters here is an acceleration that changes with position and velocity
+    void Steer(const std::vector<Boid*>& boids, float time)
+    {
+        for (size_t i = 0; i < boids.size(); i++)
+        {
+            const float phase = time * TARGET_ANGULAR_SPEED + static_cast<float>(i) * 0.1f;
+            const Vector3 target = Vector3(std::cos(phase), 0.5f * std::sin(phase * 2.0f), std::sin(phase)) * TARGET_ORBIT_RADIUS;
+
+            Boid& boid = *boids[i];
+            const Vector3 desiredVelocity = MathHelper::GetNormalized(target - boid.GetPosition()) * SPEED_LIMITS.max;
+            boid.SetAcceleration(MathHelper::GetNormalized(desiredVelocity - boid.GetVelocity()) * ACCELERATION_MULTIPLIER);
+        }
+    }
+
+    RunResult Run(const std::vector<Boid>& initialBoids, float stepTime, BoidIntegrationSettings integration)
+    {
+        std::vector<Boid> boids = initialBoids;
+        std::vector<Boid*> boidPointers;
+        for (Boid& boid : boids)
+        {
+            boidPointers.push_back(&boid);
+        }
+
+        std::unique_ptr<SimulationBackend> backend = SimulationBackend::Create(SimulationBackendType::Reference);
+        const int stepsCount = static_cast<int>(std::lround(DURATION / stepTime));
+        double integrationSeconds = 0.0;
+
+        for (int step = 0; step < stepsCount; step++)
+        {
+            Steer(boidPointers, static_cast<float>(step) * stepTime);
+
+            const auto start = std::chrono::steady_clock::now();
+            backend->Integrate(boidPointers, SPEED_LIMITS, integration, stepTime);
+            integrationSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        RunResult result;
+        for (const Boid& boid : boids)
+        {
+            result.positions.push_back(boid.GetPosition());
+        }
+
+        result.integrationNanosecondsPerBoid = integrationSeconds * 1e9 / (static_cast<double>(stepsCount) * boids.size());
+        return result;
+    }
+
+    float GetRmsDeviation(const std::vector<Vector3>& positions, const std::vector<Vector3>& reference)
+    {
+        double sum = 0.0;
+        for (size_t i = 0; i < positions.size(); i++)
+        {
+            sum += (positions[i] - reference[i]).LengthSquared();
+        }
+        return static_cast<float>(std::sqrt(sum / positions.size()));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const size_t boidsCount = argc > 1 ? static_cast<size_t>(std::atoll(argv[1])) : 2000;
+    MathHelper::GetRandomEngine().seed(1);
+
+    std::vector<Boid> initialBoids;
+    for (size_t i = 0; i < boidsCount; i++)
+    {
+        const Vector3 position = MathHelper::RandomDirection() * MathHelper::RandomFromRange(0.0f, 20.0f);
+        initialBoids.emplace_back(static_cast<uint32_t>(i), static_cast<FlockID>(0), MathHelper::RandomDirection() * SPEED_LIMITS.min, position);
+    }
+
+    const RunResult groundTruth = Run(initialBoids, GROUND_TRUTH_STEP, BoidIntegrationSettings{});
+
+    std::cout << "steering Hz | method | substeps | max substep move | RMS deviation | integration ns / boid / step" << std::endl;
+    for (float stepTime : STEERING_STEPS)
+    {
+        for (int method = 0; method < static_cast<int>(IntegrationMethod::Count); method++)
+        {
+            for (int substepsCount : SUBSTEPS_COUNTS)
+            {
+                const BoidIntegrationSettings integration{ static_cast<IntegrationMethod>(method), substepsCount };
+                const RunResult result = Run(initialBoids, stepTime, integration);
+
+                std::cout << std::lround(1.0f / stepTime) << " | " << GetIntegrationMethodName(integration.method) << " | " << substepsCount
+                    << " | " << SPEED_LIMITS.max * stepTime / substepsCount
+                    << " | " << GetRmsDeviation(result.positions, groundTruth.positions)
+                    << " | " << result.integrationNanosecondsPerBoid << std::endl;
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,243 @@
+#include "pch.h"
+#include "BoidManager.h"
+#include "BoidNeighborCache.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+
+/// Neighbor lookup cost with BoidNeighborCache at different skins against querying the hash grid for every boid every step.
+/// Boids wander through the default bounds at the default speeds, a batch is spawned halfway through, and every lookup is
+/// checked against the exact grid query, so a skin that misses neighbors shows up as mismatches.
+/// Usage: NeighborCacheBenchmark [boidsCount]
+namespace
+{
+    // Same values BoidManager and SimulationParameters use
+    const Vector3 BOUNDS_MIN = Vector3(-22.5f, 0.0f, -22.5f);
+    const Vector3 BOUNDS_SIZE = Vector3(45.0f, 35.0f, 45.0f);
+    constexpr float MIN_SPEED = 6.5f;
+    constexpr float MAX_SPEED = 10.5f;
+    constexpr float ACCELERATION = 50.0f;
+    constexpr float CELL_SIZE = 6.0f;
+    constexpr float RADIUS = 3.0f;
+    constexpr int FLOCKS_COUNT = 2;
+
+    constexpr float DURATION = 4.0f;
+    constexpr float STEP_TIMES[] = { 1.0f / 30.0f, 1.0f / 60.0f };
+    constexpr float SKINS[] = { 0.0f, 0.25f, 0.5f, 0.75f, 1.0f, 1.5f, 2.0f }; // 0 is no cache
+    constexpr int SPAWNED_COUNT = 500;
+
+    struct RunResult
+    {
+        double nanosecondsPerBoid = 0.0;
+        double rebuildFraction = 0.0;
+        size_t mismatchesCount = 0;
+    };
+
+    class Simulation
+    {
+    public:
+        Simulation(int boidsCount, float skin)
+            : m_grid(CELL_SIZE)
+            , m_cache(RADIUS)
+            , m_random(7)
+            , m_isCached(skin > 0.0f)
+        {
+            if (m_isCached)
+            {
+                m_cache.SetSkin(skin);
+            }
+
+            m_pool.Reserve(boidsCount + SPAWNED_COUNT);
+            for (int i = 0; i < boidsCount; i++)
+            {
+                Spawn();
+            }
+        }
+
+        ~Simulation()
+        {
+            m_pool.Clear();
+        }
+
+        RunResult Run(float stepTime)
+        {
+            RunResult result;
+            std::vector<Boid*> sameFlock;
+            std::vector<Boid*> otherFlocks;
+            std::vector<Boid*> exactSameFlock;
+            std::vector<Boid*> exactOtherFlocks;
+            double lookupSeconds = 0.0;
+            size_t lookupsCount = 0;
+
+            const int stepsCount = static_cast<int>(DURATION / stepTime);
+            for (int step = 0; step < stepsCount; step++)
+            {
+                if (step == stepsCount / 2)
+                {
+                    for (int i = 0; i < SPAWNED_COUNT; i++)
+                    {
+                        Spawn();
+                    }
+                }
+
+                for (Boid* boid : m_boids)
+                {
+                    m_grid.UpdateEntity(boid);
+                }
+
+                const auto begin = std::chrono::steady_clock::now();
+                if (m_isCached)
+                {
+                    m_cache.Update(m_boids, m_grid, m_pool);
+                    result.rebuildFraction += m_cache.GetLastRebuildFraction();
+                }
+
+                size_t neighborsCount = 0;
+                for (const Boid* boid : m_boids)
+                {
+                    FindNeighbors(*boid, sameFlock, otherFlocks);
+                    neighborsCount += sameFlock.size() + otherFlocks.size();
+                }
+                lookupSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+                lookupsCount += m_boids.size();
+
+                // Keeps the lookups from being optimized away, the check below isn't timed
+                m_checksum += neighborsCount;
+
+                if (m_isCached)
+                {
+                    for (const Boid* boid : m_boids)
+                    {
+                        FindNeighbors(*boid, sameFlock, otherFlocks);
+                        m_grid.QueryInRadius(boid->GetPosition(), RADIUS, boid->flockID, exactSameFlock, exactOtherFlocks);
+                        result.mismatchesCount += (sameFlock.size() != exactSameFlock.size() || otherFlocks.size() != exactOtherFlocks.size()) ? 1 : 0;
+                    }
+                }
+
+                Move(stepTime);
+            }
+
+            result.nanosecondsPerBoid = lookupSeconds * 1.0e9 / static_cast<double>(lookupsCount);
+            result.rebuildFraction /= stepsCount;
+            return result;
+        }
+
+        size_t GetChecksum() const { return m_checksum; }
+
+    private:
+        // Same filtering BoidSteeringController::GetBoidNeighbors does
+        void FindNeighbors(const Boid& boid, std::vector<Boid*>& sameFlock, std::vector<Boid*>& otherFlocks) const
+        {
+            size_t sameFlockCount = 0;
+            const std::vector<BoidNeighborCache::Candidate>* candidates = m_isCached ? m_cache.FindCandidates(boid, m_pool, sameFlockCount) : nullptr;
+
+            if (!candidates)
+            {
+                m_grid.QueryInRadius(boid.GetPosition(), RADIUS, boid.flockID, sameFlock, otherFlocks);
+                return;
+            }
+
+            sameFlock.clear();
+            otherFlocks.clear();
+            for (size_t i = 0; i < candidates->size(); i++)
+            {
+                const BoidNeighborCache::Candidate& candidate = (*candidates)[i];
+                if (m_pool.GetHandle(candidate.boid).generation == candidate.generation
+                    && (candidate.boid->GetPosition() - boid.GetPosition()).LengthSquared() < RADIUS * RADIUS)
+                {
+                    (i < sameFlockCount ? sameFlock : otherFlocks).push_back(candidate.boid);
+                }
+            }
+        }
+
+        void Spawn()
+        {
+            std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+            const Vector3 position = BOUNDS_MIN + Vector3(unit(m_random), unit(m_random), unit(m_random)) * BOUNDS_SIZE;
+            const Vector3 velocity = MathHelper::GetNormalized(Vector3(unit(m_random), unit(m_random), unit(m_random)) - Vector3::One * 0.5f) * MIN_SPEED;
+
+            m_boids.push_back(m_pool.Create(static_cast<uint32_t>(m_boids.size()), static_cast<FlockID>(m_boids.size() % FLOCKS_COUNT), velocity, position));
+            m_grid.AddEntity(m_boids.back());
+
+            if (m_isCached)
+            {
+                m_cache.OnBoidAdded(m_boids.back()->GetPosition(), m_grid, m_pool);
+            }
+        }
+
+        // Wandering with the acceleration and speed limits of the real steering, bouncing off the bounds
+        void Move(float stepTime)
+        {
+            std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+            const Vector3 boundsMax = BOUNDS_MIN + BOUNDS_SIZE;
+
+            for (Boid* boid : m_boids)
+            {
+                Vector3 velocity = boid->GetVelocity() + Vector3(unit(m_random), unit(m_random), unit(m_random)) * (ACCELERATION * stepTime);
+                velocity = MathHelper::GetNormalized(velocity) * std::clamp(velocity.Length(), MIN_SPEED, MAX_SPEED);
+                Vector3 position = boid->GetPosition() + velocity * stepTime;
+
+                for (float Vector3::* axis : { &Vector3::x, &Vector3::y, &Vector3::z })
+                {
+                    if (position.*axis < BOUNDS_MIN.*axis || position.*axis > boundsMax.*axis)
+                    {
+                        velocity.*axis = -(velocity.*axis);
+                        position.*axis = std::clamp(position.*axis, BOUNDS_MIN.*axis, boundsMax.*axis);
+                    }
+                }
+
+                boid->SetVelocity(velocity);
+                boid->SetPosition(position);
+            }
+
+            if (m_isCached)
+            {
+                m_cache.AddMaxDisplacement(MAX_SPEED * stepTime);
+            }
+        }
+
+        ObjectPool<Boid> m_pool;
+        SpatialHashGrid<Boid> m_grid;
+        BoidNeighborCache m_cache;
+        std::vector<Boid*> m_boids;
+        std::mt19937 m_random;
+        bool m_isCached;
+        size_t m_checksum = 0;
+    };
+}
+
+int main(int argc, char** argv)
+{
+    const int boidsCount = argc > 1 ? std::atoi(argv[1]) : 20000;
+    size_t checksum = 0;
+
+    std::cout << boidsCount << " boids, radius " << RADIUS << ", cell size " << CELL_SIZE << ", " << SPAWNED_COUNT << " spawned halfway" << std::endl;
+
+    for (float stepTime : STEP_TIMES)
+    {
+        // What BoidManager would pick for this step and density
+        BoidNeighborCache configured(RADIUS);
+        configured.Configure(MAX_SPEED * stepTime, static_cast<float>(boidsCount) / (BOUNDS_SIZE.x * BOUNDS_SIZE.y * BOUNDS_SIZE.z));
+        std::cout << static_cast<int>(std::lround(1.0f / stepTime)) << " Hz, configured skin " << configured.GetSkin()
+                  << (configured.IsEnabled() ? ", lists on" : ", lists off") << std::endl;
+
+        for (float skin : SKINS)
+        {
+            Simulation simulation(boidsCount, skin);
+            const RunResult result = simulation.Run(stepTime);
+            checksum += simulation.GetChecksum();
+
+            if (skin == 0.0f)
+            {
+                std::cout << "  grid query every step: " << result.nanosecondsPerBoid << " ns per boid" << std::endl;
+            }
+            else
+            {
+                std::cout << "  skin " << skin << ": " << result.nanosecondsPerBoid << " ns per boid, " << result.rebuildFraction * 100.0 << "% rebuilt per step, "
+                          << result.mismatchesCount << " mismatched lookups" << std::endl;
+            }
+        }
+    }
+
+    return checksum == 0 ? 1 : 0;
+}
@@ -0,0 +1,112 @@
+#include "pch.h"
+#include "MathHelper.h"
+#include <chrono>
+#include <iostream>
+
+/// Accuracy and throughput of the fast normalization paths in MathHelper against the exact ones.
+/// Usage: NormalizationBenchmark [vectorsCount]
+namespace
+{
+    constexpr int REPEATS = 20;
+    constexpr float CONE_COS_HALF_ANGLE = -0.6427876f; // cos(130 deg), the boids field of view
+
+    // Vectors the size of neighbor offsets and velocities, plus a few zero ones
+    std::vector<Vector3> CreateVectors(size_t count)
+    {
+        std::vector<Vector3> vectors(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            vectors[i] = i % 1024 == 0 ? Vector3::Zero : MathHelper::RandomDirection() * MathHelper::RandomFromRange(0.001f, 12.0f);
+        }
+        return vectors;
+    }
+
+    template<typename TFunction>
+    double MeasureNanoseconds(size_t count, TFunction&& function)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < REPEATS; i++)
+        {
+            function();
+        }
+
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return seconds * 1e9 / static_cast<double>(count * REPEATS);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const size_t vectorsCount = argc > 1 ? static_cast<size_t>(std::atoll(argv[1])) : 1 << 20;
+    MathHelper::GetRandomEngine().seed(1);
+
+    const std::vector<Vector3> vectors = CreateVectors(vectorsCount);
+    std::vector<Vector3> exact(vectorsCount);
+    std::vector<Vector3> fast(vectorsCount);
+
+    // Relative error of the reciprocal square root over the whole range steering feeds it
+    double maxInverseSqrtError = 0.0;
+    for (float value = 1e-6f; value < 1e4f; value *= 1.0001f)
+    {
+        const double reference = 1.0 / std::sqrt(static_cast<double>(value));
+        maxInverseSqrtError = std::max(maxInverseSqrtError, std::abs(MathHelper::InverseSqrtFast(value) - reference) / reference);
+    }
+
+    MathHelper::GetNormalized(vectors.data(), exact.data(), vectorsCount);
+    MathHelper::GetNormalizedFast(vectors.data(), fast.data(), vectorsCount);
+
+    float maxNormalizedError = 0.0f;
+    size_t coneMismatches = 0;
+    for (size_t i = 0; i < vectorsCount; i++)
+    {
+        maxNormalizedError = std::max(maxNormalizedError, (exact[i] - fast[i]).Length());
+        maxNormalizedError = std::max(maxNormalizedError, (exact[i] - MathHelper::GetNormalizedFast(vectors[i])).Length());
+
+        const Vector3& direction = exact[(i + 1) % vectorsCount];
+        const bool withinCone = direction.Dot(exact[i]) >= CONE_COS_HALF_ANGLE;
+        coneMismatches += withinCone != MathHelper::IsWithinCone(direction, vectors[i], CONE_COS_HALF_ANGLE) ? 1 : 0;
+    }
+
+    Vector3 checksum = Vector3::Zero;
+    size_t coneCount = 0;
+    const double exactNanoseconds = MeasureNanoseconds(vectorsCount, [&]
+    {
+        for (const Vector3& vector : vectors)
+        {
+            checksum += MathHelper::GetNormalized(vector);
+        }
+    });
+    const double fastNanoseconds = MeasureNanoseconds(vectorsCount, [&]
+    {
+        for (const Vector3& vector : vectors)
+        {
+            checksum += MathHelper::GetNormalizedFast(vector);
+        }
+    });
+    const double exactBatchNanoseconds = MeasureNanoseconds(vectorsCount, [&] { MathHelper::GetNormalized(vectors.data(), exact.data(), vectorsCount); });
+    const double fastBatchNanoseconds = MeasureNanoseconds(vectorsCount, [&] { MathHelper::GetNormalizedFast(vectors.data(), fast.data(), vectorsCount); });
+    const double normalizedConeNanoseconds = MeasureNanoseconds(vectorsCount, [&]
+    {
+        for (size_t i = 0; i < vectorsCount; i++)
+        {
+            coneCount += exact[i].Dot(MathHelper::GetNormalized(vectors[(i + 1) % vectorsCount])) >= CONE_COS_HALF_ANGLE ? 1 : 0;
+        }
+    });
+    const double coneNanoseconds = MeasureNanoseconds(vectorsCount, [&]
+    {
+        for (size_t i = 0; i < vectorsCount; i++)
+        {
+            coneCount += MathHelper::IsWithinCone(exact[i], vectors[(i + 1) % vectorsCount], CONE_COS_HALF_ANGLE) ? 1 : 0;
+        }
+    });
+
+    std::cout << "vectors: " << vectorsCount << "\n"
+              << "max InverseSqrtFast relative error: " << maxInverseSqrtError << "\n"
+              << "max GetNormalizedFast error: " << maxNormalizedError << "\n"
+              << "IsWithinCone mismatches: " << coneMismatches << "\n"
+              << "GetNormalized: " << exactNanoseconds << " ns, GetNormalizedFast: " << fastNanoseconds << " ns\n"
+              << "batched GetNormalized: " << exactBatchNanoseconds << " ns, batched GetNormalizedFast: " << fastBatchNanoseconds << " ns\n"
+              << "normalize and dot: " << normalizedConeNanoseconds << " ns, IsWithinCone: " << coneNanoseconds << " ns\n"
+              << "checksum: " << checksum.x + checksum.y + checksum.z + static_cast<float>(coneCount) << std::endl;
+    return 0;
+}
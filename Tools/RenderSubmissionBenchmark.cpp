@@ -0,0 +1,134 @@
+#include "pch.h"
+#include "RenderInstanceBuffer.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+
+/// Render submission cost of boids: one primitive per boid (what the renderer did before RenderInstanceBuffer)
+/// against packing the frame into a RenderInstanceBuffer and submitting one instanced draw per flock.
+/// Both paths go to counting contexts, so this measures the CPU side (packing, calls, bytes) without a window or GPU.
+/// Usage: RenderSubmissionBenchmark [boidsCount] [flocksCount]
+namespace
+{
+    constexpr int FRAMES_COUNT = 200;
+    const Vector3 BOUNDS_SIZE = Vector3(45.0f, 35.0f, 45.0f);
+
+    // Counts what reaches the framework when every boid is its own primitive
+    class CountingRenderContext : public framework::IRenderContext
+    {
+    public:
+        void RenderPrimitive(const std::unique_ptr<DirectX::GeometricPrimitive>& primitive, Vector3 scale, Vector3 position, Vector3 rotation, XMVECTOR color) override
+        {
+            UNREFERENCED_PARAMETER(primitive);
+            UNREFERENCED_PARAMETER(scale);
+            UNREFERENCED_PARAMETER(rotation);
+            UNREFERENCED_PARAMETER(color);
+
+            ++drawCallsCount;
+            checksum += position.x;
+        }
+
+        void RenderText(const std::string& text, Vector2 position, float scale) override
+        {
+            UNREFERENCED_PARAMETER(text);
+            UNREFERENCED_PARAMETER(position);
+            UNREFERENCED_PARAMETER(scale);
+        }
+
+        int drawCallsCount = 0;
+        float checksum = 0.0f;
+    };
+
+    struct BenchmarkBoid
+    {
+        Vector3 position;
+        uint16_t flockID;
+    };
+
+    double GetMicroseconds(std::chrono::steady_clock::time_point begin)
+    {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int boidsCount = argc > 1 ? std::atoi(argv[1]) : 20000;
+    const int flocksCount = argc > 2 ? std::atoi(argv[2]) : 4;
+
+    if (boidsCount <= 0 || flocksCount <= 0)
+    {
+        std::cerr << "Usage: RenderSubmissionBenchmark [boidsCount] [flocksCount]" << std::endl;
+        return 1;
+    }
+
+    // Flocks interleaved like in BoidManager, where boids are ordered by id and not by flock
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<BenchmarkBoid> boids(boidsCount);
+    for (int i = 0; i < boidsCount; i++)
+    {
+        boids[i].position = Vector3(unit(random), unit(random), unit(random)) * BOUNDS_SIZE;
+        boids[i].flockID = static_cast<uint16_t>(random() % flocksCount);
+    }
+
+    const std::unique_ptr<DirectX::GeometricPrimitive> shape;
+    const std::vector<XMVECTOR> palette(flocksCount);
+
+    // Through the same shared pointer the framework hands out, so the calls stay virtual
+    const std::shared_ptr<CountingRenderContext> primitiveCounts = std::make_shared<CountingRenderContext>();
+    const framework::RenderContextPtr primitiveContext = primitiveCounts;
+    const auto primitiveBegin = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < FRAMES_COUNT; frame++)
+    {
+        for (const BenchmarkBoid& boid : boids)
+        {
+            primitiveContext->RenderPrimitive(shape, Vector3::One, boid.position, Vector3::Zero, palette[boid.flockID]);
+        }
+    }
+    const double primitiveMicroseconds = GetMicroseconds(primitiveBegin) / FRAMES_COUNT;
+
+    RenderInstanceBuffer instances;
+    HeadlessInstancedRenderContext instancedContext;
+    double packingMicroseconds = 0.0;
+    double submissionMicroseconds = 0.0;
+
+    for (int frame = 0; frame < FRAMES_COUNT; frame++)
+    {
+        // Same two passes BoidManager::OnRender does
+        const auto packingBegin = std::chrono::steady_clock::now();
+        instances.Begin(flocksCount);
+        for (const BenchmarkBoid& boid : boids)
+        {
+            instances.CountInstance(boid.flockID);
+        }
+
+        instances.Allocate();
+        for (const BenchmarkBoid& boid : boids)
+        {
+            instances.AddInstance(boid.flockID, boid.position, boid.flockID);
+        }
+        packingMicroseconds += GetMicroseconds(packingBegin);
+
+        const auto submissionBegin = std::chrono::steady_clock::now();
+        instancedContext.ResetStats();
+        for (int i = 0; i < instances.GetBatchesCount(); i++)
+        {
+            if (instances.GetBatchSize(i) > 0)
+            {
+                instancedContext.RenderPrimitiveInstanced(shape, Vector3::One, instances.GetBatchInstances(i), instances.GetBatchSize(i), palette.data());
+            }
+        }
+        submissionMicroseconds += GetMicroseconds(submissionBegin);
+    }
+
+    std::cout << boidsCount << " boids, " << flocksCount << " flocks, average of " << FRAMES_COUNT << " frames" << std::endl;
+    std::cout << "per primitive: " << primitiveCounts->drawCallsCount / FRAMES_COUNT << " draw calls, "
+        << primitiveMicroseconds << " us submission" << std::endl;
+    std::cout << "instanced:     " << instancedContext.GetDrawCallsCount() << " draw calls, "
+        << packingMicroseconds / FRAMES_COUNT << " us packing, " << submissionMicroseconds / FRAMES_COUNT << " us submission, "
+        << instancedContext.GetSubmittedBytes() / 1024 << " KiB instance data" << std::endl;
+
+    // Keeps the per primitive loop from being optimized away
+    return primitiveCounts->checksum == -1.0f ? 1 : 0;
+}
@@ -0,0 +1,28 @@
+#!/bin/sh
+# Local multi-process run: starts one game process per slab on the same scenario and waits for all of them.
+# Usage: RunDistributed.sh <game executable> [ranks, default 4] [scenario, default distributed.scenario next to this script]
+GAME=$1
+RANKS=${2:-4}
+SCENARIO=${3:-$(dirname "$0")/distributed.scenario}
+
+if [ -z "$GAME" ]; then
+    echo "Usage: $0 <game executable> [ranks] [scenario]" >&2
+    exit 1
+fi
+
+SOCKET_DIR=$(mktemp -d)
+PIDS=""
+
+for RANK in $(seq 0 $((RANKS - 1))); do
+    BOIDS_SCENARIO="$SCENARIO" BOIDS_SLAB="$RANK/$RANKS" BOIDS_SLAB_SOCKET_DIR="$SOCKET_DIR" "$GAME" &
+    PIDS="$PIDS $!"
+done
+
+STATUS=0
+for PID in $PIDS; do
+    wait "$PID" || STATUS=1
+done
+
+rm -rf "$SOCKET_DIR"
+awk '/^owned boids:/ { total += $3 } END { print "total owned boids: " total }' "$SCENARIO".slab*.report
+exit $STATUS
@@ -0,0 +1,112 @@
+#include "pch.h"
+#include "MathHelper.h"
+#include "SharedStatePublisher.h"
+#include "SharedStateReader.h"
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+/// Cost of publishing a frame into shared memory, alone and while a reader keeps scanning the latest frame on another thread.
+/// Every frame the reader accepts is checked for tearing, all of its boids have to carry the same frame marker.
+/// Usage: SharedStateBenchmark [boidsCount] [framesCount]
+namespace
+{
+    constexpr const char* BENCHMARK_REGION_NAME = "boids-state-benchmark";
+    constexpr uint32_t PROJECTILES_COUNT = 64;
+
+    double PublishFrames(SharedStatePublisher& publisher, const std::vector<Vector3>& positions, const std::vector<Vector3>& velocities, int framesCount)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (int frameIndex = 0; frameIndex < framesCount; frameIndex++)
+        {
+            SharedStateFrame& frame = publisher.BeginFrame(static_cast<float>(frameIndex));
+            const uint32_t count = static_cast<uint32_t>(positions.size());
+            for (uint32_t i = 0; i < count; i++)
+            {
+                frame.boidPositions[i] = positions[i];
+                frame.boidVelocities[i] = velocities[i];
+                frame.boidFlockIDs[i] = static_cast<uint16_t>(frameIndex); // Frame marker for the tearing check
+            }
+
+            for (uint32_t i = 0; i < PROJECTILES_COUNT; i++)
+            {
+                frame.projectilePositions[i] = positions[i];
+                frame.projectileVelocities[i] = velocities[i];
+                frame.projectilePredators[i] = i & 1;
+            }
+
+            frame.boidsCount = count;
+            frame.projectilesCount = PROJECTILES_COUNT;
+            publisher.EndFrame();
+        }
+
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return seconds * 1e3 / framesCount;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const uint32_t boidsCount = argc > 1 ? static_cast<uint32_t>(std::atoi(argv[1])) : 100000;
+    const int framesCount = argc > 2 ? std::atoi(argv[2]) : 500;
+
+    std::vector<Vector3> positions(boidsCount);
+    std::vector<Vector3> velocities(boidsCount);
+    for (uint32_t i = 0; i < boidsCount; i++)
+    {
+        positions[i] = MathHelper::RandomDirection() * MathHelper::RandomFromRange(0.0f, 100.0f);
+        velocities[i] = MathHelper::RandomDirection() * MathHelper::RandomFromRange(2.0f, 10.0f);
+    }
+
+    SharedStatePublisher publisher;
+    if (!publisher.Create(BENCHMARK_REGION_NAME, boidsCount, PROJECTILES_COUNT))
+    {
+        std::cerr << "Failed to create shared state" << std::endl;
+        return 1;
+    }
+
+    const double aloneMilliseconds = PublishFrames(publisher, positions, velocities, framesCount);
+
+    SharedStateReader reader;
+    if (!reader.Open(BENCHMARK_REGION_NAME))
+    {
+        std::cerr << "Failed to open shared state" << std::endl;
+        return 1;
+    }
+
+    std::atomic<bool> isPublishing{ true };
+    uint64_t framesRead = 0;
+    uint64_t inconsistentFrames = 0;
+    std::thread readerThread([&]()
+    {
+        while (isPublishing.load(std::memory_order_relaxed))
+        {
+            bool isConsistent = true;
+            const bool read = reader.VisitLatestFrame([&isConsistent](const SharedStateFrame& frame)
+            {
+                isConsistent = true;
+                for (uint32_t i = 1; i < frame.boidsCount; i++)
+                {
+                    isConsistent &= frame.boidFlockIDs[i] == frame.boidFlockIDs[0];
+                }
+            });
+
+            if (read)
+            {
+                framesRead++;
+                inconsistentFrames += isConsistent ? 0 : 1;
+            }
+        }
+    });
+
+    const double contendedMilliseconds = PublishFrames(publisher, positions, velocities, framesCount);
+    isPublishing = false;
+    readerThread.join();
+
+    const double megabytes = static_cast<double>(SharedState::GetSlotLayout(boidsCount, PROJECTILES_COUNT).size) / (1 << 20);
+    std::cout << boidsCount << " boids, " << megabytes << " MB per frame" << std::endl;
+    std::cout << "publish alone       " << aloneMilliseconds << " ms / frame" << std::endl;
+    std::cout << "publish with reader " << contendedMilliseconds << " ms / frame" << std::endl;
+    std::cout << "reader frames " << framesRead << ", torn retries " << reader.GetTornReadsCount() << ", inconsistent accepted " << inconsistentFrames << std::endl;
+    return inconsistentFrames == 0 ? 0 : 1;
+}
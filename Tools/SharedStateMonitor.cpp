@@ -0,0 +1,68 @@
+#include "pch.h"
+#include "SharedStateReader.h"
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+/// Example external reader, attaches to a simulation started with BOIDS_SHARED_STATE=<name> and prints a summary of the latest frame.
+/// Usage: SharedStateMonitor [name] [intervalMilliseconds]
+namespace
+{
+    struct FrameSummary
+    {
+        uint64_t frameIndex = 0;
+        float simulationTime = 0.0f;
+        uint32_t boidsCount = 0;
+        uint32_t projectilesCount = 0;
+        Vector3 centroid = Vector3::Zero;
+        float averageSpeed = 0.0f;
+    };
+}
+
+int main(int argc, char** argv)
+{
+    const std::string name = argc > 1 ? argv[1] : SharedState::DEFAULT_NAME;
+    const int intervalMilliseconds = argc > 2 ? std::atoi(argv[2]) : 500;
+
+    SharedStateReader reader;
+    while (!reader.Open(name))
+    {
+        std::cerr << "Waiting for shared state " << name << std::endl;
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+    }
+
+    uint64_t lastFrameIndex = std::numeric_limits<uint64_t>::max();
+    for (;;)
+    {
+        // Reads straight from the shared memory, the summary is rebuilt from scratch if the frame got overwritten meanwhile
+        FrameSummary summary;
+        const bool read = reader.VisitLatestFrame([&summary](const SharedStateFrame& frame)
+        {
+            summary = FrameSummary{ frame.frameIndex, frame.simulationTime, frame.boidsCount, frame.projectilesCount };
+
+            double speedSum = 0.0;
+            for (uint32_t i = 0; i < frame.boidsCount; i++)
+            {
+                summary.centroid += frame.boidPositions[i];
+                speedSum += frame.boidVelocities[i].Length();
+            }
+
+            if (frame.boidsCount > 0)
+            {
+                summary.centroid /= static_cast<float>(frame.boidsCount);
+                summary.averageSpeed = static_cast<float>(speedSum / frame.boidsCount);
+            }
+        });
+
+        if (read && summary.frameIndex != lastFrameIndex)
+        {
+            lastFrameIndex = summary.frameIndex;
+            std::cout << "frame " << summary.frameIndex << " t " << summary.simulationTime
+                << " boids " << summary.boidsCount << " projectiles " << summary.projectilesCount
+                << " centroid " << summary.centroid.x << " " << summary.centroid.y << " " << summary.centroid.z
+                << " speed " << summary.averageSpeed << " torn " << reader.GetTornReadsCount() << std::endl;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(intervalMilliseconds));
+    }
+}